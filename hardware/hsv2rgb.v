@@ -0,0 +1,144 @@
+module hsv2rgb (
+
+	/******************************************************************/
+	/* Port declarations							                  */
+	/******************************************************************/
+
+	input					clk,
+	input					reset,			// active-high
+	input					start,			// convert hue, sat and val
+	input		[8:0]		hue,			// 0 - 359, 360 - 511 wrap once
+	input		[6:0]		sat,			// 0 - 100, larger is 100
+	input		[6:0]		val,			// 0 - 100, larger is 100
+
+	output reg	[7:0]		red,
+	output reg	[7:0]		green,
+	output reg	[7:0]		blue,
+	output reg				done,			// red, green and blue are new
+	output					busy);			// a conversion is in flight
+
+	/******************************************************************/
+	/* Description									                  */
+	/******************************************************************/
+
+	// Fixed point HSV to RGB, bit for bit the same as HSVtoRGB() in the
+	// firmware (functional_interface.c), so the two can be swapped:
+	//
+	//   v = val * 653 >> 8                s = sat * 653 >> 8
+	//   region = hue * 1093 >> 16         rem = (hue - 60 region) * 1105 >> 8
+	//   p = v (255 - s) / 255
+	//   q = v (255 - s rem / 255) / 255
+	//   t = v (255 - s (255 - rem) / 255) / 255
+	//
+	// where / 255 is DIV255(), (x + 1 + (x >> 8)) >> 8, exact for the 16 bit
+	// products here.  One multiply per path per stage, so it closes at the
+	// AXI clock without help.  The result is in the output registers
+	// LATENCY clocks after start, whatever the input, and done pulses with
+	// it.  A start every clock is fine.
+
+	/******************************************************************/
+	/* Local parameters and values		                  	  		  */
+	/******************************************************************/
+
+	localparam integer	LATENCY = 6;			// start to done, clocks
+
+	reg			[LATENCY-2:0]	valid;			// stage 1 - 5 hold a conversion
+
+	// stage 1: clamped inputs
+	reg			[8:0]		hue1;
+	reg			[6:0]		sat1, val1;
+	// stage 2: scaled to 0 - 255 and the sextant
+	reg			[8:0]		hue2;
+	reg			[7:0]		s2, v2;
+	reg			[2:0]		region2;
+	// stage 3: remainder in the sextant and p
+	reg			[7:0]		s3, v3, rem3, p3;
+	reg			[2:0]		region3;
+	// stage 4: s rem and s (255 - rem)
+	reg			[7:0]		v4, p4, srem4, srem_n4;
+	reg			[2:0]		region4;
+	// stage 5: q and t
+	reg			[7:0]		v5, p5, q5, t5;
+	reg			[2:0]		region5;
+
+	assign busy = start | (|valid);
+
+	// DIV255(a * b)
+	function [7:0] mul_div255;
+		input	[7:0]	a, b;
+		reg		[15:0]	x;
+		reg		[16:0]	y;
+		begin
+			x = a * b;
+			y = x + 17'd1 + x[15:8];
+			mul_div255 = y[15:8];
+		end
+	endfunction
+
+	/******************************************************************/
+	/* Pipeline										                  */
+	/******************************************************************/
+
+	always@(posedge clk) begin
+
+		if (reset) begin
+			valid <= 0;
+			done <= 1'b0;
+			red <= 8'b0;
+			green <= 8'b0;
+			blue <= 8'b0;
+		end
+
+		else
+		begin
+			valid <= {valid[LATENCY-3:0], start};
+			done <= valid[LATENCY-2];
+
+			// 1: clamp, the firmware only ever passes values in range
+			hue1 <= (hue >= 9'd360) ? hue - 9'd360 : hue;
+			sat1 <= (sat > 7'd100) ? 7'd100 : sat;
+			val1 <= (val > 7'd100) ? 7'd100 : val;
+
+			// 2: 0 - 100 to 0 - 255, hue / 60
+			hue2 <= hue1;
+			s2 <= (sat1 * 16'd653) >> 8;
+			v2 <= (val1 * 16'd653) >> 8;
+			region2 <= (hue1 * 19'd1093) >> 16;
+
+			// 3
+			s3 <= s2;
+			v3 <= v2;
+			region3 <= region2;
+			rem3 <= ((hue2 - region2 * 6'd60) * 16'd1105) >> 8;
+			p3 <= mul_div255(v2, 8'd255 - s2);
+
+			// 4
+			v4 <= v3;
+			p4 <= p3;
+			region4 <= region3;
+			srem4 <= mul_div255(s3, rem3);
+			srem_n4 <= mul_div255(s3, 8'd255 - rem3);
+
+			// 5
+			v5 <= v4;
+			p5 <= p4;
+			region5 <= region4;
+			q5 <= mul_div255(v4, 8'd255 - srem4);
+			t5 <= mul_div255(v4, 8'd255 - srem_n4);
+
+			// 6: pick by sextant
+			if (valid[LATENCY-2]) begin
+				case (region5)
+				3'd0:		{red, green, blue} <= {v5, t5, p5};
+				3'd1:		{red, green, blue} <= {q5, v5, p5};
+				3'd2:		{red, green, blue} <= {p5, v5, t5};
+				3'd3:		{red, green, blue} <= {p5, q5, v5};
+				3'd4:		{red, green, blue} <= {t5, p5, v5};
+				default:	{red, green, blue} <= {v5, p5, q5};
+				endcase
+			end
+		end
+
+	end
+
+endmodule
@@ -0,0 +1,219 @@
+module hsv_pwm_axi #(
+
+	/******************************************************************/
+	/* Parameter declarations						                  */
+	/******************************************************************/
+
+	parameter integer	PWM_DIV_DEFAULT = 12500,	// clocks per PWM step, 64 ms period at 100MHz
+	parameter integer	C_S_AXI_ADDR_WIDTH = 12)	// 4KB register window
+
+	/******************************************************************/
+	/* Port declarations							                  */
+	/******************************************************************/
+
+	(
+	// AXI4-Lite slave, exported from the embedded system
+	input						s_axi_aclk,
+	input						s_axi_aresetn,
+	input	[C_S_AXI_ADDR_WIDTH-1:0]	s_axi_awaddr,
+	input						s_axi_awvalid,
+	output reg					s_axi_awready,
+	input	[31:0]				s_axi_wdata,
+	input	[3:0]				s_axi_wstrb,
+	input						s_axi_wvalid,
+	output reg					s_axi_wready,
+	output	[1:0]				s_axi_bresp,
+	output reg					s_axi_bvalid,
+	input						s_axi_bready,
+	input	[C_S_AXI_ADDR_WIDTH-1:0]	s_axi_araddr,
+	input						s_axi_arvalid,
+	output reg					s_axi_arready,
+	output reg	[31:0]			s_axi_rdata,
+	output	[1:0]				s_axi_rresp,
+	output reg					s_axi_rvalid,
+	input						s_axi_rready,
+
+	output reg					rgb_enable,		// drive the RGB LEDs from here, not Nexys4IO
+	output reg					pwm_red,		// same for RGB1 and RGB2
+	output reg					pwm_green,
+	output reg					pwm_blue);
+
+	/******************************************************************/
+	/* Description									                  */
+	/******************************************************************/
+
+	// HSV color register in front of hsv2rgb and three PWM generators, so
+	// a color change is one AXI write.  Register map (32-bit words):
+	//
+	//   0x0  HSV       RW: bits 8:0 hue, 22:16 sat, 30:24 val, bit 31 enable
+	//   0x4  RGB       R: 0x00RRGGBB the PWM generators are given
+	//   0x8  PWM_DIV   RW: clocks per PWM step, 512 steps per period
+	//
+	// A write to HSV starts a conversion.  R, G and B reach the generators
+	// a fixed hsv2rgb LATENCY + 1 clocks later and go out from the start of
+	// the next PWM period, so there is never a short or long pulse.  Reads
+	// are held off while a conversion is in flight, so reading RGB right
+	// after writing HSV returns the new color.
+	//
+	// A duty of d is high for d of the 512 steps, at most 255/512, the same
+	// half scale Nexys4IO uses, so calc_duty() in the firmware reads both
+	// the same.  Enable switches the LED pins over in n4fpga.v; the
+	// generators run either way.
+
+	/******************************************************************/
+	/* Local parameters and values		                  	  		  */
+	/******************************************************************/
+
+	localparam [3:0]	REG_HSV = 4'h0,
+						REG_RGB = 4'h4,
+						REG_PWM_DIV = 4'h8;
+
+	wire							reset = ~s_axi_aresetn;
+
+	reg			[31:0]				hsv;
+	reg								convert;
+	wire		[7:0]				red, green, blue;
+	wire							conv_busy;
+	reg			[31:0]				pwm_div;
+	reg			[31:0]				div_count;
+	reg			[8:0]				step;
+	reg			[7:0]				duty_r, duty_g, duty_b;
+
+	assign s_axi_bresp = 2'b00;
+	assign s_axi_rresp = 2'b00;
+
+	/******************************************************************/
+	/* AXI write channel							                  */
+	/******************************************************************/
+
+	// Address and data are accepted together, one write at a time
+	always@(posedge s_axi_aclk) begin
+
+		convert <= 1'b0;
+
+		if (reset) begin
+			s_axi_awready <= 1'b0;
+			s_axi_wready <= 1'b0;
+			s_axi_bvalid <= 1'b0;
+			hsv <= 32'b0;
+			rgb_enable <= 1'b0;
+			pwm_div <= PWM_DIV_DEFAULT;
+		end
+
+		else
+		begin
+			s_axi_awready <= 1'b0;
+			s_axi_wready <= 1'b0;
+
+			if (s_axi_awvalid && s_axi_wvalid && !s_axi_awready && !s_axi_bvalid) begin
+				s_axi_awready <= 1'b1;
+				s_axi_wready <= 1'b1;
+				s_axi_bvalid <= 1'b1;
+
+				case (s_axi_awaddr[3:0])
+				REG_HSV: begin
+					hsv <= s_axi_wdata;
+					rgb_enable <= s_axi_wdata[31];
+					convert <= 1'b1;
+				end
+				REG_PWM_DIV:
+					pwm_div <= (s_axi_wdata == 0) ? 32'd1 : s_axi_wdata;
+				default:
+					;
+				endcase
+			end
+			else if (s_axi_bvalid && s_axi_bready) begin
+				s_axi_bvalid <= 1'b0;
+			end
+		end
+
+	end
+
+	/******************************************************************/
+	/* AXI read channel								                  */
+	/******************************************************************/
+
+	always@(posedge s_axi_aclk) begin
+
+		if (reset) begin
+			s_axi_arready <= 1'b0;
+			s_axi_rvalid <= 1'b0;
+			s_axi_rdata <= 32'b0;
+		end
+
+		else
+		begin
+			s_axi_arready <= 1'b0;
+
+			if (s_axi_arvalid && !s_axi_arready && !s_axi_rvalid && !conv_busy) begin
+				s_axi_arready <= 1'b1;
+				s_axi_rvalid <= 1'b1;
+				case (s_axi_araddr[3:0])
+				REG_HSV:		s_axi_rdata <= hsv;
+				REG_RGB:		s_axi_rdata <= {8'b0, red, green, blue};
+				REG_PWM_DIV:	s_axi_rdata <= pwm_div;
+				default:		s_axi_rdata <= 32'b0;
+				endcase
+			end
+			else if (s_axi_rvalid && s_axi_rready) begin
+				s_axi_rvalid <= 1'b0;
+			end
+		end
+
+	end
+
+	/******************************************************************/
+	/* Converter and PWM generators					                  */
+	/******************************************************************/
+
+	hsv2rgb converter (
+		.clk(s_axi_aclk),
+		.reset(reset),
+		.start(convert),
+		.hue(hsv[8:0]),
+		.sat(hsv[22:16]),
+		.val(hsv[30:24]),
+		.red(red),
+		.green(green),
+		.blue(blue),
+		.done(),
+		.busy(conv_busy)
+		);
+
+	always@(posedge s_axi_aclk) begin
+
+		if (reset) begin
+			div_count <= 32'b0;
+			step <= 9'b0;
+			duty_r <= 8'b0;
+			duty_g <= 8'b0;
+			duty_b <= 8'b0;
+			pwm_red <= 1'b0;
+			pwm_green <= 1'b0;
+			pwm_blue <= 1'b0;
+		end
+
+		else
+		begin
+			if (div_count >= pwm_div - 1) begin
+				div_count <= 32'b0;
+				step <= step + 1'b1;
+				// the last step of a period, take the new color from here
+				if (step == 9'h1FF) begin
+					duty_r <= red;
+					duty_g <= green;
+					duty_b <= blue;
+				end
+			end
+			else begin
+				div_count <= div_count + 1'b1;
+			end
+
+			pwm_red <= {1'b0, duty_r} > step;
+			pwm_green <= {1'b0, duty_g} > step;
+			pwm_blue <= {1'b0, duty_b} > step;
+		end
+
+	end
+
+endmodule
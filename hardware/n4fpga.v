@@ -15,7 +15,45 @@
 // The module assume that a PmodOLED is plugged into the JA 
 // expansion ports and that a PmodENC is plugged into the JD expansion 
 // port (top row).  
+//
+// Define USE_SHARED_PWM_DETECTOR to measure the three RGB1 PWM signals with
+// one time multiplexed pwm_detector_mux instead of three pwm_detector
+// copies.  The GPIO interface to the Microblaze is the same either way.
+//
+// Define USE_WS2812 to drive a WS2812 LED strip on JB[0] from ws2812_axi.
+// The block design must then export an AXI4-Lite master (M_AXI_WS2812) and
+// its clock and reset (clk_axi, peripheral_aresetn).  Without it JB is tied
+// low as before and the firmware leaves the strip out, it finds no
+// XPAR_M_AXI_WS2812_BASEADDR.
+//
+// Define USE_HSV_PWM to convert an HSV color register to RGB and PWM in the
+// fabric with hsv_pwm_axi, on another exported master (M_AXI_HSV).  While
+// its enable bit is set it drives RGB1 and RGB2 in place of Nexys4IO.  The
+// PWM detectors measure the pins, whichever of the two is driving them.
+// Without it Nexys4IO drives the LEDs as before and the firmware converts
+// in software, it finds no XPAR_M_AXI_HSV_BASEADDR.
+//
+// Define USE_TRACE to put eight firmware trace bits from trace_axi on JC
+// for a logic analyzer, on another exported master (M_AXI_TRACE).  See
+// trace.h in the software for what each pin shows.  Without it JC is tied
+// low and the trace calls in the firmware compile to nothing, it finds no
+// XPAR_M_AXI_TRACE_BASEADDR.
 //////////////////////////////////////////////////////////////////////
+// `define USE_SHARED_PWM_DETECTOR
+// `define USE_WS2812
+// `define USE_HSV_PWM
+// `define USE_TRACE
+
+// The block design exports clk_axi and peripheral_aresetn with the masters,
+// ws2812_axi, hsv_pwm_axi and trace_axi run on them
+`ifdef USE_WS2812
+`define USE_AXI_EXPORTS
+`elsif USE_HSV_PWM
+`define USE_AXI_EXPORTS
+`elsif USE_TRACE
+`define USE_AXI_EXPORTS
+`endif
+
 module n4fpga(
     input				clk,			// 100Mhz clock input
     input				btnC,			// center pushbutton
@@ -82,6 +120,46 @@ wire                w_RGB1_Red, w_RGB1_Blue, w_RGB1_Green;
 wire    [31:0]      wire_highcount_r, wire_highcount_g, wire_highcount_b;
 wire    [31:0]      wire_lowcount_r, wire_lowcount_g, wire_lowcount_b;
 wire                w_clk_pwm_detect;
+wire    [2:0]       w_pwm_prescale;         // pwm_detector resolution, set by the firmware
+`ifdef USE_AXI_EXPORTS
+// Clock and reset of the exported AXI4-Lite masters
+wire                w_clk_axi, w_axi_aresetn;
+`endif
+`ifdef USE_WS2812
+// WS2812 strip engine, AXI4-Lite from the embedded system
+wire    [12:0]      ws2812_awaddr, ws2812_araddr;
+wire    [31:0]      ws2812_wdata, ws2812_rdata;
+wire    [3:0]       ws2812_wstrb;
+wire    [1:0]       ws2812_bresp, ws2812_rresp;
+wire                ws2812_awvalid, ws2812_awready, ws2812_wvalid, ws2812_wready;
+wire                ws2812_bvalid, ws2812_bready, ws2812_arvalid, ws2812_arready;
+wire                ws2812_rvalid, ws2812_rready;
+wire                w_ws2812_dout;
+`endif
+`ifdef USE_HSV_PWM
+// HSV color register and PWM, AXI4-Lite from the embedded system
+wire    [11:0]      hsv_awaddr, hsv_araddr;
+wire    [31:0]      hsv_wdata, hsv_rdata;
+wire    [3:0]       hsv_wstrb;
+wire    [1:0]       hsv_bresp, hsv_rresp;
+wire                hsv_awvalid, hsv_awready, hsv_wvalid, hsv_wready;
+wire                hsv_bvalid, hsv_bready, hsv_arvalid, hsv_arready;
+wire                hsv_rvalid, hsv_rready;
+wire                w_hsv_enable, w_hsv_red, w_hsv_green, w_hsv_blue;
+`endif
+wire                w_nx4io_RGB1_Red, w_nx4io_RGB1_Green, w_nx4io_RGB1_Blue;
+wire                w_nx4io_RGB2_Red, w_nx4io_RGB2_Green, w_nx4io_RGB2_Blue;
+`ifdef USE_TRACE
+// Trace bits on JC, AXI4-Lite from the embedded system
+wire    [11:0]      trace_awaddr, trace_araddr;
+wire    [31:0]      trace_wdata, trace_rdata;
+wire    [3:0]       trace_wstrb;
+wire    [1:0]       trace_bresp, trace_rresp;
+wire                trace_awvalid, trace_awready, trace_wvalid, trace_wready;
+wire                trace_bvalid, trace_bready, trace_arvalid, trace_arready;
+wire                trace_rvalid, trace_rready;
+wire    [7:0]       w_trace;
+`endif
 // LED pins 
 wire    [15:0]      led_int;                // Nexys4IO drives these outputs
 
@@ -91,11 +169,29 @@ wire    [15:0]      led_int;                // Nexys4IO drives these outputs
 // you may decide that using an axi_gpio peripheral is a good way to interface
 // your hardware pulse-width detect logic with the Microblaze.  Our application
 // is simple.
+`ifdef USE_HSV_PWM
+// The RGB leds are driven by Nexys4IO or by hsv_pwm_axi when it is enabled
+assign RGB1_Red =   w_hsv_enable ? w_hsv_red :   w_nx4io_RGB1_Red;
+assign RGB1_Green = w_hsv_enable ? w_hsv_green : w_nx4io_RGB1_Green;
+assign RGB1_Blue =  w_hsv_enable ? w_hsv_blue :  w_nx4io_RGB1_Blue;
+assign RGB2_Red =   w_hsv_enable ? w_hsv_red :   w_nx4io_RGB2_Red;
+assign RGB2_Green = w_hsv_enable ? w_hsv_green : w_nx4io_RGB2_Green;
+assign RGB2_Blue =  w_hsv_enable ? w_hsv_blue :  w_nx4io_RGB2_Blue;
+`else
+// The RGB leds are driven by Nexys4IO
+assign RGB1_Red =   w_nx4io_RGB1_Red;
+assign RGB1_Green = w_nx4io_RGB1_Green;
+assign RGB1_Blue =  w_nx4io_RGB1_Blue;
+assign RGB2_Red =   w_nx4io_RGB2_Red;
+assign RGB2_Green = w_nx4io_RGB2_Green;
+assign RGB2_Blue =  w_nx4io_RGB2_Blue;
+`endif
 // Wrap the RGB led output back to the application program for software pulse-width detect
 assign w_RGB1_Red =   RGB1_Red;
 assign w_RGB1_Blue =  RGB1_Blue;
 assign w_RGB1_Green = RGB1_Green; 
 assign gpio_in = {5'b00000, w_RGB1_Red, w_RGB1_Blue, w_RGB1_Green};
+assign w_pwm_prescale = gpio_out[2:0];   // gpio_out[2:0] selects the pwm_detector prescale
 
 // Drive the leds from the signal generated by the microblaze 
 assign led = led_int;                   // LEDs are driven by led
@@ -117,11 +213,21 @@ assign JA[5] = pmodoledrgb_out_pin8_io;
 assign JA[6] = pmodoledrgb_out_pin9_io;
 assign JA[7] = pmodoledrgb_out_pin10_io;
 
+`ifdef USE_WS2812
+// JB Connector: WS2812 strip data on pin 1, the rest can be used for debug purposes
+assign JB = {7'b0000000, w_ws2812_dout};	// JB[0] (pin 1) is the WS2812 strip data
+`else
 // JB Connector connections can be used for debug purposes
 assign JB = 8'b0000000;
+`endif
 
+`ifdef USE_TRACE
+// JC Connector: firmware trace bits for a logic analyzer
+assign JC = w_trace;
+`else
 // JC Connector pins can be used for debug purposes 
-assign JC = 8'h00; 
+assign JC = 8'h00;
+`endif
 
 // PmodENC signals
 // JD - top row
@@ -173,6 +279,71 @@ design_1 EMBSYS
         .gpio_rtl_lowcount_g_tri_i(wire_lowcount_g),
         .gpio_rtl_lowcount_b_tri_i(wire_lowcount_b),
         .clk_pwm_detect(w_clk_pwm_detect),
+`ifdef USE_WS2812
+        // WS2812 engine AXI4-Lite master
+        .M_AXI_WS2812_awaddr(ws2812_awaddr),
+        .M_AXI_WS2812_awvalid(ws2812_awvalid),
+        .M_AXI_WS2812_awready(ws2812_awready),
+        .M_AXI_WS2812_wdata(ws2812_wdata),
+        .M_AXI_WS2812_wstrb(ws2812_wstrb),
+        .M_AXI_WS2812_wvalid(ws2812_wvalid),
+        .M_AXI_WS2812_wready(ws2812_wready),
+        .M_AXI_WS2812_bresp(ws2812_bresp),
+        .M_AXI_WS2812_bvalid(ws2812_bvalid),
+        .M_AXI_WS2812_bready(ws2812_bready),
+        .M_AXI_WS2812_araddr(ws2812_araddr),
+        .M_AXI_WS2812_arvalid(ws2812_arvalid),
+        .M_AXI_WS2812_arready(ws2812_arready),
+        .M_AXI_WS2812_rdata(ws2812_rdata),
+        .M_AXI_WS2812_rresp(ws2812_rresp),
+        .M_AXI_WS2812_rvalid(ws2812_rvalid),
+        .M_AXI_WS2812_rready(ws2812_rready),
+`endif
+`ifdef USE_HSV_PWM
+        // HSV color register AXI4-Lite master, same clock and reset
+        .M_AXI_HSV_awaddr(hsv_awaddr),
+        .M_AXI_HSV_awvalid(hsv_awvalid),
+        .M_AXI_HSV_awready(hsv_awready),
+        .M_AXI_HSV_wdata(hsv_wdata),
+        .M_AXI_HSV_wstrb(hsv_wstrb),
+        .M_AXI_HSV_wvalid(hsv_wvalid),
+        .M_AXI_HSV_wready(hsv_wready),
+        .M_AXI_HSV_bresp(hsv_bresp),
+        .M_AXI_HSV_bvalid(hsv_bvalid),
+        .M_AXI_HSV_bready(hsv_bready),
+        .M_AXI_HSV_araddr(hsv_araddr),
+        .M_AXI_HSV_arvalid(hsv_arvalid),
+        .M_AXI_HSV_arready(hsv_arready),
+        .M_AXI_HSV_rdata(hsv_rdata),
+        .M_AXI_HSV_rresp(hsv_rresp),
+        .M_AXI_HSV_rvalid(hsv_rvalid),
+        .M_AXI_HSV_rready(hsv_rready),
+`endif
+`ifdef USE_TRACE
+        // Trace register AXI4-Lite master, same clock and reset
+        .M_AXI_TRACE_awaddr(trace_awaddr),
+        .M_AXI_TRACE_awvalid(trace_awvalid),
+        .M_AXI_TRACE_awready(trace_awready),
+        .M_AXI_TRACE_wdata(trace_wdata),
+        .M_AXI_TRACE_wstrb(trace_wstrb),
+        .M_AXI_TRACE_wvalid(trace_wvalid),
+        .M_AXI_TRACE_wready(trace_wready),
+        .M_AXI_TRACE_bresp(trace_bresp),
+        .M_AXI_TRACE_bvalid(trace_bvalid),
+        .M_AXI_TRACE_bready(trace_bready),
+        .M_AXI_TRACE_araddr(trace_araddr),
+        .M_AXI_TRACE_arvalid(trace_arvalid),
+        .M_AXI_TRACE_arready(trace_arready),
+        .M_AXI_TRACE_rdata(trace_rdata),
+        .M_AXI_TRACE_rresp(trace_rresp),
+        .M_AXI_TRACE_rvalid(trace_rvalid),
+        .M_AXI_TRACE_rready(trace_rready),
+`endif
+`ifdef USE_AXI_EXPORTS
+        // clock and reset of the exported masters
+        .clk_axi(w_clk_axi),
+        .peripheral_aresetn(w_axi_aresetn),
+`endif
         // Pmod Rotary Encoder
 	    .Pmod_out_0_pin10_i(Pmod_out_0_pin10_i),
         .Pmod_out_0_pin10_o(Pmod_out_0_pin10_o),
@@ -199,12 +370,12 @@ design_1 EMBSYS
         .Pmod_out_0_pin9_o(Pmod_out_0_pin9_o),
         .Pmod_out_0_pin9_t(Pmod_out_0_pin9_t),
         // RGB1/2 Led's 
-        .RGB1_Blue_0(RGB1_Blue),
-        .RGB1_Green_0(RGB1_Green),
-        .RGB1_Red_0(RGB1_Red),
-        .RGB2_Blue_0(RGB2_Blue),
-        .RGB2_Green_0(RGB2_Green),
-        .RGB2_Red_0(RGB2_Red),
+        .RGB1_Blue_0(w_nx4io_RGB1_Blue),
+        .RGB1_Green_0(w_nx4io_RGB1_Green),
+        .RGB1_Red_0(w_nx4io_RGB1_Red),
+        .RGB2_Blue_0(w_nx4io_RGB2_Blue),
+        .RGB2_Green_0(w_nx4io_RGB2_Green),
+        .RGB2_Red_0(w_nx4io_RGB2_Red),
         // Seven Segment Display anode control  
         .an_0(an),
         .dp_0(dp),
@@ -342,10 +513,111 @@ IOBUF Pmod_out_0_pin10_iobuf
           .O(Pmod_out_0_pin10_i),
           .T(Pmod_out_0_pin10_t));
 
+`ifdef USE_WS2812
+// WS2812 addressable LED strip on JB
+ws2812_axi #(
+    .MAX_PIXELS(512)
+    ) strip (
+    .s_axi_aclk(w_clk_axi),
+    .s_axi_aresetn(w_axi_aresetn),
+    .s_axi_awaddr(ws2812_awaddr),
+    .s_axi_awvalid(ws2812_awvalid),
+    .s_axi_awready(ws2812_awready),
+    .s_axi_wdata(ws2812_wdata),
+    .s_axi_wstrb(ws2812_wstrb),
+    .s_axi_wvalid(ws2812_wvalid),
+    .s_axi_wready(ws2812_wready),
+    .s_axi_bresp(ws2812_bresp),
+    .s_axi_bvalid(ws2812_bvalid),
+    .s_axi_bready(ws2812_bready),
+    .s_axi_araddr(ws2812_araddr),
+    .s_axi_arvalid(ws2812_arvalid),
+    .s_axi_arready(ws2812_arready),
+    .s_axi_rdata(ws2812_rdata),
+    .s_axi_rresp(ws2812_rresp),
+    .s_axi_rvalid(ws2812_rvalid),
+    .s_axi_rready(ws2812_rready),
+    .ws2812_dout(w_ws2812_dout)
+    );
+`endif
+
+`ifdef USE_HSV_PWM
+// HSV color register, converter and RGB PWM
+hsv_pwm_axi #(
+    .PWM_DIV_DEFAULT(12500)
+    ) hsv_color (
+    .s_axi_aclk(w_clk_axi),
+    .s_axi_aresetn(w_axi_aresetn),
+    .s_axi_awaddr(hsv_awaddr),
+    .s_axi_awvalid(hsv_awvalid),
+    .s_axi_awready(hsv_awready),
+    .s_axi_wdata(hsv_wdata),
+    .s_axi_wstrb(hsv_wstrb),
+    .s_axi_wvalid(hsv_wvalid),
+    .s_axi_wready(hsv_wready),
+    .s_axi_bresp(hsv_bresp),
+    .s_axi_bvalid(hsv_bvalid),
+    .s_axi_bready(hsv_bready),
+    .s_axi_araddr(hsv_araddr),
+    .s_axi_arvalid(hsv_arvalid),
+    .s_axi_arready(hsv_arready),
+    .s_axi_rdata(hsv_rdata),
+    .s_axi_rresp(hsv_rresp),
+    .s_axi_rvalid(hsv_rvalid),
+    .s_axi_rready(hsv_rready),
+    .rgb_enable(w_hsv_enable),
+    .pwm_red(w_hsv_red),
+    .pwm_green(w_hsv_green),
+    .pwm_blue(w_hsv_blue)
+    );
+`endif
+
+`ifdef USE_TRACE
+// Firmware trace bits on JC
+trace_axi debug_trace (
+    .s_axi_aclk(w_clk_axi),
+    .s_axi_aresetn(w_axi_aresetn),
+    .s_axi_awaddr(trace_awaddr),
+    .s_axi_awvalid(trace_awvalid),
+    .s_axi_awready(trace_awready),
+    .s_axi_wdata(trace_wdata),
+    .s_axi_wstrb(trace_wstrb),
+    .s_axi_wvalid(trace_wvalid),
+    .s_axi_wready(trace_wready),
+    .s_axi_bresp(trace_bresp),
+    .s_axi_bvalid(trace_bvalid),
+    .s_axi_bready(trace_bready),
+    .s_axi_araddr(trace_araddr),
+    .s_axi_arvalid(trace_arvalid),
+    .s_axi_arready(trace_arready),
+    .s_axi_rdata(trace_rdata),
+    .s_axi_rresp(trace_rresp),
+    .s_axi_rvalid(trace_rvalid),
+    .s_axi_rready(trace_rready),
+    .trace(w_trace)
+    );
+`endif
+
+`ifdef USE_SHARED_PWM_DETECTOR
+
+pwm_detector_mux #(
+    .NUM_CHANNELS(3)
+    ) rgb_duty_cycle (
+    .clk(w_clk_pwm_detect),
+    .reset(sysreset),
+    .pwm_signal({w_RGB1_Blue, w_RGB1_Green, w_RGB1_Red}),
+    .prescale_sel(w_pwm_prescale),
+    .high_count({wire_highcount_b, wire_highcount_g, wire_highcount_r}),
+    .low_count({wire_lowcount_b, wire_lowcount_g, wire_lowcount_r})
+    );
+
+`else
+
 pwm_detector r_duty_cycle (
     .clk(w_clk_pwm_detect),
     .reset(sysreset),
     .pwm_signal(w_RGB1_Red),
+    .prescale_sel(w_pwm_prescale),
     .high_count(wire_highcount_r),
     .low_count(wire_lowcount_r)
     );
@@ -354,6 +626,7 @@ pwm_detector g_duty_cycle (
     .clk(w_clk_pwm_detect),
     .reset(sysreset),
     .pwm_signal(w_RGB1_Green),
+    .prescale_sel(w_pwm_prescale),
     .high_count(wire_highcount_g),
     .low_count(wire_lowcount_g)
     );
@@ -362,9 +635,12 @@ pwm_detector g_duty_cycle (
         .clk(w_clk_pwm_detect),
         .reset(sysreset),
         .pwm_signal(w_RGB1_Blue),
+        .prescale_sel(w_pwm_prescale),
         .high_count(wire_highcount_b),
         .low_count(wire_lowcount_b)
         );
+
+`endif
     
 endmodule
 
@@ -6,27 +6,109 @@ module pwm_detector #(
 
 	// Define some timing parameters
 
-	parameter integer 	CLK_FREQUENCY_HZ = 100000000)
+	parameter integer 	CLK_FREQUENCY_HZ = 100000000,
+	parameter integer	PWM_PERIOD_MAX_US = 250000,			// longest PWM period measured (PWM_PERIOD_MAX_US in the firmware)
+	parameter integer	PRESCALE_SEL_WIDTH = 3,				// prescale_sel picks a divide by 1 .. 2^(2^width - 1)
+	parameter integer	STUCK_PERIODS = 2)					// constant level this many periods is 0% / 100%
 
 	/******************************************************************/
 	/* Port declarations							                  */
 	/******************************************************************/
 
-	(				
+	(
 	input 					clk,			// 100MHz system clock
 	input 			 		reset,			// active-high reset signal from Nexys4
 	input 					pwm_signal,			// PWM signal from AXI Timer in EMBSYS
+	input	[PRESCALE_SEL_WIDTH-1:0]	prescale_sel,	// count every 2^prescale_sel clocks --> GPIO output from Microblaze
 
 	output reg	[31:0]		high_count,		// how long PWM was 'high' --> GPIO input on Microblaze
 	output reg	[31:0]		low_count);		// how long PWM was 'low' --> GPIO input on Microblaze
 
+	/******************************************************************/
+	/* Description									                  */
+	/******************************************************************/
+
+	// The counters only advance on a clock enable from a 2^prescale_sel
+	// prescaler, so high_count and low_count are in units of 2^prescale_sel
+	// clocks.  The firmware only uses their ratio, so the duty cycle does
+	// not depend on the setting.  A larger prescale draws less power and
+	// sees edges up to 2^prescale_sel - 1 clocks late.
+	//
+	// The counters are only as wide as the longest carrier the firmware
+	// can select, PWM_PERIOD_MAX_US at CLK_FREQUENCY_HZ, needs at prescale
+	// 0 (25 bits for 250 ms at 100MHz).  A level that lasts a whole
+	// MAX_PERIOD_CYCLES (MAX_PERIOD_CYCLES >> prescale_sel counts, the same
+	// time at every setting) is the longest wait for a constant level; no
+	// high or low time of a real period is that long.
+	//
+	// Once a period has been measured the wait is STUCK_PERIODS times the
+	// longer of the last two periods, so turning a color fully off or on
+	// shows within a few periods.  Taking the longer one keeps the short
+	// period a duty change can cut in the middle of a carrier period from
+	// calling the next, normal, period stuck.  Once a level has been called
+	// stuck the wait goes back to MAX_PERIOD_CYCLES until a period is
+	// measured again, so a longer carrier cannot keep calling it stuck.
+	// A constant level is reported as a saturated pair:
+	//     high_count == 0, low_count != 0   stuck low (0%)
+	//     high_count != 0, low_count == 0   stuck high (100%)
+	// with the nonzero count the time it took to call it.  Both 0 means no
+	// period has been seen since reset.  Any edge ends the stuck level, so
+	// a line that goes from stuck high to constant low (or back) is called
+	// stuck again at the new level.  The first rising edge after a stuck
+	// call does not end a real period (resync), so the outputs stay
+	// saturated until the next one.  A prescale change forgets the period.
+
 	/******************************************************************/
 	/* Local parameters and values		                  	  		  */
 	/******************************************************************/
 
-	reg			[31:0]		hcount,lcount;			// 32-bit counter used for high/low count intervals
+	localparam integer	MAX_PERIOD_CYCLES = CLK_FREQUENCY_HZ / 1000000 * PWM_PERIOD_MAX_US;
+	localparam integer	COUNT_WIDTH = $clog2(MAX_PERIOD_CYCLES + 1);
+	localparam integer	DIV_WIDTH = (1 << PRESCALE_SEL_WIDTH) - 1;
+	localparam integer	LIMIT_WIDTH = COUNT_WIDTH + 1 + $clog2(STUCK_PERIODS + 1);
+
+	reg			[COUNT_WIDTH-1:0]	hcount,lcount;			// counters used for high/low count intervals
 	reg 					prev_pwm; 		// previous state of PWM; used to detect transitions
 
+	reg	[PRESCALE_SEL_WIDTH-1:0]	sel_meta, sel;	// prescale_sel comes from the AXI clock domain
+	reg			[DIV_WIDTH-1:0]		div;			// prescaler
+	reg								ce;				// count enable, one clock every 2^sel
+	wire		[COUNT_WIDTH-1:0]	timeout = (MAX_PERIOD_CYCLES - 1) >> sel;
+
+	reg			[PRESCALE_SEL_WIDTH-1:0]	sel_q;	// sel the period was measured at
+	reg			[COUNT_WIDTH-1:0]	stuck_limit;	// STUCK_PERIODS periods, at most timeout
+	reg								limit_valid;	// stuck_limit is from a measured period
+	reg			[COUNT_WIDTH:0]		last_period;	// the period before this one
+	reg								stuck;			// this level has been called stuck
+	reg								resync;			// the next rising edge is not a period
+	wire		[COUNT_WIDTH-1:0]	limit = limit_valid ? stuck_limit : timeout;
+	wire		[COUNT_WIDTH:0]		period = hcount + lcount;
+	wire		[COUNT_WIDTH:0]		longer = (period > last_period) ? period : last_period;
+	wire		[LIMIT_WIDTH-1:0]	period_limit = longer * STUCK_PERIODS;
+
+	/******************************************************************/
+	/* Prescaler									                  */
+	/******************************************************************/
+
+	// ce is high when the low sel bits of the prescaler are all ones
+	wire		[DIV_WIDTH-1:0]		div_mask = ~({DIV_WIDTH{1'b1}} << sel);
+
+	always@(posedge clk) begin
+
+		sel_meta <= prescale_sel;
+		sel <= sel_meta;
+
+		if (reset) begin
+			div <= 0;
+			ce <= 1'b0;
+		end
+		else begin
+			div <= div + 1;
+			ce <= (div & div_mask) == div_mask;
+		end
+
+	end
+
 	/******************************************************************/
 	/* Obtain the counts for high & low intervals	                  */
 	/******************************************************************/
@@ -35,45 +117,81 @@ module pwm_detector #(
 
 		if (reset) begin					// check for synchronous reset
 
-			lcount <= 32'b0;
-			hcount <= 32'b0;					// clear the counter
+			lcount <= 0;
+			hcount <= 0;					// clear the counter
 			high_count <= 32'b0;			// clear the 'high' register
 			low_count <= 32'b0;				// clear the 'low' register
 			prev_pwm <= 1'b0;				// clear the previous state
+			sel_q <= 0;
+			stuck_limit <= 0;
+			limit_valid <= 1'b0;
+			last_period <= 0;
+			stuck <= 1'b0;
+			resync <= 1'b0;
 
 		end
 
-		else 
+		else if (sel != sel_q)				// counts change units, measure again
+		begin
+			sel_q <= sel;
+			limit_valid <= 1'b0;
+			last_period <= 0;
+		end
+
+		else if (ce)
 		begin
 		    if (prev_pwm && pwm_signal) begin 		// if so, check whether there was a high-to-low transition
-				hcount <= hcount + 1; 		// store the 'high' count
-			end  
+				if (hcount != {COUNT_WIDTH{1'b1}})
+					hcount <= hcount + 1; 		// store the 'high' count
+				if (!stuck && hcount >= limit)
+				begin
+					high_count <= hcount;		// stuck high
+					low_count <= 32'b0;
+					stuck <= 1'b1;
+					resync <= 1'b1;
+					limit_valid <= 1'b0;
+				end
+			end
 			else if(prev_pwm == 0 && pwm_signal == 0)
 			begin
-			     lcount <= lcount + 1;
-			     if(lcount == 32'h00FFFFF)
+			     if (lcount != {COUNT_WIDTH{1'b1}})
+			         lcount <= lcount + 1;
+			     if (!stuck && lcount >= limit)
 			     begin
-			         low_count <= 32'b0;
+			         low_count <= lcount;		// stuck low
 			         high_count <= 32'b0;
+			         stuck <= 1'b1;
+			         resync <= 1'b1;
+			         limit_valid <= 1'b0;
 			     end
 			end
 			else if (prev_pwm == 0 && pwm_signal == 1)
 			begin
-			     high_count <= hcount;
-			     low_count <= lcount;
+			     if (resync)					// the level before this edge was not a period
+			         resync <= 1'b0;
+			     else
+			     begin
+			         high_count <= hcount;
+			         low_count <= lcount;
+			         stuck_limit <= (period_limit > timeout) ? timeout : period_limit;
+			         limit_valid <= 1'b1;
+			         last_period <= period;
+			     end
 			     hcount <= 1;
-			
+			     stuck <= 1'b0;
+
 			end
 			else if (prev_pwm == 1 && pwm_signal == 0)
 			begin
 			     lcount <= 1;
-			
+			     stuck <= 1'b0;					// the low level can be called stuck
+
 			end
-		
+
 		     prev_pwm <= pwm_signal;
-		
+
 		end
 
 	end
 
-endmodule
\ No newline at end of file
+endmodule
@@ -0,0 +1,180 @@
+module pwm_detector_mux #(
+
+	/******************************************************************/
+	/* Parameter declarations						                  */
+	/******************************************************************/
+
+	// Define some timing parameters
+
+	parameter integer 	CLK_FREQUENCY_HZ = 100000000,
+	parameter integer 	NUM_CHANNELS = 3,				// PWM signals served by the shared datapath
+	parameter integer	PWM_PERIOD_MAX_US = 250000,		// longest PWM period measured (as pwm_detector)
+	parameter integer	PRESCALE_SEL_WIDTH = 3,			// prescale_sel picks a divide by 1 .. 2^(2^width - 1)
+	parameter integer	STUCK_PERIODS = 2)				// constant level this many periods is 0% / 100%
+
+	/******************************************************************/
+	/* Port declarations							                  */
+	/******************************************************************/
+
+	(
+	input 								clk,			// 100MHz system clock
+	input 			 					reset,			// active-high reset signal from Nexys4
+	input		[NUM_CHANNELS-1:0]		pwm_signal,		// PWM signals, channel 0 in bit 0
+	input	[PRESCALE_SEL_WIDTH-1:0]	prescale_sel,	// counts are in units of 2^prescale_sel clocks
+
+	output reg	[32*NUM_CHANNELS-1:0]	high_count,		// how long each PWM was 'high', channel 0 in [31:0]
+	output reg	[32*NUM_CHANNELS-1:0]	low_count);		// how long each PWM was 'low', channel 0 in [31:0]
+
+	/******************************************************************/
+	/* Description									                  */
+	/******************************************************************/
+
+	// Time multiplexed version of pwm_detector.  Instead of a pair of
+	// 32-bit counters per channel there is one free running 32-bit
+	// timestamp and one set of subtractors, and each channel is visited
+	// in turn every NUM_CHANNELS clocks.  The per channel state (level
+	// and the timestamps of the last rising and falling edge) lives in
+	// distributed RAM, so adding a channel costs LUT RAM and the two
+	// output registers rather than another counter datapath.
+	//
+	// An edge is seen up to NUM_CHANNELS-1 clocks late, so each count can
+	// be off by that many clocks.  At the PWM rates used here a period is
+	// many thousands of clocks and the duty cycle seen by the firmware
+	// (whole percent) is the same as with pwm_detector.
+	//
+	// The outputs have the same meaning as pwm_detector's and are updated
+	// on the rising edge that ends each period.  A constant level is called
+	// after STUCK_PERIODS of the longer of the last two periods, or
+	// MAX_PERIOD_CYCLES before one has been measured and after a level has
+	// been called stuck, and reported as the same saturated pairs.  As in
+	// pwm_detector, a line that goes from stuck high to constant low (or
+	// back) is called stuck again at the new level.
+	//
+	// The timestamp runs at the full clock whatever prescale_sel says, and
+	// the counts are shifted down to 2^prescale_sel clock units on the way
+	// out, so the firmware sees the same values as from pwm_detector.  There
+	// is no prescaler to slow, so prescale_sel saves no power here.
+
+	/******************************************************************/
+	/* Local parameters and values		                  	  		  */
+	/******************************************************************/
+
+	localparam integer	SEL_WIDTH = (NUM_CHANNELS > 1) ? $clog2(NUM_CHANNELS) : 1;
+	localparam integer	MAX_PERIOD_CYCLES = CLK_FREQUENCY_HZ / 1000000 * PWM_PERIOD_MAX_US;
+	localparam integer	TIMEOUT_CYCLES = MAX_PERIOD_CYCLES - 1;
+
+	reg			[31:0]				now;			// shared timestamp, one tick per clock
+	reg			[SEL_WIDTH-1:0]		sel = 0;		// channel visited this clock
+
+	reg	[PRESCALE_SEL_WIDTH-1:0]	psel_meta, psel;	// prescale_sel comes from the AXI clock domain
+
+	// Per channel state: {resync, stuck, level, last period, stuck limit,
+	// rise timestamp, fall timestamp}.  stuck is set once the level has
+	// been called stuck and cleared by either edge, resync from then until
+	// the next rising edge, which does not end a period.  A stuck limit of
+	// 0 means none has been measured.
+	(* ram_style = "distributed" *)
+	reg			[130:0]				state_ram [0:NUM_CHANNELS-1];
+
+	wire		[130:0]				state = state_ram[sel];
+	wire							resync = state[130];
+	wire							stuck = state[129];
+	wire							prev_pwm = state[128];
+	wire		[31:0]				last_period = state[127:96];
+	wire		[31:0]				stuck_limit = state[95:64];
+	wire		[31:0]				rise_ts = state[63:32];
+	wire		[31:0]				fall_ts = state[31:0];
+	wire							pwm = pwm_signal[sel];
+
+	wire		[31:0]				limit = (stuck_limit != 0) ? stuck_limit : TIMEOUT_CYCLES;
+	wire		[31:0]				high_time = now - rise_ts;
+	wire		[31:0]				low_time = now - fall_ts;
+	wire		[31:0]				longer = (high_time > last_period) ? high_time : last_period;	// at a rising edge high_time is the period
+	wire		[33:0]				period_limit = longer * STUCK_PERIODS;
+	wire		[31:0]				next_limit = (period_limit > TIMEOUT_CYCLES) ?
+										TIMEOUT_CYCLES : period_limit[31:0];
+
+	integer							i;
+
+	initial begin
+		for (i = 0; i < NUM_CHANNELS; i = i + 1)
+			state_ram[i] = 131'b0;
+	end
+
+	/******************************************************************/
+	/* Channel sequencer and timestamp				                  */
+	/******************************************************************/
+
+	always@(posedge clk) begin
+		psel_meta <= prescale_sel;
+		psel <= psel_meta;
+
+		if (reset) begin
+			now <= 32'b0;
+		end
+		else begin
+			now <= now + 1;
+		end
+
+		// keep cycling through reset so every RAM entry gets cleared
+		if (sel == NUM_CHANNELS - 1)
+			sel <= 0;
+		else
+			sel <= sel + 1;
+	end
+
+	/******************************************************************/
+	/* Obtain the counts for high & low intervals	                  */
+	/******************************************************************/
+
+	always@(posedge clk) begin
+
+		if (reset) begin					// check for synchronous reset
+
+			state_ram[sel] <= 131'b0;		// clear this channel's state
+			high_count[sel*32 +: 32] <= 32'b0;	// clear the 'high' register
+			low_count[sel*32 +: 32] <= 32'b0;	// clear the 'low' register
+
+		end
+
+		else
+		begin
+			if (prev_pwm == 0 && pwm == 1)	// rising edge, a period is complete
+			begin
+				if (resync)					// the level before this edge was not a period
+					state_ram[sel] <= {2'b00, 1'b1, last_period, stuck_limit, now, fall_ts};
+				else
+				begin
+					high_count[sel*32 +: 32] <= (fall_ts - rise_ts) >> psel;
+					low_count[sel*32 +: 32] <= low_time >> psel;
+					state_ram[sel] <= {2'b00, 1'b1, high_time, next_limit, now, fall_ts};
+				end
+			end
+			else if (prev_pwm == 1 && pwm == 0)	// falling edge, the low level can be called stuck
+			begin
+				state_ram[sel] <= {resync, 1'b0, 1'b0, last_period, stuck_limit, rise_ts, now};
+			end
+			else if (prev_pwm == 1 && pwm == 1)
+			begin
+				if (!stuck && high_time >= limit)	// stuck high
+				begin
+					high_count[sel*32 +: 32] <= high_time >> psel;
+					low_count[sel*32 +: 32] <= 32'b0;
+					state_ram[sel] <= {2'b11, prev_pwm, last_period, 32'b0, rise_ts, fall_ts};
+				end
+			end
+			else if (prev_pwm == 0 && pwm == 0)
+			begin
+				if (!stuck && low_time >= limit)	// stuck low
+				begin
+					low_count[sel*32 +: 32] <= low_time >> psel;
+					high_count[sel*32 +: 32] <= 32'b0;
+					state_ram[sel] <= {2'b11, prev_pwm, last_period, 32'b0, rise_ts, fall_ts};
+				end
+			end
+
+		end
+
+	end
+
+endmodule
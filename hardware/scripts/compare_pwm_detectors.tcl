@@ -0,0 +1,50 @@
+## compare_pwm_detectors.tcl
+##
+## Utilization and Fmax of the two RGB1 detector builds in n4fpga.v: three
+## pwm_detector copies, or one pwm_detector_mux with NUM_CHANNELS = 3
+## (USE_SHARED_PWM_DETECTOR).  Each is placed and routed out of context on
+## the Nexys4 DDR part against the 100MHz system clock, and the LUT, LUTRAM
+## and flip-flop counts and the worst setup slack are printed as a table.
+## pwm_detector is built once and its figures multiplied by three.
+##
+## Run from this directory with:
+##     vivado -mode batch -source compare_pwm_detectors.tcl
+## The reports for each build are left in ./compare_pwm_detectors/.
+
+set part xc7a100tcsg324-1
+set period 10.0
+set out_dir compare_pwm_detectors
+file mkdir $out_dir
+read_verilog [list ../pwm_detector.v ../pwm_detector_mux.v]
+
+proc build {top copies params} {
+    global part period out_dir
+
+    synth_design -top $top -part $part -mode out_of_context {*}$params
+    create_clock -name clk -period $period [get_ports clk]
+    opt_design
+    place_design
+    route_design
+
+    report_utilization -file $out_dir/${top}_utilization.rpt
+    report_timing_summary -file $out_dir/${top}_timing.rpt
+
+    set luts [llength [get_cells -hier -filter {PRIMITIVE_GROUP == LUT}]]
+    set lutram [llength [get_cells -hier -filter {PRIMITIVE_GROUP == DMEM}]]
+    set ffs [llength [get_cells -hier -filter {PRIMITIVE_GROUP == FLOP_LATCH}]]
+    set wns [get_property SLACK [get_timing_paths -delay_type max -max_paths 1]]
+    set fmax [expr {1000.0 / ($period - $wns)}]
+
+    close_design
+    return [list [expr {$luts * $copies}] [expr {$lutram * $copies}] \
+            [expr {$ffs * $copies}] $wns $fmax]
+}
+
+set separate [build pwm_detector 3 {}]
+set shared [build pwm_detector_mux 1 {-generic NUM_CHANNELS=3}]
+
+puts ""
+puts [format "%-24s %8s %8s %8s %10s %10s" "RGB1 detectors" LUT LUTRAM FF "WNS (ns)" "Fmax (MHz)"]
+foreach {name r} [list "3 x pwm_detector" $separate "pwm_detector_mux" $shared] {
+    puts [format "%-24s %8d %8d %8d %10.3f %10.1f" $name {*}$r]
+}
@@ -0,0 +1,186 @@
+`timescale 1ns / 1ps
+
+module hsv2rgb_tb;
+
+	/******************************************************************/
+	/* Description									                  */
+	/******************************************************************/
+
+	// Self checking testbench for hsv2rgb against HSVtoRGB() in the
+	// firmware (functional_interface.c), written out again below as
+	// hsv_ref().  Every hue 0 - 511 with every sat and val 0 - 127 is
+	// started back to back, one per clock; sat or val over 100 is expected
+	// to give the result for 100.  Then a run of random colors with random
+	// gaps between the starts.  done must pulse exactly LATENCY clocks
+	// after each start and never otherwise, with red, green and blue equal
+	// to hsv_ref() for that start.
+	//
+	// tools/hsv_exact does the same comparison against a C copy of the
+	// pipeline and HSVtoRGB() itself.
+	//
+	// Run with, for example:
+	//     iverilog -g2005 -o hsv2rgb_tb hsv2rgb_tb.v ../hsv2rgb.v
+	//     vvp hsv2rgb_tb
+	// It prints PASS or FAIL and the number of errors.
+
+	/******************************************************************/
+	/* Local parameters and values		                  	  		  */
+	/******************************************************************/
+
+	localparam integer	LATENCY = 6;			// start to done, hsv2rgb.v
+	localparam integer	RANDOM_STARTS = 100000;
+
+	reg					clk = 1'b0;
+	reg					reset = 1'b1;
+	reg					start = 1'b0;
+	reg		[8:0]		hue = 0;
+	reg		[6:0]		sat = 0;
+	reg		[6:0]		val = 0;
+	wire	[7:0]		red, green, blue;
+	wire				done, busy;
+
+	// Expected results by the cycle they are due in
+	reg		[23:0]		expect_rgb [0:15];
+	reg		[15:0]		expect_done = 16'b0;
+
+	integer				cycle = 0;
+	integer				starts = 0;
+	integer				checked = 0;
+	integer				errors = 0;
+	integer				h, s, v, i;
+
+	/******************************************************************/
+	/* Device under test							                  */
+	/******************************************************************/
+
+	hsv2rgb dut (
+		.clk(clk),
+		.reset(reset),
+		.start(start),
+		.hue(hue),
+		.sat(sat),
+		.val(val),
+		.red(red),
+		.green(green),
+		.blue(blue),
+		.done(done),
+		.busy(busy)
+		);
+
+	always #5 clk = ~clk;					// 100MHz
+
+	/******************************************************************/
+	/* Reference, HSVtoRGB()						                  */
+	/******************************************************************/
+
+	function integer div255;
+		input integer	x;
+		begin
+			div255 = (x + 1 + (x >> 8)) >> 8;
+		end
+	endfunction
+
+	function [23:0] hsv_ref;
+		input integer	hue_in, sat_in, val_in;
+		integer			hh, vv, ss, region, rem, p, q, t;
+		begin
+			hh = (hue_in >= 360) ? hue_in - 360 : hue_in;
+			vv = (val_in * 653) >> 8;
+			ss = (sat_in * 653) >> 8;
+			region = (hh * 1093) >> 16;
+			rem = ((hh - region * 60) * 1105) >> 8;
+			p = div255(vv * (255 - ss));
+			q = div255(vv * (255 - div255(ss * rem)));
+			t = div255(vv * (255 - div255(ss * (255 - rem))));
+			case (region)
+			0:			hsv_ref = {vv[7:0], t[7:0], p[7:0]};
+			1:			hsv_ref = {q[7:0], vv[7:0], p[7:0]};
+			2:			hsv_ref = {p[7:0], vv[7:0], t[7:0]};
+			3:			hsv_ref = {p[7:0], q[7:0], vv[7:0]};
+			4:			hsv_ref = {t[7:0], p[7:0], vv[7:0]};
+			default:	hsv_ref = {vv[7:0], p[7:0], q[7:0]};
+			endcase
+		end
+	endfunction
+
+	/******************************************************************/
+	/* Checker										                  */
+	/******************************************************************/
+
+	always @(posedge clk)
+		cycle <= cycle + 1;
+
+	// Inputs and outputs are stable on the falling edge.  A start seen here
+	// is taken on the next rising edge and its result is out on the falling
+	// edge LATENCY clocks from this one.
+	always @(negedge clk) begin
+		if (done != expect_done[cycle % 16]) begin
+			errors = errors + 1;
+			$display("ERROR cycle %0d: done %b, expected %b", cycle, done,
+					expect_done[cycle % 16]);
+		end
+		if (done && expect_done[cycle % 16]) begin
+			checked = checked + 1;
+			if ({red, green, blue} != expect_rgb[cycle % 16]) begin
+				errors = errors + 1;
+				if (errors < 20)
+					$display("ERROR cycle %0d: rgb %06h, expected %06h", cycle,
+							{red, green, blue}, expect_rgb[cycle % 16]);
+			end
+		end
+		expect_done[cycle % 16] = 1'b0;
+
+		if (start && !reset) begin
+			starts = starts + 1;
+			expect_done[(cycle + LATENCY) % 16] = 1'b1;
+			expect_rgb[(cycle + LATENCY) % 16] = hsv_ref(hue,
+					(sat > 100) ? 100 : sat, (val > 100) ? 100 : val);
+		end
+	end
+
+	/******************************************************************/
+	/* Stimulus									                  */
+	/******************************************************************/
+
+	initial begin
+		repeat (10) @(posedge clk);
+		reset <= 1'b0;
+		repeat (10) @(posedge clk);
+
+		// Every color, back to back
+		for (h = 0; h < 512; h = h + 1)
+			for (s = 0; s < 128; s = s + 1)
+				for (v = 0; v < 128; v = v + 1) begin
+					@(posedge clk);
+					start <= 1'b1;
+					hue <= h;
+					sat <= s;
+					val <= v;
+				end
+		@(posedge clk) start <= 1'b0;
+		repeat (2 * LATENCY) @(posedge clk);
+
+		// Random colors with random gaps
+		for (i = 0; i < RANDOM_STARTS; i = i + 1) begin
+			@(posedge clk);
+			start <= ($random & 3) == 0;
+			hue <= $random;
+			sat <= $random;
+			val <= $random;
+		end
+		@(posedge clk) start <= 1'b0;
+		repeat (2 * LATENCY) @(posedge clk);
+
+		if (busy) begin
+			errors = errors + 1;
+			$display("ERROR busy with nothing in flight");
+		end
+		if (errors == 0 && checked == starts)
+			$display("PASS: %0d conversions checked", checked);
+		else
+			$display("FAIL: %0d errors, %0d of %0d conversions checked", errors,
+					checked, starts);
+		$finish;
+	end
+
+endmodule
@@ -0,0 +1,199 @@
+`timescale 1ns / 1ps
+
+module pwm_detector_mux_tb;
+
+	/******************************************************************/
+	/* Description									                  */
+	/******************************************************************/
+
+	// Equivalence testbench for pwm_detector_mux against three pwm_detector
+	// copies, the two builds of n4fpga.v.  Three PWMs share a carrier of
+	// PERIOD_CLKS with different duty cycles and both implementations
+	// measure them side by side.  Once a period, well away from every
+	// edge, each channel's outputs must agree: the same saturated or
+	// measured state and counts within TOLERANCE.
+	//
+	// Run at every prescale_sel setting, then with channel 0 held low and
+	// channel 2 held high until both are called stuck, then with both
+	// running again.  Last, at prescale 0, the two stuck channels swap
+	// levels, so channel 0 goes from stuck low to stuck high and channel 2
+	// the other way; both must be called stuck at the new level, within
+	// the timeout since no period is known by then.  The periods right
+	// after a prescale change are not compared, pwm_detector measures
+	// again in the new units.
+	//
+	// Run with, for example:
+	//     iverilog -g2005 -o pwm_detector_mux_tb pwm_detector_mux_tb.v \
+	//         ../pwm_detector.v ../pwm_detector_mux.v
+	//     vvp pwm_detector_mux_tb
+	// It prints PASS or FAIL and the number of errors.
+
+	/******************************************************************/
+	/* Local parameters and values		                  	  		  */
+	/******************************************************************/
+
+	localparam integer	PERIOD_CLKS = 20000;	// 200 us carrier
+	localparam integer	HIGH0 = 6000;			// channel high times
+	localparam integer	HIGH1 = 10000;
+	localparam integer	HIGH2 = 15000;
+	localparam integer	SAMPLE_CLKS = 17500;	// compare here, 2500 clocks from any edge
+	localparam integer	SKIP_PERIODS = 3;
+	localparam integer	CHECK_PERIODS = 4;
+	localparam integer	STUCK_PERIODS = 6;		// long enough to be called stuck
+	localparam integer	TOLERANCE = 3;			// counts
+	localparam integer	TIMEOUT_PERIODS = 250000 / 200 + 2;	// PWM_PERIOD_MAX_US in carrier periods
+
+	reg					clk = 1'b0;
+	reg					reset = 1'b1;
+	reg		[2:0]		prescale_sel = 3'd0;
+	reg		[2:0]		pwm = 3'b0;
+	reg		[2:0]		hold_low = 3'b0;		// force a channel off
+	reg		[2:0]		hold_high = 3'b0;		// force a channel on
+	reg					compare = 1'b0;
+	integer				t = 0;					// clock in the carrier period
+
+	wire	[31:0]		det_high [0:2];
+	wire	[31:0]		det_low [0:2];
+	wire	[95:0]		mux_high, mux_low;
+
+	integer				errors = 0;
+	integer				checked = 0;
+	integer				sel, ch;
+
+	/******************************************************************/
+	/* Devices under test							                  */
+	/******************************************************************/
+
+	genvar				g;
+	generate
+		for (g = 0; g < 3; g = g + 1) begin : det
+			pwm_detector dut (
+				.clk(clk),
+				.reset(reset),
+				.pwm_signal(pwm[g]),
+				.prescale_sel(prescale_sel),
+				.high_count(det_high[g]),
+				.low_count(det_low[g])
+				);
+		end
+	endgenerate
+
+	pwm_detector_mux #(
+		.NUM_CHANNELS(3)
+		) mux (
+		.clk(clk),
+		.reset(reset),
+		.pwm_signal(pwm),
+		.prescale_sel(prescale_sel),
+		.high_count(mux_high),
+		.low_count(mux_low)
+		);
+
+	always #5 clk = ~clk;					// 100MHz
+
+	/******************************************************************/
+	/* Stimulus and comparison						                  */
+	/******************************************************************/
+
+	always @(posedge clk) begin
+		t <= (t == PERIOD_CLKS - 1) ? 0 : t + 1;
+		pwm[0] <= hold_high[0] | (~hold_low[0] & (t < HIGH0));
+		pwm[1] <= hold_high[1] | (~hold_low[1] & (t < HIGH1));
+		pwm[2] <= hold_high[2] | (~hold_low[2] & (t < HIGH2));
+	end
+
+	function within;
+		input [31:0]	a, b;
+		begin
+			within = (a > b) ? (a - b <= TOLERANCE) : (b - a <= TOLERANCE);
+		end
+	endfunction
+
+	always @(posedge clk)
+		if (compare && t == SAMPLE_CLKS) begin
+			for (ch = 0; ch < 3; ch = ch + 1) begin
+				checked = checked + 1;
+				if ((det_high[ch] == 0) != (mux_high[ch*32 +: 32] == 0) ||
+						(det_low[ch] == 0) != (mux_low[ch*32 +: 32] == 0) ||
+						!within(det_high[ch], mux_high[ch*32 +: 32]) ||
+						!within(det_low[ch], mux_low[ch*32 +: 32])) begin
+					errors = errors + 1;
+					$display("ERROR prescale %0d channel %0d: pwm_detector %0d/%0d, mux %0d/%0d",
+							prescale_sel, ch, det_high[ch], det_low[ch],
+							mux_high[ch*32 +: 32], mux_low[ch*32 +: 32]);
+				end
+			end
+		end
+
+	task periods;
+		input integer	n;
+		begin
+			repeat (n * PERIOD_CLKS) @(posedge clk);
+		end
+	endtask
+
+	initial begin
+		repeat (10) @(posedge clk);
+		reset <= 1'b0;
+
+		for (sel = 0; sel < 8; sel = sel + 1) begin
+			compare <= 1'b0;
+			prescale_sel <= sel;
+			periods(SKIP_PERIODS);
+			compare <= 1'b1;
+			periods(CHECK_PERIODS);
+		end
+
+		// Stuck low and stuck high, then running again
+		for (sel = 0; sel < 8; sel = sel + 3) begin
+			compare <= 1'b0;
+			prescale_sel <= sel;
+			periods(SKIP_PERIODS);
+			compare <= 1'b1;
+			hold_low <= 3'b001;
+			hold_high <= 3'b100;
+			periods(STUCK_PERIODS);
+			if (det_high[0] != 0 || det_low[0] == 0 || det_high[2] == 0 || det_low[2] != 0) begin
+				errors = errors + 1;
+				$display("ERROR prescale %0d: channels 0 and 2 not called stuck", sel);
+			end
+			hold_low <= 3'b000;
+			hold_high <= 3'b000;
+			periods(CHECK_PERIODS);
+		end
+
+		// Stuck low to stuck high and stuck high to stuck low.  Not compared
+		// on the way, the two may call the new level a few clocks apart.
+		compare <= 1'b0;
+		prescale_sel <= 0;
+		periods(SKIP_PERIODS);
+		hold_low <= 3'b001;
+		hold_high <= 3'b100;
+		periods(STUCK_PERIODS);
+		hold_low <= 3'b100;
+		hold_high <= 3'b001;
+		periods(TIMEOUT_PERIODS);
+		if (det_high[0] == 0 || det_low[0] != 0 || det_high[2] != 0 || det_low[2] == 0 ||
+				mux_high[31:0] == 0 || mux_low[31:0] != 0 ||
+				mux_high[95:64] != 0 || mux_low[95:64] == 0) begin
+			errors = errors + 1;
+			$display("ERROR channels 0 and 2 not called stuck at the other level");
+		end
+		compare <= 1'b1;
+		periods(CHECK_PERIODS);
+		hold_low <= 3'b000;
+		hold_high <= 3'b000;
+		compare <= 1'b0;
+		periods(SKIP_PERIODS);
+		compare <= 1'b1;
+		periods(CHECK_PERIODS);
+
+		if (errors == 0 && checked == 3 * (8 * CHECK_PERIODS + 3 * (STUCK_PERIODS + CHECK_PERIODS) +
+				2 * CHECK_PERIODS))
+			$display("PASS: %0d samples checked", checked);
+		else
+			$display("FAIL: %0d errors in %0d samples", errors, checked);
+		$finish;
+	end
+
+endmodule
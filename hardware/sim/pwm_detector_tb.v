@@ -0,0 +1,187 @@
+`timescale 1ns / 1ps
+
+module pwm_detector_tb;
+
+	/******************************************************************/
+	/* Description									                  */
+	/******************************************************************/
+
+	// Self checking testbench for pwm_detector.  At every prescale_sel
+	// setting a PWM of HIGH_CLKS high and LOW_CLKS low is applied and
+	// every period reported must be HIGH_CLKS and LOW_CLKS in units of
+	// 2^sel clocks, within TOLERANCE counts for the edge uncertainty.
+	// The first two periods after a setting change are skipped, they
+	// were counted partly in the old units.
+	//
+	// Then, at prescale 0, the stuck detection: a short period like the
+	// one a duty change cuts must not get the next normal period called
+	// stuck, and a PWM held low must be reported as stuck low within
+	// STUCK_PERIODS periods of its last edge.  The line is then driven
+	// high and held, and then low and held: each level must be called
+	// stuck in turn, within the timeout since no period is known by then.
+	//
+	// Run with, for example:
+	//     iverilog -g2005 -o pwm_detector_tb pwm_detector_tb.v ../pwm_detector.v
+	//     vvp pwm_detector_tb
+	// It prints PASS or FAIL and the number of errors.
+
+	/******************************************************************/
+	/* Local parameters and values		                  	  		  */
+	/******************************************************************/
+
+	localparam integer	HIGH_CLKS = 6000;		// 35% of a 200 us period, not a power of 2
+	localparam integer	LOW_CLKS = 14000;
+	localparam integer	SKIP_PERIODS = 2;
+	localparam integer	CHECK_PERIODS = 4;
+	localparam integer	TOLERANCE = 2;			// counts
+	localparam integer	STUCK_PERIODS = 2;		// pwm_detector default
+	localparam integer	GLITCH_CLKS = 1000;		// high and low of the short period
+	localparam integer	STUCK_CLKS = STUCK_PERIODS * (HIGH_CLKS + LOW_CLKS) + 4;
+	localparam integer	TIMEOUT_CLKS = 250000 * 100 + 4;	// PWM_PERIOD_MAX_US at 100MHz
+
+	reg					clk = 1'b0;
+	reg					reset = 1'b1;
+	reg					pwm = 1'b0;
+	reg		[2:0]		prescale_sel = 3'd0;
+	reg					pwm_running = 1'b0;	// no stuck pair allowed
+	wire	[31:0]		high_count, low_count;
+
+	integer				errors = 0;
+	integer				checked = 0;
+	integer				sel, n;
+	integer				want_high, want_low;
+	integer				stuck_errors = 0;
+	integer				held;
+
+	/******************************************************************/
+	/* Device under test							                  */
+	/******************************************************************/
+
+	pwm_detector dut (
+		.clk(clk),
+		.reset(reset),
+		.pwm_signal(pwm),
+		.prescale_sel(prescale_sel),
+		.high_count(high_count),
+		.low_count(low_count)
+		);
+
+	always #5 clk = ~clk;					// 100MHz
+
+	// One PWM period, starting with the rising edge
+	task pwm_period;
+		begin
+			@(posedge clk) pwm <= 1'b1;
+			repeat (HIGH_CLKS) @(posedge clk);
+			pwm <= 1'b0;
+			repeat (LOW_CLKS - 1) @(posedge clk);
+		end
+	endtask
+
+	// A short period, high and low GLITCH_CLKS
+	task glitch_period;
+		begin
+			@(posedge clk) pwm <= 1'b1;
+			repeat (GLITCH_CLKS) @(posedge clk);
+			pwm <= 1'b0;
+			repeat (GLITCH_CLKS - 1) @(posedge clk);
+		end
+	endtask
+
+	// Nothing may be called stuck while the PWM is running
+	always @(posedge clk)
+		if (!reset && prescale_sel == 0 && pwm_running &&
+				(high_count == 0) != (low_count == 0)) begin
+			stuck_errors = stuck_errors + 1;
+			$display("ERROR stuck pair high %0d low %0d with the PWM running",
+					high_count, low_count);
+		end
+
+	// Hold the PWM at level and wait up to max_clks for it to be called stuck
+	task hold_stuck;
+		input			level;
+		input integer	max_clks;
+		begin
+			@(posedge clk) pwm <= level;
+			held = 0;
+			while (!(level ? (high_count != 0 && low_count == 0) :
+					(high_count == 0 && low_count != 0)) && held <= max_clks) begin
+				@(posedge clk);
+				held = held + 1;
+			end
+			checked = checked + 1;
+			if (held > max_clks) begin
+				errors = errors + 1;
+				$display("ERROR held %s %0d clocks and not called stuck",
+						level ? "high" : "low", held);
+			end
+		end
+	endtask
+
+	// Counts reported at the rising edge that ended the last period
+	task check_counts;
+		input integer	s;
+		begin
+			// the edge is seen up to 2^s + 2 clocks late
+			repeat ((1 << s) + 4) @(posedge clk);
+			want_high = HIGH_CLKS >> s;
+			want_low = LOW_CLKS >> s;
+			checked = checked + 1;
+			if (high_count > want_high + TOLERANCE || high_count + TOLERANCE < want_high ||
+					low_count > want_low + TOLERANCE || low_count + TOLERANCE < want_low) begin
+				errors = errors + 1;
+				$display("ERROR prescale %0d: high %0d low %0d, expected %0d and %0d",
+						s, high_count, low_count, want_high, want_low);
+			end
+		end
+	endtask
+
+	/******************************************************************/
+	/* Stimulus									                  */
+	/******************************************************************/
+
+	initial begin
+		repeat (10) @(posedge clk);
+		reset <= 1'b0;
+
+		for (sel = 0; sel < 8; sel = sel + 1) begin
+			prescale_sel <= sel;
+			for (n = 0; n < SKIP_PERIODS; n = n + 1)
+				pwm_period;
+			for (n = 0; n < CHECK_PERIODS; n = n + 1) begin
+				fork
+					pwm_period;
+					check_counts(sel);
+				join
+			end
+		end
+
+		// Stuck detection at prescale 0.  One more period is skipped, the
+		// first one after the switch from prescale 7 can be called stuck.
+		prescale_sel <= 0;
+		for (n = 0; n <= SKIP_PERIODS; n = n + 1)
+			pwm_period;
+		pwm_running <= 1'b1;
+		for (n = 0; n < CHECK_PERIODS; n = n + 1)
+			pwm_period;
+		glitch_period;
+		for (n = 0; n < CHECK_PERIODS; n = n + 1)
+			pwm_period;
+		@(posedge clk) pwm <= 1'b1;
+		repeat (HIGH_CLKS) @(posedge clk);
+		pwm_running <= 1'b0;
+		hold_stuck(1'b0, STUCK_CLKS);
+
+		// Stuck low to stuck high and back
+		hold_stuck(1'b1, TIMEOUT_CLKS);
+		hold_stuck(1'b0, TIMEOUT_CLKS);
+		errors = errors + stuck_errors;
+
+		if (errors == 0 && checked == 8 * CHECK_PERIODS + 3)
+			$display("PASS: %0d periods checked", checked);
+		else
+			$display("FAIL: %0d errors in %0d periods", errors, checked);
+		$finish;
+	end
+
+endmodule
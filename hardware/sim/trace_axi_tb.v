@@ -0,0 +1,233 @@
+`timescale 1ns / 1ps
+
+module trace_axi_tb;
+
+	/******************************************************************/
+	/* Description									                  */
+	/******************************************************************/
+
+	// Self checking testbench for trace_axi.  An AXI4-Lite master writes
+	// DATA, SET, CLEAR and TOGGLE the way the firmware does, one write at a
+	// time, with the address and data presented together or apart and the
+	// response taken at once or late.  Each write must be on the trace pins
+	// exactly LATENCY clocks after the clock edge that first sees both
+	// address and data valid, and the pins must not change at any other
+	// time.  DATA is read back after every few writes.
+	//
+	// Run with, for example:
+	//     iverilog -g2005 -o trace_axi_tb trace_axi_tb.v ../trace_axi.v
+	//     vvp trace_axi_tb
+	// It prints PASS or FAIL and the number of errors.
+
+	/******************************************************************/
+	/* Local parameters and values		                  	  		  */
+	/******************************************************************/
+
+	localparam integer	LATENCY = 1;			// clocks from write to pin
+	localparam integer	WRITES = 4000;
+
+	localparam [3:0]	REG_DATA = 4'h0,
+						REG_SET = 4'h4,
+						REG_CLEAR = 4'h8,
+						REG_TOGGLE = 4'hC;
+
+	reg					clk = 1'b0;
+	reg					aresetn = 1'b0;
+	reg		[11:0]		awaddr = 0, araddr = 0;
+	reg					awvalid = 1'b0, wvalid = 1'b0, bready = 1'b0;
+	reg					arvalid = 1'b0, rready = 1'b0;
+	reg		[31:0]		wdata = 0;
+	wire				awready, wready, bvalid, arready, rvalid;
+	wire	[1:0]		bresp, rresp;
+	wire	[31:0]		rdata;
+	wire	[7:0]		trace;
+
+	reg		[7:0]		model = 8'b0;			// what the pins should show
+	reg		[7:0]		shown = 8'b0;			// the pins at the last check
+	integer				due = -1;				// cycle the last write is due on the pins
+	reg		[7:0]		due_value;
+
+	integer				cycle = 0;
+	integer				checked = 0;
+	integer				errors = 0;
+	integer				i;
+
+	/******************************************************************/
+	/* Device under test							                  */
+	/******************************************************************/
+
+	trace_axi dut (
+		.s_axi_aclk(clk),
+		.s_axi_aresetn(aresetn),
+		.s_axi_awaddr(awaddr),
+		.s_axi_awvalid(awvalid),
+		.s_axi_awready(awready),
+		.s_axi_wdata(wdata),
+		.s_axi_wstrb(4'hF),
+		.s_axi_wvalid(wvalid),
+		.s_axi_wready(wready),
+		.s_axi_bresp(bresp),
+		.s_axi_bvalid(bvalid),
+		.s_axi_bready(bready),
+		.s_axi_araddr(araddr),
+		.s_axi_arvalid(arvalid),
+		.s_axi_arready(arready),
+		.s_axi_rdata(rdata),
+		.s_axi_rresp(rresp),
+		.s_axi_rvalid(rvalid),
+		.s_axi_rready(rready),
+		.trace(trace)
+		);
+
+	always #5 clk = ~clk;					// 100MHz
+
+	/******************************************************************/
+	/* Pin checker									                  */
+	/******************************************************************/
+
+	always @(posedge clk)
+		cycle <= cycle + 1;
+
+	// Outputs are stable on the falling edge
+	always @(negedge clk)
+		if (aresetn) begin
+			if (cycle == due) begin
+				checked = checked + 1;
+				if (trace != due_value) begin
+					errors = errors + 1;
+					$display("ERROR cycle %0d: trace %02h, expected %02h %0d clocks after the write",
+							cycle, trace, due_value, LATENCY);
+				end
+			end
+			else if (trace != shown) begin
+				errors = errors + 1;
+				$display("ERROR cycle %0d: trace went from %02h to %02h with no write due",
+						cycle, shown, trace);
+			end
+			shown = trace;
+		end
+
+	/******************************************************************/
+	/* AXI4-Lite master								                  */
+	/******************************************************************/
+
+	// One write.  w_delay clocks between the address and the data (the data
+	// first if negative), b_delay clocks before the response is taken.
+	task write;
+		input [3:0]		addr;
+		input [7:0]		data;
+		input integer	w_delay;
+		input integer	b_delay;
+		begin
+			case (addr)
+			REG_DATA:	model = data;
+			REG_SET:	model = model | data;
+			REG_CLEAR:	model = model & ~data;
+			REG_TOGGLE:	model = model ^ data;
+			endcase
+
+			@(posedge clk);
+			if (w_delay >= 0) begin
+				awaddr <= addr;
+				awvalid <= 1'b1;
+				repeat (w_delay) @(posedge clk);
+				wdata <= {$random, data};
+				wvalid <= 1'b1;
+			end else begin
+				wdata <= {$random, data};
+				wvalid <= 1'b1;
+				repeat (-w_delay) @(posedge clk);
+				awaddr <= addr;
+				awvalid <= 1'b1;
+			end
+			// Both are seen on the next edge, cycle still reads this one
+			due = cycle + 1 + LATENCY;
+			due_value = model;
+
+			@(posedge clk);
+			while (!(awready && wready))
+				@(posedge clk);
+			awvalid <= 1'b0;
+			wvalid <= 1'b0;
+
+			repeat (b_delay) @(posedge clk);
+			bready <= 1'b1;
+			@(posedge clk);
+			while (!bvalid)
+				@(posedge clk);
+			bready <= 1'b0;
+			if (bresp != 2'b00) begin
+				errors = errors + 1;
+				$display("ERROR write response %b", bresp);
+			end
+		end
+	endtask
+
+	task read_check;
+		begin
+			@(posedge clk);
+			araddr <= REG_DATA;
+			arvalid <= 1'b1;
+			@(posedge clk);
+			while (!arready)
+				@(posedge clk);
+			arvalid <= 1'b0;
+			rready <= 1'b1;
+			while (!rvalid)
+				@(posedge clk);
+			@(posedge clk);
+			rready <= 1'b0;
+			if (rdata != {24'b0, model} || rresp != 2'b00) begin
+				errors = errors + 1;
+				$display("ERROR read DATA %08h, expected %08h", rdata, {24'b0, model});
+			end
+		end
+	endtask
+
+	/******************************************************************/
+	/* Stimulus									                  */
+	/******************************************************************/
+
+	initial begin
+		repeat (10) @(posedge clk);
+		aresetn <= 1'b1;
+		repeat (2) @(posedge clk);
+		if (trace != 8'h00) begin
+			errors = errors + 1;
+			$display("ERROR trace %02h after reset", trace);
+		end
+
+		// The firmware's pattern: back to back, response taken at once
+		write(REG_DATA, 8'hA5, 0, 0);
+		write(REG_SET, 8'h01, 0, 0);
+		write(REG_CLEAR, 8'h01, 0, 0);
+		write(REG_TOGGLE, 8'h80, 0, 0);
+		write(REG_TOGGLE, 8'h80, 0, 0);
+		write(REG_SET, 8'h00, 0, 0);			// nothing changes on the pins
+		read_check;
+
+		// Address and data apart, late responses
+		write(REG_DATA, 8'h3C, 3, 0);
+		write(REG_SET, 8'hC0, -2, 0);
+		write(REG_CLEAR, 8'h0C, 0, 5);
+		write(REG_TOGGLE, 8'hFF, 1, 2);
+		read_check;
+
+		for (i = 0; i < WRITES; i = i + 1) begin
+			write({$random} % 4 * 4, $random, ({$random} % 5) - 2,
+					({$random} % 4 == 0) ? {$random} % 4 : 0);
+			if (i % 16 == 0)
+				read_check;
+		end
+		read_check;
+		repeat (10) @(posedge clk);
+
+		if (errors == 0 && checked == WRITES + 10)
+			$display("PASS: %0d writes checked", checked);
+		else
+			$display("FAIL: %0d errors, %0d of %0d writes checked", errors,
+					checked, WRITES + 10);
+		$finish;
+	end
+
+endmodule
@@ -0,0 +1,194 @@
+`timescale 1ns / 1ps
+
+module ws2812_tb;
+
+	/******************************************************************/
+	/* Description									                  */
+	/******************************************************************/
+
+	// Self checking testbench for the ws2812 serializer.  Frames are sent
+	// from a frame buffer model and the serial line is decoded as a strip
+	// would see it.  Every bit must be high for exactly T0H or T1H clocks,
+	// one bit must follow the last every TBIT clocks within a frame, the
+	// line must stay low for at least TRESET clocks between frames, and
+	// the decoded pixels must be the frame buffer words from base on, MSB
+	// first.  busy and frame_done are checked against the frame length.
+	//
+	// Run with, for example:
+	//     iverilog -g2005 -o ws2812_tb ws2812_tb.v ../ws2812.v
+	//     vvp ws2812_tb
+	// It prints PASS or FAIL and the number of errors.
+
+	/******************************************************************/
+	/* Local parameters and values		                  	  		  */
+	/******************************************************************/
+
+	localparam integer	T0H = 40;				// clocks at 100MHz, the ws2812 defaults
+	localparam integer	T1H = 80;
+	localparam integer	TBIT = 125;
+	localparam integer	TRESET = 28000;
+	localparam integer	OVERHEAD = 4;			// clocks from start to the first bit
+	localparam integer	ADDR_WIDTH = 10;
+
+	reg					clk = 1'b0;
+	reg					reset = 1'b1;
+	reg					start = 1'b0;
+	reg		[ADDR_WIDTH-1:0]	base = 0;
+	reg		[ADDR_WIDTH-1:0]	num_pixels = 0;
+	wire	[ADDR_WIDTH-1:0]	rd_addr;
+	reg		[23:0]		rd_data;
+	wire				dout, busy, frame_done;
+
+	reg		[23:0]		mem [0:(1 << ADDR_WIDTH) - 1];
+
+	integer				cycle = 0;
+	integer				rise_cycle = -1;		// last rising edge
+	integer				fall_cycle = -1;		// last falling edge
+	integer				start_cycle;
+	integer				high;
+	reg					dout_q = 1'b0;
+	reg					in_frame = 1'b0;		// between the first and last bit of a frame
+	reg		[23:0]		word;
+	integer				nbits = 0;				// bits decoded in this frame
+	integer				npixels = 0;			// pixels checked in this frame
+	integer				errors = 0;
+	integer				frames = 0;
+	integer				i;
+
+	/******************************************************************/
+	/* Device under test							                  */
+	/******************************************************************/
+
+	ws2812 #(
+		.ADDR_WIDTH(ADDR_WIDTH)
+		) dut (
+		.clk(clk),
+		.reset(reset),
+		.start(start),
+		.base(base),
+		.num_pixels(num_pixels),
+		.rd_addr(rd_addr),
+		.rd_data(rd_data),
+		.dout(dout),
+		.busy(busy),
+		.frame_done(frame_done)
+		);
+
+	always #5 clk = ~clk;					// 100MHz
+
+	// Frame buffer, one clock read latency like the block RAM
+	always @(posedge clk)
+		rd_data <= mem[rd_addr];
+
+	/******************************************************************/
+	/* Line decoder									                  */
+	/******************************************************************/
+
+	always @(posedge clk) begin
+		cycle = cycle + 1;
+		dout_q <= dout;
+
+		if (dout && !dout_q) begin			// a bit starts
+			if (in_frame && cycle - rise_cycle != TBIT) begin
+				errors = errors + 1;
+				$display("ERROR bit %0d of frame %0d starts %0d clocks after the last, expected %0d",
+						nbits, frames, cycle - rise_cycle, TBIT);
+			end
+			if (!in_frame && fall_cycle >= 0 && cycle - fall_cycle < TRESET) begin
+				errors = errors + 1;
+				$display("ERROR frame %0d starts %0d clocks after the last bit, reset time is %0d",
+						frames, cycle - fall_cycle, TRESET);
+			end
+			in_frame = 1'b1;
+			rise_cycle = cycle;
+		end
+
+		if (!dout && dout_q) begin			// the bit value is in its high time
+			fall_cycle = cycle;
+			high = cycle - rise_cycle;
+			if (high != T0H && high != T1H) begin
+				errors = errors + 1;
+				$display("ERROR bit %0d of frame %0d high %0d clocks, expected %0d or %0d",
+						nbits, frames, high, T0H, T1H);
+			end
+			word = {word[22:0], high > (T0H + T1H) / 2};
+			nbits = nbits + 1;
+			if (nbits % 24 == 0) begin
+				if (word != mem[base + npixels]) begin
+					errors = errors + 1;
+					$display("ERROR frame %0d pixel %0d: %06h, expected %06h",
+							frames, npixels, word, mem[base + npixels]);
+				end
+				npixels = npixels + 1;
+				if (npixels == num_pixels)
+					in_frame = 1'b0;
+			end
+		end
+	end
+
+	/******************************************************************/
+	/* Stimulus									                  */
+	/******************************************************************/
+
+	// Send a frame and check its length and the handshake
+	task send;
+		input [ADDR_WIDTH-1:0]	b;
+		input [ADDR_WIDTH-1:0]	n;
+		begin
+			base <= b;
+			num_pixels <= n;
+			nbits = 0;
+			npixels = 0;
+			@(posedge clk) start <= 1'b1;
+			@(posedge clk) start <= 1'b0;
+			start_cycle = cycle;
+			@(posedge clk);
+			if (!busy) begin
+				errors = errors + 1;
+				$display("ERROR frame %0d: not busy after start", frames);
+			end
+			@(posedge frame_done);
+			if (cycle - start_cycle > n * 24 * TBIT + TRESET + OVERHEAD ||
+					cycle - start_cycle < n * 24 * TBIT + TRESET) begin
+				errors = errors + 1;
+				$display("ERROR frame %0d took %0d clocks, expected %0d",
+						frames, cycle - start_cycle, n * 24 * TBIT + TRESET);
+			end
+			if (npixels != n) begin
+				errors = errors + 1;
+				$display("ERROR frame %0d: %0d pixels, expected %0d", frames, npixels, n);
+			end
+			@(posedge clk);
+			if (busy || dout) begin
+				errors = errors + 1;
+				$display("ERROR frame %0d: busy or line high after frame_done", frames);
+			end
+			frames = frames + 1;
+		end
+	endtask
+
+	initial begin
+		for (i = 0; i < (1 << ADDR_WIDTH); i = i + 1)
+			mem[i] = (i * 24'h9E3779) ^ 24'h5A5A5A;
+		mem[16] = 24'hFFFFFF;
+		mem[17] = 24'h000000;
+		mem[18] = 24'hA5C30F;
+		mem[19] = 24'h800001;
+
+		repeat (10) @(posedge clk);
+		reset <= 1'b0;
+		repeat (10) @(posedge clk);
+
+		send(16, 4);						// all ones, all zeros and mixed
+		send(512, 1);						// the other bank, one pixel
+		send(1000, 24);						// to the end of the buffer
+		send(0, 3);
+
+		if (errors == 0 && frames == 4)
+			$display("PASS: %0d frames checked", frames);
+		else
+			$display("FAIL: %0d errors in %0d frames", errors, frames);
+		$finish;
+	end
+
+endmodule
@@ -0,0 +1,146 @@
+module trace_axi #(
+
+	/******************************************************************/
+	/* Parameter declarations						                  */
+	/******************************************************************/
+
+	parameter integer	C_S_AXI_ADDR_WIDTH = 12)	// 4KB register window
+
+	/******************************************************************/
+	/* Port declarations							                  */
+	/******************************************************************/
+
+	(
+	// AXI4-Lite slave, exported from the embedded system
+	input						s_axi_aclk,
+	input						s_axi_aresetn,
+	input	[C_S_AXI_ADDR_WIDTH-1:0]	s_axi_awaddr,
+	input						s_axi_awvalid,
+	output reg					s_axi_awready,
+	input	[31:0]				s_axi_wdata,
+	input	[3:0]				s_axi_wstrb,
+	input						s_axi_wvalid,
+	output reg					s_axi_wready,
+	output	[1:0]				s_axi_bresp,
+	output reg					s_axi_bvalid,
+	input						s_axi_bready,
+	input	[C_S_AXI_ADDR_WIDTH-1:0]	s_axi_araddr,
+	input						s_axi_arvalid,
+	output reg					s_axi_arready,
+	output reg	[31:0]			s_axi_rdata,
+	output	[1:0]				s_axi_rresp,
+	output reg					s_axi_rvalid,
+	input						s_axi_rready,
+
+	(* IOB = "TRUE" *)
+	output reg	[7:0]			trace);		// to the pins, straight from the IOB flops
+
+	/******************************************************************/
+	/* Description									                  */
+	/******************************************************************/
+
+	// Eight firmware controlled trace bits for a logic analyzer.  Register
+	// map (32-bit words):
+	//
+	//   0x0  DATA    RW: all eight bits
+	//   0x4  SET     W: the 1 bits go high
+	//   0x8  CLEAR   W: the 1 bits go low
+	//   0xC  TOGGLE  W: the 1 bits change
+	//
+	// SET, CLEAR and TOGGLE only touch their own bits, so the FIT handler
+	// and the main loop never need a read-modify-write.  The trace flops
+	// are in the IOBs and are loaded on the clock edge that accepts the
+	// write, so a bit reaches its pin a fixed clock after the AXI write
+	// handshake, whatever else the design is doing.  bits is the copy the
+	// logic works from, the IOB flops only drive the pins.
+
+	/******************************************************************/
+	/* Local parameters and values		                  	  		  */
+	/******************************************************************/
+
+	localparam [3:0]	REG_DATA = 4'h0,
+						REG_SET = 4'h4,
+						REG_CLEAR = 4'h8,
+						REG_TOGGLE = 4'hC;
+
+	wire							reset = ~s_axi_aresetn;
+
+	reg			[7:0]				bits, next_bits;
+
+	assign s_axi_bresp = 2'b00;
+	assign s_axi_rresp = 2'b00;
+
+	/******************************************************************/
+	/* AXI write channel							                  */
+	/******************************************************************/
+
+	always@(*) begin
+		case (s_axi_awaddr[3:0])
+		REG_DATA:	next_bits = s_axi_wdata[7:0];
+		REG_SET:	next_bits = bits | s_axi_wdata[7:0];
+		REG_CLEAR:	next_bits = bits & ~s_axi_wdata[7:0];
+		REG_TOGGLE:	next_bits = bits ^ s_axi_wdata[7:0];
+		default:	next_bits = bits;
+		endcase
+	end
+
+	// Address and data are accepted together, one write at a time
+	always@(posedge s_axi_aclk) begin
+
+		if (reset) begin
+			s_axi_awready <= 1'b0;
+			s_axi_wready <= 1'b0;
+			s_axi_bvalid <= 1'b0;
+			bits <= 8'b0;
+			trace <= 8'b0;
+		end
+
+		else
+		begin
+			s_axi_awready <= 1'b0;
+			s_axi_wready <= 1'b0;
+
+			if (s_axi_awvalid && s_axi_wvalid && !s_axi_awready && !s_axi_bvalid) begin
+				s_axi_awready <= 1'b1;
+				s_axi_wready <= 1'b1;
+				s_axi_bvalid <= 1'b1;
+
+				bits <= next_bits;
+				trace <= next_bits;
+			end
+			else if (s_axi_bvalid && s_axi_bready) begin
+				s_axi_bvalid <= 1'b0;
+			end
+		end
+
+	end
+
+	/******************************************************************/
+	/* AXI read channel								                  */
+	/******************************************************************/
+
+	always@(posedge s_axi_aclk) begin
+
+		if (reset) begin
+			s_axi_arready <= 1'b0;
+			s_axi_rvalid <= 1'b0;
+			s_axi_rdata <= 32'b0;
+		end
+
+		else
+		begin
+			s_axi_arready <= 1'b0;
+
+			if (s_axi_arvalid && !s_axi_arready && !s_axi_rvalid) begin
+				s_axi_arready <= 1'b1;
+				s_axi_rvalid <= 1'b1;
+				s_axi_rdata <= {24'b0, bits};
+			end
+			else if (s_axi_rvalid && s_axi_rready) begin
+				s_axi_rvalid <= 1'b0;
+			end
+		end
+
+	end
+
+endmodule
@@ -0,0 +1,174 @@
+module ws2812 #(
+
+	/******************************************************************/
+	/* Parameter declarations						                  */
+	/******************************************************************/
+
+	// Define some timing parameters, WS2812B datasheet values
+
+	parameter integer 	CLK_FREQUENCY_HZ = 100000000,
+	parameter integer	T0H_NS = 400,			// '0' bit high time
+	parameter integer	T1H_NS = 800,			// '1' bit high time
+	parameter integer	TBIT_NS = 1250,			// bit period
+	parameter integer	TRESET_NS = 280000,		// low time that latches the frame (>= 50us on the older parts)
+	parameter integer	ADDR_WIDTH = 10)		// frame buffer address width
+
+	/******************************************************************/
+	/* Port declarations							                  */
+	/******************************************************************/
+
+	(
+	input 						clk,			// 100MHz system clock
+	input 			 			reset,			// active-high reset
+	input						start,			// pulse: send a frame
+	input		[ADDR_WIDTH-1:0]	base,		// frame buffer address of pixel 0
+	input		[ADDR_WIDTH-1:0]	num_pixels,	// pixels in the frame, 1 or more
+
+	output reg	[ADDR_WIDTH-1:0]	rd_addr,	// frame buffer read port,
+	input		[23:0]			rd_data,		// data one clock after rd_addr, {G, R, B}
+
+	output reg					dout,			// serial data to the strip
+	output						busy,			// sending a frame or the reset time
+	output reg					frame_done);	// pulse: frame sent and latched
+
+	/******************************************************************/
+	/* Description									                  */
+	/******************************************************************/
+
+	// Streams num_pixels 24-bit words from the frame buffer, MSB first,
+	// with the WS2812 one wire bit timing, then holds the line low for
+	// TRESET_NS so the strip latches the frame.  The next pixel is read
+	// while the current one is shifted out, so there is no gap between
+	// pixels and the CPU is not involved once start is pulsed.
+	//
+	// A frame takes num_pixels * 24 * TBIT_NS + TRESET_NS, e.g. 15.6ms
+	// (64 frames/s) for 512 pixels.
+
+	/******************************************************************/
+	/* Local parameters and values		                  	  		  */
+	/******************************************************************/
+
+	localparam integer	CLKS_PER_US = CLK_FREQUENCY_HZ / 1000000;
+	localparam integer	T0H = T0H_NS * CLKS_PER_US / 1000;
+	localparam integer	T1H = T1H_NS * CLKS_PER_US / 1000;
+	localparam integer	TBIT = TBIT_NS * CLKS_PER_US / 1000;
+	localparam integer	TRESET = TRESET_NS / 1000 * CLKS_PER_US;
+	localparam integer	TIMER_WIDTH = $clog2(TRESET + 1);
+
+	localparam [1:0]	S_IDLE = 2'd0,			// waiting for start
+						S_FETCH = 2'd1,			// reading the first pixel
+						S_BITS = 2'd2,			// shifting out pixels
+						S_LATCH = 2'd3;			// reset time
+
+	reg			[1:0]				state;
+	reg			[TIMER_WIDTH-1:0]	timer;		// clocks into the bit or reset time
+	reg			[23:0]				shift;		// pixel being sent
+	reg			[23:0]				next;		// pixel after it
+	reg			[4:0]				bitnum;		// bits left in shift
+	reg			[ADDR_WIDTH-1:0]	left;		// pixels left after the one in shift
+	reg								next_valid;	// rd_data has been captured into next
+
+	assign busy = (state != S_IDLE);
+
+	/******************************************************************/
+	/* Serializer									                  */
+	/******************************************************************/
+
+	always@(posedge clk) begin
+
+		frame_done <= 1'b0;
+
+		if (reset) begin					// check for synchronous reset
+
+			state <= S_IDLE;
+			dout <= 1'b0;
+			timer <= 0;
+			rd_addr <= 0;
+			next_valid <= 1'b0;
+
+		end
+
+		else
+		begin
+			case (state)
+
+			S_IDLE:
+			begin
+				dout <= 1'b0;
+				if (start && num_pixels != 0) begin
+					rd_addr <= base;
+					left <= num_pixels - 1;
+					timer <= 0;
+					state <= S_FETCH;
+				end
+			end
+
+			S_FETCH:						// rd_data is valid the clock after rd_addr
+			begin
+				if (timer == 1) begin
+					shift <= rd_data;
+					bitnum <= 23;
+					rd_addr <= rd_addr + 1;
+					next_valid <= 1'b0;
+					timer <= 0;
+					dout <= 1'b1;
+					state <= S_BITS;
+				end
+				else begin
+					timer <= timer + 1;
+				end
+			end
+
+			S_BITS:
+			begin
+				// capture the prefetched pixel once, any time in the first bit
+				if (!next_valid && timer == 1) begin
+					next <= rd_data;
+					next_valid <= 1'b1;
+				end
+
+				if (timer == TBIT - 1) begin
+					timer <= 0;
+					if (bitnum != 0) begin
+						bitnum <= bitnum - 1;
+						shift <= {shift[22:0], 1'b0};
+						dout <= 1'b1;
+					end
+					else if (left != 0) begin
+						shift <= next;
+						bitnum <= 23;
+						left <= left - 1;
+						rd_addr <= rd_addr + 1;
+						next_valid <= 1'b0;
+						dout <= 1'b1;
+					end
+					else begin
+						dout <= 1'b0;
+						state <= S_LATCH;
+					end
+				end
+				else begin
+					timer <= timer + 1;
+					if (timer == (shift[23] ? T1H : T0H) - 1)
+						dout <= 1'b0;
+				end
+			end
+
+			S_LATCH:
+			begin
+				dout <= 1'b0;
+				if (timer == TRESET - 1) begin
+					frame_done <= 1'b1;
+					state <= S_IDLE;
+				end
+				else begin
+					timer <= timer + 1;
+				end
+			end
+
+			endcase
+		end
+
+	end
+
+endmodule
@@ -0,0 +1,227 @@
+module ws2812_axi #(
+
+	/******************************************************************/
+	/* Parameter declarations						                  */
+	/******************************************************************/
+
+	parameter integer 	CLK_FREQUENCY_HZ = 100000000,
+	parameter integer	MAX_PIXELS = 512,			// pixels per frame buffer bank, power of 2
+	parameter integer	C_S_AXI_ADDR_WIDTH = 13)	// 8KB register window
+
+	/******************************************************************/
+	/* Port declarations							                  */
+	/******************************************************************/
+
+	(
+	// AXI4-Lite slave, exported from the embedded system
+	input						s_axi_aclk,
+	input						s_axi_aresetn,
+	input	[C_S_AXI_ADDR_WIDTH-1:0]	s_axi_awaddr,
+	input						s_axi_awvalid,
+	output reg					s_axi_awready,
+	input	[31:0]				s_axi_wdata,
+	input	[3:0]				s_axi_wstrb,
+	input						s_axi_wvalid,
+	output reg					s_axi_wready,
+	output	[1:0]				s_axi_bresp,
+	output reg					s_axi_bvalid,
+	input						s_axi_bready,
+	input	[C_S_AXI_ADDR_WIDTH-1:0]	s_axi_araddr,
+	input						s_axi_arvalid,
+	output reg					s_axi_arready,
+	output reg	[31:0]			s_axi_rdata,
+	output	[1:0]				s_axi_rresp,
+	output reg					s_axi_rvalid,
+	input						s_axi_rready,
+
+	output						ws2812_dout);	// serial data to the strip
+
+	/******************************************************************/
+	/* Description									                  */
+	/******************************************************************/
+
+	// WS2812 strip engine with a double buffered frame buffer in block RAM.
+	// The firmware fills the bank that is not being sent, then writes CTRL
+	// with the bank and the start bit.  Register map (32-bit words):
+	//
+	//   0x0000  CTRL        W: bit 0 start, bit 1 bank to send
+	//                       R: bit 0 busy, bit 1 bank being sent
+	//   0x0004  NUM_PIXELS  RW: pixels per frame, 1 to MAX_PIXELS
+	//   0x0008  FRAMES      R: frames sent since reset
+	//   0x000C  FRAME_CLKS  R: clocks from start to latch of the last frame
+	//   0x1000  PIXELS      W: bank 0 pixel i at 0x1000 + 4i, 0x00RRGGBB
+	//   0x1000 + 4*MAX_PIXELS  bank 1
+	//
+	// The pixels are stored in the GRB order the strip expects.  A start
+	// while busy is ignored, so poll CTRL before switching banks.
+
+	/******************************************************************/
+	/* Local parameters and values		                  	  		  */
+	/******************************************************************/
+
+	localparam integer	PIX_WIDTH = $clog2(MAX_PIXELS);
+	localparam integer	ADDR_WIDTH = PIX_WIDTH + 1;		// bank + pixel
+
+	localparam [3:0]	REG_CTRL = 4'h0,
+						REG_NUM_PIXELS = 4'h4,
+						REG_FRAMES = 4'h8,
+						REG_FRAME_CLKS = 4'hC;
+
+	wire							reset = ~s_axi_aresetn;
+
+	(* ram_style = "block" *)
+	reg			[23:0]				frame_buf [0:(2*MAX_PIXELS)-1];
+	wire		[ADDR_WIDTH-1:0]	rd_addr;
+	reg			[23:0]				rd_data;
+
+	reg			[C_S_AXI_ADDR_WIDTH-1:0]	awaddr;
+	reg								start;
+	reg								bank;
+	reg			[ADDR_WIDTH-1:0]	num_pixels;
+	reg			[31:0]				frames;
+	reg			[31:0]				frame_clks, clk_count;
+	wire							busy, frame_done;
+
+	assign s_axi_bresp = 2'b00;
+	assign s_axi_rresp = 2'b00;
+
+	/******************************************************************/
+	/* AXI write channel							                  */
+	/******************************************************************/
+
+	// Address and data are accepted together, one write at a time
+	always@(posedge s_axi_aclk) begin
+
+		start <= 1'b0;
+
+		if (reset) begin
+			s_axi_awready <= 1'b0;
+			s_axi_wready <= 1'b0;
+			s_axi_bvalid <= 1'b0;
+			bank <= 1'b0;
+			num_pixels <= 1;
+		end
+
+		else
+		begin
+			s_axi_awready <= 1'b0;
+			s_axi_wready <= 1'b0;
+
+			if (s_axi_awvalid && s_axi_wvalid && !s_axi_awready && !s_axi_bvalid) begin
+				s_axi_awready <= 1'b1;
+				s_axi_wready <= 1'b1;
+				s_axi_bvalid <= 1'b1;
+
+				if (s_axi_awaddr[12]) begin
+					// pixel write, 0x00RRGGBB is stored as {G, R, B}
+					frame_buf[s_axi_awaddr[ADDR_WIDTH+1:2]] <=
+							{s_axi_wdata[15:8], s_axi_wdata[23:16], s_axi_wdata[7:0]};
+				end
+				else begin
+					case (s_axi_awaddr[3:0])
+					REG_CTRL:
+						if (s_axi_wdata[0] && !busy) begin
+							bank <= s_axi_wdata[1];
+							start <= 1'b1;
+						end
+					REG_NUM_PIXELS:
+						if (s_axi_wdata != 0 && s_axi_wdata <= MAX_PIXELS)
+							num_pixels <= s_axi_wdata[ADDR_WIDTH-1:0];
+					default:
+						;
+					endcase
+				end
+			end
+			else if (s_axi_bvalid && s_axi_bready) begin
+				s_axi_bvalid <= 1'b0;
+			end
+		end
+
+	end
+
+	/******************************************************************/
+	/* AXI read channel								                  */
+	/******************************************************************/
+
+	always@(posedge s_axi_aclk) begin
+
+		if (reset) begin
+			s_axi_arready <= 1'b0;
+			s_axi_rvalid <= 1'b0;
+			s_axi_rdata <= 32'b0;
+		end
+
+		else
+		begin
+			s_axi_arready <= 1'b0;
+
+			if (s_axi_arvalid && !s_axi_arready && !s_axi_rvalid) begin
+				s_axi_arready <= 1'b1;
+				s_axi_rvalid <= 1'b1;
+				if (s_axi_araddr[12])
+					s_axi_rdata <= 32'b0;			// the frame buffer is write only
+				else
+					case (s_axi_araddr[3:0])
+					REG_CTRL:		s_axi_rdata <= {30'b0, bank, busy};
+					REG_NUM_PIXELS:	s_axi_rdata <= num_pixels;
+					REG_FRAMES:		s_axi_rdata <= frames;
+					REG_FRAME_CLKS:	s_axi_rdata <= frame_clks;
+					default:		s_axi_rdata <= 32'b0;
+					endcase
+			end
+			else if (s_axi_rvalid && s_axi_rready) begin
+				s_axi_rvalid <= 1'b0;
+			end
+		end
+
+	end
+
+	/******************************************************************/
+	/* Frame buffer read port and serializer		                  */
+	/******************************************************************/
+
+	always@(posedge s_axi_aclk) begin
+		rd_data <= frame_buf[rd_addr];
+	end
+
+	ws2812 #(
+		.CLK_FREQUENCY_HZ(CLK_FREQUENCY_HZ),
+		.ADDR_WIDTH(ADDR_WIDTH)
+		) serializer (
+		.clk(s_axi_aclk),
+		.reset(reset),
+		.start(start),
+		.base({bank, {PIX_WIDTH{1'b0}}}),
+		.num_pixels(num_pixels),
+		.rd_addr(rd_addr),
+		.rd_data(rd_data),
+		.dout(ws2812_dout),
+		.busy(busy),
+		.frame_done(frame_done)
+		);
+
+	// Frame statistics for the firmware
+	always@(posedge s_axi_aclk) begin
+
+		if (reset) begin
+			frames <= 32'b0;
+			frame_clks <= 32'b0;
+			clk_count <= 32'b0;
+		end
+
+		else
+		begin
+			if (start)
+				clk_count <= 32'b0;
+			else if (busy)
+				clk_count <= clk_count + 1;
+
+			if (frame_done) begin
+				frames <= frames + 1;
+				frame_clks <= clk_count;
+			end
+		end
+
+	end
+
+endmodule
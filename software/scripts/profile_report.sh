@@ -0,0 +1,96 @@
+#!/bin/sh
+## profile_report.sh
+##
+## Code size and main loop time of each build profile (see build_config.h)
+## as one table.
+##
+## Sizes: every profile is compiled and linked with the MicroBlaze tools
+## against the standalone BSP and lscript.ld, and mb-size is run on each
+## image.  text includes the vectors, data the rodata, bss the heap and the
+## stack; total is given against the 128 KB of BRAM.
+##
+## Loop time needs the board.  Run each profile until the exit button with
+## the UART captured to a file, and pass the captures.  The
+## "Main loop (<profile> build)" line printed at exit gives the passes and
+## the average and longest pass in 100 MHz timer ticks, shown here in us.
+##
+## Run from this directory with:
+##     ./profile_report.sh -b <bsp>/microblaze_0 [uart_capture ...]
+## where <bsp> is the BSP project in the SDK workspace.  Either part can be
+## left out: no -b gives loop times only, no captures sizes only.  Set
+## MB_CFLAGS to the CPU flags in the application's C/C++ build settings if
+## they differ from the default below.  The images are left in
+## ./profile_report/.
+
+SRC=../src
+OUT=profile_report
+CROSS=${CROSS:-mb-}
+MB_CFLAGS=${MB_CFLAGS:--mlittle-endian -mcpu=v10.0 -mxl-soft-mul}
+
+usage() {
+    echo "usage: $0 [-b bsp_dir] [uart_capture ...]" >&2
+    exit 2
+}
+
+bsp=
+while getopts b: opt; do
+    case $opt in
+    b)  bsp=$OPTARG ;;
+    *)  usage ;;
+    esac
+done
+shift $((OPTIND - 1))
+[ -z "$bsp" ] && [ $# -eq 0 ] && usage
+
+mkdir -p $OUT
+: > $OUT/sizes.txt
+if [ -n "$bsp" ]; then
+    for p in 0 1 2 3; do
+        ${CROSS}gcc -O2 $MB_CFLAGS -DBUILD_PROFILE=$p -I$SRC -I"$bsp/include" \
+            -L"$bsp/lib" -Wl,-T,$SRC/lscript.ld -o $OUT/profile$p.elf $SRC/*.c \
+            -Wl,--start-group,-lxil,-lgcc,-lc,--end-group || exit 1
+        ${CROSS}size $OUT/profile$p.elf | awk -v p=$p 'NR == 2 { print p, $1, $2, $3 }' \
+            >> $OUT/sizes.txt
+    done
+fi
+
+# The profile numbers and BUILD_PROFILE_NAME of build_config.h
+awk '
+BEGIN {
+    name[0] = "dual"; name[1] = "HW only"; name[2] = "SW only"; name[3] = "benchmark"
+    for (p = 0; p < 4; p++)
+        num[name[p]] = p
+}
+FILENAME ~ /sizes.txt$/ {
+    text[$1] = $2; data[$1] = $3; bss[$1] = $4
+    next
+}
+{
+    sub(/\r$/, "")
+}
+/^Main loop \(.* build\): / {
+    # Main loop (<name> build): <n> passes, avg <n> cycles, max <n> cycles
+    s = $0
+    sub(/^Main loop \(/, "", s)
+    n = index(s, " build): ")
+    p = num[substr(s, 1, n - 1)]
+    split(substr(s, n + 9), f, " ")
+    passes[p] = f[1]; avg[p] = f[4]; max[p] = f[7]
+}
+END {
+    printf "%-10s %8s %8s %8s %8s %6s %8s %12s %12s\n", "profile", "text", "data",
+        "bss", "total", "BRAM", "passes", "avg pass us", "max pass us"
+    for (p = 0; p < 4; p++) {
+        if (p in text) {
+            total = text[p] + data[p] + bss[p]
+            sizes = sprintf("%8d %8d %8d %8d %5.1f%%", text[p], data[p], bss[p],
+                total, 100 * total / 131072)
+        } else
+            sizes = sprintf("%8s %8s %8s %8s %6s", "-", "-", "-", "-", "-")
+        if (p in passes)
+            loop = sprintf("%8d %12.2f %12.2f", passes[p], avg[p] / 100, max[p] / 100)
+        else
+            loop = sprintf("%8s %12s %12s", "-", "-", "-")
+        printf "%-10s %s %s\n", name[p], sizes, loop
+    }
+}' $OUT/sizes.txt "$@"
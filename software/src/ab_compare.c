@@ -0,0 +1,259 @@
+/*
+ * ab_compare.c
+ */
+
+#include <string.h>
+#include "ab_compare.h"
+#include "telemetry.h"
+#include "uart_command.h"
+
+#if CFG_COMPARE
+
+#define AB_SW		0
+#define AB_HW		1
+
+typedef struct {
+	u32		count;
+	u64		sum;
+	u32		min;
+	u32		max;
+	u32		unchanged;			// command changes the detector read the same
+} SettleStats;
+
+static struct {
+	u32				last_now;
+	u64				elapsed;						// TS ticks since AB_Reset()
+	u32				comparisons;
+	u32				disagreements;
+	u32				channel_disagreements[NUM_DUTY_CHANNELS];
+	u32				sw_seq, hw_seq;
+	u8				cmd[NUM_DUTY_CHANNELS];
+	bool			have_cmd;
+	u8				before[2][NUM_DUTY_CHANNELS];	// output at the command change
+	SettleTracker	settle[2];
+	SettleStats		settled[2];
+	u32				fit_calls, hw_calls;			// CostStats at AB_Reset()
+	u64				fit_cycles, hw_cycles;
+} ab;
+
+/****************************************************************************/
+/**
+ * Start timing a detector after a command change
+ *
+ * @param	tr is the tracker
+ * @param	now is TS_now() when the command changed
+ * @param	duty is the detector output at that time
+ *****************************************************************************/
+void SETTLE_Start(SettleTracker *tr, u32 now, const u8 *duty) {
+	tr->cmd_time = now;
+	tr->last_change = now;
+	tr->stable = PWM_CarrierPeriod() * AB_STABLE_PERIODS * TS_TICKS_PER_USEC;
+	if (tr->stable < AB_STABLE_TICKS)
+		tr->stable = AB_STABLE_TICKS;
+	memcpy(tr->last, duty, NUM_DUTY_CHANNELS);
+	tr->pending = true;
+}
+
+/****************************************************************************/
+/**
+ * Feed the latest detector output to a tracker
+ *
+ * The detector has settled once its output has not moved for
+ * AB_STABLE_TICKS or AB_STABLE_PERIODS carrier periods, whichever is
+ * longer; at a long carrier a detector can sit on the old reading for
+ * more than 100 ms.  The settling time is measured up to the last change.
+ *
+ * @param	tr is the tracker
+ * @param	now is TS_now()
+ * @param	duty is the detector output
+ * @param	settle_ticks receives the settling time when the call returns true
+ *
+ * @return	true exactly once per SETTLE_Start(), when the output settles
+ *****************************************************************************/
+bool SETTLE_Update(SettleTracker *tr, u32 now, const u8 *duty, u32 *settle_ticks) {
+	if (!tr->pending)
+		return false;
+
+	if (memcmp(tr->last, duty, NUM_DUTY_CHANNELS) != 0) {
+		memcpy(tr->last, duty, NUM_DUTY_CHANNELS);
+		tr->last_change = now;
+		return false;
+	}
+	if (now - tr->last_change < tr->stable)
+		return false;
+
+	*settle_ticks = tr->last_change - tr->cmd_time;
+	tr->pending = false;
+	return true;
+}
+
+/****************************************************************************/
+/**
+ * Clear the A/B statistics.  Called when A/B mode is switched on.
+ *****************************************************************************/
+void AB_Reset(void) {
+	memset(&ab, 0, sizeof(ab));
+	ab.last_now = TS_now();
+	ab.fit_calls = fit_cost.calls;
+	ab.fit_cycles = fit_cost.cycles;
+	ab.hw_calls = hw_cost.calls;
+	ab.hw_cycles = hw_cost.cycles;
+}
+
+/****************************************************************************/
+/**
+ * Compare the latest output of both detectors
+ *
+ * @param	now is TS_now()
+ * @param	cmd is the commanded R, G, B
+ * @param	sw is the latest software detector snapshot
+ * @param	hw is the latest hardware detector snapshot
+ *****************************************************************************/
+void AB_Update(u32 now, const u8 *cmd, const DutySnapshot *sw,
+		const DutySnapshot *hw) {
+	const DutySnapshot *snap[2] = { sw, hw };
+	bool disagree = false;
+	u32 ticks;
+	u8 ch, det;
+	int diff;
+
+	ab.elapsed += now - ab.last_now;
+	ab.last_now = now;
+
+	if (!ab.have_cmd || memcmp(ab.cmd, cmd, NUM_DUTY_CHANNELS) != 0) {
+		memcpy(ab.cmd, cmd, NUM_DUTY_CHANNELS);
+		for (det = AB_SW; det <= AB_HW; det++) {
+			SETTLE_Start(&ab.settle[det], now, snap[det]->duty);
+			memcpy(ab.before[det], snap[det]->duty, NUM_DUTY_CHANNELS);
+		}
+		ab.have_cmd = true;
+	}
+
+	for (det = AB_SW; det <= AB_HW; det++) {
+		if (!SETTLE_Update(&ab.settle[det], now, snap[det]->duty, &ticks))
+			continue;
+		// Nothing to time, e.g. a change too small to move the duty %
+		if (memcmp(ab.settle[det].last, ab.before[det], NUM_DUTY_CHANNELS) == 0) {
+			ab.settled[det].unchanged++;
+			continue;
+		}
+		if (ab.settled[det].count == 0 || ticks < ab.settled[det].min)
+			ab.settled[det].min = ticks;
+		if (ticks > ab.settled[det].max)
+			ab.settled[det].max = ticks;
+		ab.settled[det].sum += ticks;
+		ab.settled[det].count++;
+	}
+
+	// Only compare when one of the detectors has published something new
+	if (sw->seq == ab.sw_seq && hw->seq == ab.hw_seq)
+		return;
+	ab.sw_seq = sw->seq;
+	ab.hw_seq = hw->seq;
+
+	ab.comparisons++;
+	for (ch = 0; ch < NUM_DUTY_CHANNELS; ch++) {
+		diff = (int) sw->duty[ch] - (int) hw->duty[ch];
+		if (diff > AB_TOLERANCE || diff < -AB_TOLERANCE) {
+			ab.channel_disagreements[ch]++;
+			disagree = true;
+		}
+	}
+	if (disagree)
+		ab.disagreements++;
+}
+
+/****************************************************************************/
+/**
+ * Send the A/B statistics as a FRAME_TYPE_AB frame and one
+ * FRAME_TYPE_LATENCY frame per detector
+ *
+ * Waits for room in the transmit ring if it is full, as the printed report
+ * waits for the UART.
+ *****************************************************************************/
+static void send_report(const u32 *permille) {
+	AbRecord rec;
+	LatencyRecord lat;
+	u8 payload[FRAME_MAX_PAYLOAD];
+	u8 det;
+
+	rec.comparisons = ab.comparisons;
+	rec.disagreements = ab.disagreements;
+	memcpy(rec.channel, ab.channel_disagreements, sizeof(rec.channel));
+	rec.tolerance = AB_TOLERANCE;
+	rec.cpu_permille[AB_SW] = permille[AB_SW];
+	rec.cpu_permille[AB_HW] = permille[AB_HW];
+	FRAME_PackAb(&rec, payload);
+	while (!TLM_SendFrame(FRAME_TYPE_AB, payload, AB_PAYLOAD_SIZE))
+		TLM_Poll();
+
+	for (det = AB_SW; det <= AB_HW; det++) {
+		lat.source = LATENCY_SOURCE_AB;
+		lat.detector = det;
+		lat.count = ab.settled[det].count;
+		lat.unchanged = ab.settled[det].unchanged;
+		lat.timeouts = 0;
+		lat.min_us = ab.settled[det].min / TS_TICKS_PER_USEC;
+		lat.avg_us = ab.settled[det].count ?
+				(u32) (ab.settled[det].sum / ab.settled[det].count)
+						/ TS_TICKS_PER_USEC : 0;
+		lat.max_us = ab.settled[det].max / TS_TICKS_PER_USEC;
+		FRAME_PackLatency(&lat, payload);
+		while (!TLM_SendFrame(FRAME_TYPE_LATENCY, payload, LATENCY_PAYLOAD_SIZE))
+			TLM_Poll();
+	}
+}
+
+/****************************************************************************/
+/**
+ * Print the A/B statistics collected since AB_Reset() on the UART
+ * While telemetry or a host is using the UART they are sent as frames
+ * instead, see send_report().
+ *****************************************************************************/
+void AB_Report(void) {
+	static const char *name[2] = { "SW", "HW" };
+	u64 elapsed = ab.elapsed;
+	u32 calls[2], permille[2];
+	u64 cycles[2];
+	u32 fit_calls;
+	u8 det;
+
+	// fit_cost is written by FIT_Handler, re-read if it ran in between
+	do {
+		fit_calls = fit_cost.calls;
+		cycles[AB_SW] = fit_cost.cycles;
+	} while (fit_calls != fit_cost.calls);
+	calls[AB_SW] = fit_calls - ab.fit_calls;
+	cycles[AB_SW] -= ab.fit_cycles;
+	calls[AB_HW] = hw_cost.calls - ab.hw_calls;
+	cycles[AB_HW] = hw_cost.cycles - ab.hw_cycles;
+	for (det = AB_SW; det <= AB_HW; det++)
+		permille[det] = elapsed ? (u32) (cycles[det] * 1000 / elapsed) : 0;
+
+	// Text would land in the middle of the telemetry or ACK frames
+	if (TLM_Enabled() || CMD_HostActive()) {
+		send_report(permille);
+		return;
+	}
+
+	xil_printf("A/B: %d comparisons, %d disagree by more than %d%% (R %d G %d B %d)\n",
+			ab.comparisons, ab.disagreements, AB_TOLERANCE,
+			ab.channel_disagreements[0], ab.channel_disagreements[1],
+			ab.channel_disagreements[2]);
+	for (det = AB_SW; det <= AB_HW; det++) {
+		xil_printf("  %s: settled %d times (%d unchanged), min %d us, avg %d us, max %d us\n",
+				name[det], ab.settled[det].count, ab.settled[det].unchanged,
+				ab.settled[det].min / TS_TICKS_PER_USEC,
+				ab.settled[det].count ?
+						(u32) (ab.settled[det].sum / ab.settled[det].count)
+								/ TS_TICKS_PER_USEC : 0,
+				ab.settled[det].max / TS_TICKS_PER_USEC);
+		xil_printf("  %s: %d calls, avg %d cycles, CPU %d.%d%%\n", name[det],
+				calls[det], calls[det] ? (u32) (cycles[det] / calls[det]) : 0,
+				permille[det] / 10, permille[det] % 10);
+	}
+	xil_printf("  worst call: SW %d cycles, HW %d cycles\n", fit_cost.max,
+			hw_cost.max);
+}
+
+#endif /* CFG_COMPARE */
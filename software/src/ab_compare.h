@@ -0,0 +1,73 @@
+/*
+ * ab_compare.h
+ *
+ *  A/B comparison of the software (FIT_Handler) and hardware (pwm_detector)
+ *  PWM detectors.  With switch 1 up both detectors run on every channel and
+ *  the main loop feeds each new pair of snapshots to AB_Update(), which
+ *  counts disagreements and times how long each detector takes to settle
+ *  after the commanded color changes; a change neither detector reads any
+ *  differently is only counted.  The cost of each detection path is
+ *  collected in CostStats.  AB_Report() prints the lot on the UART, or
+ *  sends it as frames while the UART carries telemetry or commands.
+ */
+
+#ifndef SRC_AB_COMPARE_H_
+#define SRC_AB_COMPARE_H_
+
+#include "hw_interface.h"
+
+/************************** Constant Definitions ****************************/
+
+#define AB_TOLERANCE			2							// duty % the detectors may differ by
+#define AB_STABLE_TICKS			(AXI_CLOCK_FREQ_HZ / 10)	// 100 ms without a change is settled,
+#define AB_STABLE_PERIODS		3							// or this many carrier periods if longer
+
+/**************************** Type Definitions ******************************/
+
+// Cycles spent in one code path.  Updated from one context only.
+typedef struct {
+	volatile u32	calls;
+	volatile u64	cycles;
+	volatile u32	max;
+} CostStats;
+
+// Time from a command change until a detector's output stops moving
+typedef struct {
+	u32		cmd_time;		// TS_now() when the command changed
+	u32		last_change;	// TS_now() when the output last moved
+	u32		stable;			// ticks without a change that count as settled
+	u8		last[NUM_DUTY_CHANNELS];
+	bool	pending;		// still waiting for the output to settle
+} SettleTracker;
+
+/***************** Macros (Inline Functions) Definitions ********************/
+
+static inline void COST_Add(CostStats *cost, u32 cycles) {
+	cost->calls++;
+	cost->cycles += cycles;
+	if (cycles > cost->max)
+		cost->max = cycles;
+}
+
+/************************** Variable Definitions ****************************/
+extern CostStats fit_cost;			// FIT_Handler, software detection
+extern CostStats hw_cost;			// ReadHwDetector(), hardware detection
+
+/************************** Function Prototypes *****************************/
+#if CFG_COMPARE
+void SETTLE_Start(SettleTracker *tr, u32 now, const u8 *duty);
+bool SETTLE_Update(SettleTracker *tr, u32 now, const u8 *duty, u32 *settle_ticks);
+
+void AB_Reset(void);
+void AB_Update(u32 now, const u8 *cmd, const DutySnapshot *sw,
+		const DutySnapshot *hw);
+void AB_Report(void);
+#else
+// Not in this build, see build_config.h
+static inline void AB_Reset(void) { }
+static inline void AB_Update(u32 now, const u8 *cmd, const DutySnapshot *sw,
+		const DutySnapshot *hw) { }
+static inline void AB_Report(void) { }
+#endif /* CFG_COMPARE */
+
+#endif /* SRC_AB_COMPARE_H_ */
@@ -0,0 +1,144 @@
+/*
+ * boot.c
+ */
+
+#include <string.h>
+#include "boot.h"
+
+// Not cleared by the start-up code, see lscript.ld
+static BootRecord record __attribute__ ((section(".noinit")));
+
+static bool warm;
+static bool display_ready;
+static u8 display_step;
+static u32 marked;							// bit per milestone
+static u32 milestones[BOOT_NUM_MILESTONES];	// TS_now() at each milestone
+
+static const char * const milestone_names[BOOT_NUM_MILESTONES] = {
+	"timers", "first color", "inputs", "loop", "display", "drawn"
+};
+
+static u32 record_check(const BootRecord *rec) {
+	return ~(rec->magic ^ rec->resets ^ rec->hue ^ ((u32) rec->sat << 16)
+			^ ((u32) rec->val << 24));
+}
+
+/****************************************************************************/
+/**
+ * Decide whether this is a warm boot.  Call first thing in main(), it does
+ * not touch any peripheral.
+ *****************************************************************************/
+void BOOT_Start(void) {
+	warm = (record.magic == BOOT_MAGIC && record.check == record_check(&record));
+	if (warm) {
+		record.resets++;
+	} else {
+		memset(&record, 0, sizeof(record));
+		record.magic = BOOT_MAGIC;
+	}
+	record.check = record_check(&record);
+}
+
+/****************************************************************************/
+/**
+ * @return	true if the CPU was reset without the FPGA being reconfigured
+ *****************************************************************************/
+bool BOOT_IsWarm(void) {
+	return warm;
+}
+
+/****************************************************************************/
+/**
+ * Timestamp a milestone, only the first time it is reached counts
+ *****************************************************************************/
+void BOOT_Mark(BootMilestone milestone) {
+	if (!(marked & (1 << milestone))) {
+		milestones[milestone] = TS_now();
+		marked |= 1 << milestone;
+	}
+}
+
+/****************************************************************************/
+/**
+ * Get the controls saved before the last reset
+ *
+ * @return	true on a warm boot, false (and nothing changed) on a cold one
+ *****************************************************************************/
+bool BOOT_Restore(u16 *hue, u8 *sat, u8 *val) {
+	if (!warm)
+		return false;
+	*hue = record.hue;
+	*sat = record.sat;
+	*val = record.val;
+	return true;
+}
+
+/****************************************************************************/
+/**
+ * Save the controls so a warm reset comes back with the same color
+ *****************************************************************************/
+void BOOT_Save(u16 hue, u8 sat, u8 val) {
+	record.hue = hue;
+	record.sat = sat;
+	record.val = val;
+	record.check = record_check(&record);
+}
+
+/****************************************************************************/
+/**
+ * Run the next deferred start-up step.  Call once per main loop pass.
+ *
+ * @return	true once, on the pass the display becomes usable.  The caller
+ * 			then draws the whole screen.
+ *****************************************************************************/
+bool BOOT_Poll(void) {
+	switch (display_step) {
+	case 0:
+		do_init_display();
+		BOOT_Mark(BOOT_DISPLAY);
+		display_step++;
+		break;
+	case 1:
+		display_ready = true;
+		display_step++;
+		return true;
+	default:
+		break;
+	}
+	return false;
+}
+
+/****************************************************************************/
+/**
+ * @return	true once the PmodOLEDrgb can be drawn on
+ *****************************************************************************/
+bool BOOT_DisplayReady(void) {
+	return display_ready;
+}
+
+/****************************************************************************/
+/**
+ * Run whatever deferred steps are left, e.g. when exiting early
+ *****************************************************************************/
+void BOOT_Finish(void) {
+	while (!display_ready)
+		BOOT_Poll();
+}
+
+/****************************************************************************/
+/**
+ * Print the milestones, in microseconds from the timestamp counter start
+ *****************************************************************************/
+void BOOT_Report(void) {
+	u8 i;
+
+	if (warm)
+		xil_printf("Warm boot #%d, self-test skipped\n", record.resets);
+	else
+		xil_printf("Cold boot\n");
+	for (i = 0; i < BOOT_NUM_MILESTONES; i++) {
+		if (marked & (1 << i))
+			xil_printf("  %s: %d us\n", milestone_names[i],
+					milestones[i] / TS_TICKS_PER_USEC);
+	}
+}
@@ -0,0 +1,60 @@
+/*
+ * boot.h
+ *
+ *  Boot sequencing.  do_init() only brings up the timers, Nexys4IO and
+ *  the input path, so the RGB LEDs show a color as early as possible.  The
+ *  PmodOLEDrgb power up (hundreds of ms of delays in the driver) is run
+ *  later from the main loop by BOOT_Poll().
+ *
+ *  A small record in the .noinit section survives a CPU reset (btnCpuReset)
+ *  but not a reconfiguration.  When it is valid the boot is warm: the
+ *  self-test is skipped and the last hue/sat/val are restored.
+ *
+ *  Milestones are timestamped with TS_now() and printed once the display is
+ *  up.  The TS counter starts in do_init(), so the times do not include the
+ *  C start-up code before main().
+ */
+
+#ifndef SRC_BOOT_H_
+#define SRC_BOOT_H_
+
+#include "hw_interface.h"
+
+/************************** Constant Definitions ****************************/
+
+#define BOOT_MAGIC				0x5A17B007
+
+/**************************** Type Definitions ******************************/
+
+typedef enum {
+	BOOT_TIMERS,			// PWM clock and timestamp counter running
+	BOOT_FIRST_COLOR,		// RGB LEDs show the start-up color
+	BOOT_INPUTS,			// GPIO, encoder and FIT interrupt running
+	BOOT_LOOP,				// first main loop pass
+	BOOT_DISPLAY,			// PmodOLEDrgb powered up
+	BOOT_DISPLAY_DRAWN,		// first full screen drawn
+	BOOT_NUM_MILESTONES
+} BootMilestone;
+
+// Kept across CPU resets in .noinit
+typedef struct {
+	u32		magic;			// BOOT_MAGIC when the record is valid
+	u32		resets;			// warm resets since configuration
+	u16		hue;			// controls at the last change
+	u8		sat;
+	u8		val;
+	u32		check;			// over the fields above
+} BootRecord;
+
+/************************** Function Prototypes *****************************/
+void BOOT_Start(void);
+bool BOOT_IsWarm(void);
+void BOOT_Mark(BootMilestone milestone);
+bool BOOT_Restore(u16 *hue, u8 *sat, u8 *val);
+void BOOT_Save(u16 hue, u8 sat, u8 val);
+bool BOOT_Poll(void);
+bool BOOT_DisplayReady(void);
+void BOOT_Finish(void);
+void BOOT_Report(void);
+
+#endif /* SRC_BOOT_H_ */
@@ -0,0 +1,33 @@
+/*
+ * build_config.c
+ */
+
+#include "hw_interface.h"
+
+// Section boundaries from lscript.ld
+extern char __rodata_start[], __data_start[], __bss_start[];
+extern char _heap_start[], _end[];
+
+#define LOCAL_MEMORY_SIZE		0x20000		// BRAM, instructions and data
+
+/****************************************************************************/
+/**
+ * Print the build profile and how much of the local memory it takes
+ *
+ * Code is the vectors, .text and the constructor tables, data is .rodata
+ * through .tbss, bss includes .noinit.  The main loop period is printed
+ * with the other statistics at exit.
+ *****************************************************************************/
+void BUILD_Report(void) {
+	u32 code = (UINTPTR) __rodata_start;
+	u32 rodata = __data_start - __rodata_start;
+	u32 data = __bss_start - __data_start;
+	u32 bss = _heap_start - __bss_start;
+
+	xil_printf("Build profile: %s (HW detect %d, SW detect %d, A/B %d, host link %d, graphics %d)\n",
+			BUILD_PROFILE_NAME, CFG_HW_DETECT, CFG_SW_DETECT, CFG_COMPARE,
+			CFG_HOST_LINK, CFG_GRAPHICS);
+	xil_printf("  code %d, rodata %d, data %d, bss %d bytes, %d of %d KB used with heap and stack\n",
+			code, rodata, data, bss, ((UINTPTR) _end + 1023) / 1024,
+			LOCAL_MEMORY_SIZE / 1024);
+}
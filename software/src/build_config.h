@@ -0,0 +1,98 @@
+/*
+ * build_config.h
+ *
+ *  Build profiles.  Pick one with -DBUILD_PROFILE=BUILD_HW_ONLY (or one of
+ *  the others) in the compiler symbols, the default is the full dual build:
+ *
+ *      BUILD_DUAL        both detectors, switch 0 picks one.  Everything.
+ *      BUILD_HW_ONLY     pwm_detector only, duty text on the OLED
+ *      BUILD_SW_ONLY     FIT_Handler detector only, duty text on the OLED
+ *      BUILD_BENCHMARK   both detectors, A/B, the latency and ISR
+ *                        benchmarks and the host link, no graphics
+ *
+ *  A profile only sets the CFG_ defaults below, any of them can be
+ *  overridden on its own.  What is left out is not compiled: the module
+ *  bodies are #if'ed out and their headers turn the calls into empty
+ *  inline functions, so the main loop has nothing left to branch on.
+ *  software/scripts/profile_report.sh tabulates the code size and main
+ *  loop time of every profile.
+ *
+ *  Kept free of BSP headers, frame_codec.c includes it in the host tools.
+ */
+
+#ifndef SRC_BUILD_CONFIG_H_
+#define SRC_BUILD_CONFIG_H_
+
+/************************** Constant Definitions ****************************/
+
+#define BUILD_DUAL			0
+#define BUILD_HW_ONLY		1
+#define BUILD_SW_ONLY		2
+#define BUILD_BENCHMARK		3
+
+#ifndef BUILD_PROFILE
+#define BUILD_PROFILE		BUILD_DUAL
+#endif
+
+#if BUILD_PROFILE == BUILD_DUAL
+#define BUILD_PROFILE_NAME	"dual"
+#elif BUILD_PROFILE == BUILD_HW_ONLY
+#define BUILD_PROFILE_NAME	"HW only"
+#elif BUILD_PROFILE == BUILD_SW_ONLY
+#define BUILD_PROFILE_NAME	"SW only"
+#elif BUILD_PROFILE == BUILD_BENCHMARK
+#define BUILD_PROFILE_NAME	"benchmark"
+#else
+#error "Unknown BUILD_PROFILE, see build_config.h"
+#endif
+
+// pwm_detector read from the main loop, its three GPIO instances
+#ifndef CFG_HW_DETECT
+#define CFG_HW_DETECT		(BUILD_PROFILE != BUILD_SW_ONLY)
+#endif
+
+// Software detector in FIT_Handler.  Without it the FIT only scans the inputs.
+#ifndef CFG_SW_DETECT
+#define CFG_SW_DETECT		(BUILD_PROFILE != BUILD_HW_ONLY)
+#endif
+
+// A/B comparison and the color change latency benchmark, need both detectors
+#ifndef CFG_COMPARE
+#define CFG_COMPARE			(BUILD_PROFILE == BUILD_DUAL || BUILD_PROFILE == BUILD_BENCHMARK)
+#endif
+
+// Binary telemetry and the UART command interface, with its interrupt
+#ifndef CFG_HOST_LINK
+#define CFG_HOST_LINK		(BUILD_PROFILE == BUILD_DUAL || BUILD_PROFILE == BUILD_BENCHMARK)
+#endif
+
+// Color picker, duty strip chart and the WS2812 strip animation
+#ifndef CFG_GRAPHICS
+#define CFG_GRAPHICS		(BUILD_PROFILE == BUILD_DUAL)
+#endif
+
+// HSV color register in the fabric (hsv_pwm_axi)
+#ifndef CFG_HSV_FABRIC
+#define CFG_HSV_FABRIC		(BUILD_PROFILE == BUILD_DUAL)
+#endif
+
+// Timing trace bits on JC, see trace.h.  One store each, so on everywhere.
+#ifndef CFG_TRACE
+#define CFG_TRACE			1
+#endif
+
+#if BUILD_PROFILE == BUILD_BENCHMARK && !defined(ISR_BENCHMARK)
+#define ISR_BENCHMARK
+#endif
+
+#if !CFG_HW_DETECT && !CFG_SW_DETECT
+#error "A build needs at least one PWM detector"
+#endif
+#if CFG_COMPARE && !(CFG_HW_DETECT && CFG_SW_DETECT)
+#error "CFG_COMPARE needs both PWM detectors"
+#endif
+
+/************************** Function Prototypes *****************************/
+void BUILD_Report(void);
+
+#endif /* SRC_BUILD_CONFIG_H_ */
@@ -0,0 +1,185 @@
+/*
+ * color_view.c
+ */
+
+#include "color_view.h"
+#include "functional_interface.h"
+
+#if CFG_GRAPHICS
+
+#define CURSOR_SIZE		(2 * VIEW_CURSOR_RADIUS + 1)
+#define CURSOR_COLOR	0xFFFF				// white
+#define MARKER_COLOR	0xF800				// red
+
+static bool drawn;					// field and bar are on the screen
+static u8 cursor_x, cursor_y;		// field cursor centre
+static u8 marker_x;					// value bar marker column
+static ViewStats stats;
+
+// One bitmap row of the view, or one cursor footprint
+static u8 bitmap[VIEW_WIDTH * 2 > CURSOR_SIZE * CURSOR_SIZE * 2 ?
+		VIEW_WIDTH * 2 : CURSOR_SIZE * CURSOR_SIZE * 2];
+
+/****************************************************************************/
+/**
+ * Color of a field pixel: hue across, saturation down, full value
+ *****************************************************************************/
+static u16 field_color(u8 x, u8 y) {
+	u8 R, G, B;
+
+	HSVtoRGB((u16) (x - VIEW_X0) * 360 / VIEW_WIDTH,
+			100 - (u16) (y - VIEW_FIELD_Y0) * 100 / (VIEW_FIELD_HEIGHT - 1),
+			100, &R, &G, &B);
+	return OLEDrgb_BuildRGB(R, G, B);
+}
+
+/****************************************************************************/
+/**
+ * Color of a value bar pixel: black to white
+ *****************************************************************************/
+static u16 bar_color(u8 x) {
+	u8 level = (u16) (x - VIEW_X0) * 255 / (VIEW_WIDTH - 1);
+
+	return OLEDrgb_BuildRGB(level, level, level);
+}
+
+static void put_pixel(u16 i, u16 color) {
+	bitmap[2 * i] = color >> 8;
+	bitmap[2 * i + 1] = color;
+}
+
+static void send_bitmap(u8 x1, u8 y1, u8 x2, u8 y2) {
+	TRACE_ON(TRACE_OLED);
+	OLEDrgb_DrawBitmap(&pmodOLEDrgb_inst, x1, y1, x2, y2, bitmap);
+	TRACE_OFF(TRACE_OLED);
+	stats.bytes += (x2 - x1 + 1) * (y2 - y1 + 1) * 2;
+}
+
+/****************************************************************************/
+/**
+ * Redraw the field around (cx, cy), with the cursor ring if ring is true
+ *****************************************************************************/
+static void draw_footprint(u8 cx, u8 cy, bool ring) {
+	u8 x1, y1, x2, y2, x, y;
+	u16 i = 0;
+
+	x1 = (cx - VIEW_X0 >= VIEW_CURSOR_RADIUS) ? cx - VIEW_CURSOR_RADIUS : VIEW_X0;
+	x2 = (cx + VIEW_CURSOR_RADIUS < VIEW_X0 + VIEW_WIDTH) ?
+			cx + VIEW_CURSOR_RADIUS : VIEW_X0 + VIEW_WIDTH - 1;
+	y1 = (cy - VIEW_FIELD_Y0 >= VIEW_CURSOR_RADIUS) ?
+			cy - VIEW_CURSOR_RADIUS : VIEW_FIELD_Y0;
+	y2 = (cy + VIEW_CURSOR_RADIUS < VIEW_FIELD_Y0 + VIEW_FIELD_HEIGHT) ?
+			cy + VIEW_CURSOR_RADIUS : VIEW_FIELD_Y0 + VIEW_FIELD_HEIGHT - 1;
+
+	for (y = y1; y <= y2; y++) {
+		for (x = x1; x <= x2; x++) {
+			if (ring && (x == cx - VIEW_CURSOR_RADIUS
+					|| x == cx + VIEW_CURSOR_RADIUS
+					|| y == cy - VIEW_CURSOR_RADIUS
+					|| y == cy + VIEW_CURSOR_RADIUS))
+				put_pixel(i++, CURSOR_COLOR);
+			else
+				put_pixel(i++, field_color(x, y));
+		}
+	}
+	send_bitmap(x1, y1, x2, y2);
+}
+
+/****************************************************************************/
+/**
+ * Redraw one column of the value bar, as the marker if marker is true
+ *****************************************************************************/
+static void draw_bar_column(u8 x, bool marker) {
+	u16 color = marker ? MARKER_COLOR : bar_color(x);
+	u8 i;
+
+	for (i = 0; i < VIEW_BAR_HEIGHT; i++)
+		put_pixel(i, color);
+	send_bitmap(x, VIEW_BAR_Y0, x, VIEW_BAR_Y0 + VIEW_BAR_HEIGHT - 1);
+}
+
+/****************************************************************************/
+/**
+ * Draw the whole field and value bar, a row at a time
+ *****************************************************************************/
+static void draw_all(void) {
+	u8 x, y;
+
+	for (y = VIEW_FIELD_Y0; y < VIEW_FIELD_Y0 + VIEW_FIELD_HEIGHT; y++) {
+		for (x = 0; x < VIEW_WIDTH; x++)
+			put_pixel(x, field_color(VIEW_X0 + x, y));
+		send_bitmap(VIEW_X0, y, VIEW_X0 + VIEW_WIDTH - 1, y);
+	}
+	for (x = 0; x < VIEW_WIDTH; x++)
+		put_pixel(x, bar_color(VIEW_X0 + x));
+	for (y = VIEW_BAR_Y0; y < VIEW_BAR_Y0 + VIEW_BAR_HEIGHT; y++)
+		send_bitmap(VIEW_X0, y, VIEW_X0 + VIEW_WIDTH - 1, y);
+}
+
+/****************************************************************************/
+/**
+ * Bring the picker up to date with the controls
+ *
+ * Draws everything on the first call (or after VIEW_Invalidate()), then
+ * only the cursors that moved.
+ *
+ * @param	hue is 0 - 360
+ * @param	sat is 0 - 100
+ * @param	val is 0 - 100
+ *****************************************************************************/
+void VIEW_Update(u16 hue, u8 sat, u8 val) {
+	u8 cx = VIEW_X0 + (u32) hue * (VIEW_WIDTH - 1) / 360;
+	u8 cy = VIEW_FIELD_Y0 + (u32) (100 - sat) * (VIEW_FIELD_HEIGHT - 1) / 100;
+	u8 mx = VIEW_X0 + (u32) val * (VIEW_WIDTH - 1) / 100;
+
+	if (!drawn) {
+		draw_all();
+		draw_footprint(cx, cy, true);
+		draw_bar_column(mx, true);
+		drawn = true;
+	} else {
+		if (cx != cursor_x || cy != cursor_y) {
+			draw_footprint(cursor_x, cursor_y, false);
+			draw_footprint(cx, cy, true);
+		}
+		if (mx != marker_x) {
+			draw_bar_column(marker_x, false);
+			draw_bar_column(mx, true);
+		}
+	}
+	cursor_x = cx;
+	cursor_y = cy;
+	marker_x = mx;
+}
+
+/****************************************************************************/
+/**
+ * Draw everything again on the next VIEW_Update(), e.g. after a clear
+ *****************************************************************************/
+void VIEW_Invalidate(void) {
+	drawn = false;
+}
+
+/****************************************************************************/
+/**
+ * Account for the time one display update took
+ *
+ * @param	ticks is the TS ticks from the control change to the screen
+ * 			being up to date
+ *****************************************************************************/
+void VIEW_FrameTime(u32 ticks) {
+	stats.frames++;
+	stats.time_sum += ticks;
+	if (ticks > stats.time_max)
+		stats.time_max = ticks;
+}
+
+/****************************************************************************/
+/**
+ * Get the display timing statistics
+ *****************************************************************************/
+void VIEW_GetStats(ViewStats *s) {
+	*s = stats;
+}
+
+#endif /* CFG_GRAPHICS */
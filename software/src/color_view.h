@@ -0,0 +1,56 @@
+/*
+ * color_view.h
+ *
+ *  Color picker on the right half of the PmodOLEDrgb.
+ *
+ *      x 48 - 95, y  0 - 39   hue (across) / saturation (down) field
+ *      x 48 - 95, y 42 - 47   value bar
+ *      x 48 - 95, y 50 - 54   swatch of the current color (UpdateDispaly)
+ *
+ *  The field and bar are drawn once.  After that VIEW_Update() only
+ *  redraws the old and new footprints of the two cursors, recomputing the
+ *  pixels under them, so turning the knob costs a few small SPI writes.
+ */
+
+#ifndef SRC_COLOR_VIEW_H_
+#define SRC_COLOR_VIEW_H_
+
+#include "hw_interface.h"
+
+/************************** Constant Definitions ****************************/
+
+#define VIEW_X0				48
+#define VIEW_WIDTH			48
+#define VIEW_FIELD_Y0		0
+#define VIEW_FIELD_HEIGHT	40
+#define VIEW_BAR_Y0			42
+#define VIEW_BAR_HEIGHT		6
+#define VIEW_SWATCH_Y0		50
+#define VIEW_SWATCH_HEIGHT	5
+
+#define VIEW_CURSOR_RADIUS	2		// the field cursor is a 5x5 ring
+
+/**************************** Type Definitions ******************************/
+
+typedef struct {
+	u32		frames;			// display updates timed
+	u32		time_sum;		// TS ticks
+	u32		time_max;		// TS ticks
+	u32		bytes;			// pixel data bytes sent by VIEW_Update()
+} ViewStats;
+
+/************************** Function Prototypes *****************************/
+#if CFG_GRAPHICS
+void VIEW_Update(u16 hue, u8 sat, u8 val);
+void VIEW_Invalidate(void);
+void VIEW_FrameTime(u32 ticks);
+void VIEW_GetStats(ViewStats *stats);
+#else
+// Not in this build, see build_config.h
+static inline void VIEW_Update(u16 hue, u8 sat, u8 val) { }
+static inline void VIEW_Invalidate(void) { }
+static inline void VIEW_FrameTime(u32 ticks) { }
+static inline void VIEW_GetStats(ViewStats *stats) { *stats = (ViewStats) { 0 }; }
+#endif /* CFG_GRAPHICS */
+
+#endif /* SRC_COLOR_VIEW_H_ */
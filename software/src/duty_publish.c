@@ -0,0 +1,68 @@
+/*
+ * duty_publish.c
+ */
+
+#include "duty_publish.h"
+
+// Stops the compiler moving loads and stores across the sequence updates.
+// MicroBlaze is single issue and in order so no hardware barrier is needed.
+#define DUTY_BARRIER()	__asm__ __volatile__("" ::: "memory")
+
+/****************************************************************************/
+/**
+ * Publish a new set of duty cycles
+ *
+ * Must only ever be called from one context per publisher.  Never blocks, so
+ * it is safe to call from an interrupt handler.
+ *
+ * @param	pub is the publisher to update
+ * @param	duty points to NUM_DUTY_CHANNELS duty cycles
+ * @param	saturated has DUTY_SATURATED(ch) set for the stuck channels
+ *
+ * @return	*NONE*
+ *****************************************************************************/
+void DUTY_Publish(DutyPublisher *pub, const u8 *duty, u8 saturated) {
+	u8 ch;
+
+	pub->seq++;				// odd: update in progress
+	DUTY_BARRIER();
+	for (ch = 0; ch < NUM_DUTY_CHANNELS; ch++)
+		pub->duty[ch] = duty[ch];
+	pub->saturated = saturated;
+	DUTY_BARRIER();
+	pub->seq++;				// even: snapshot is coherent again
+}
+
+/****************************************************************************/
+/**
+ * Take a coherent snapshot of all the published duty cycles
+ *
+ * Copies the channels and retries if the sequence number moved (or was odd)
+ * while copying.  A publish takes a handful of cycles so in practice this
+ * retries at most once.
+ *
+ * @param	pub is the publisher to read
+ * @param	snap receives the duty cycles, the saturated channels and the
+ * 			sequence number
+ *
+ * @return	the number of retries needed, i.e. how many torn reads were avoided
+ *****************************************************************************/
+u32 DUTY_Read(const DutyPublisher *pub, DutySnapshot *snap) {
+	u32 seq;
+	u32 retries = 0;
+	u8 ch;
+
+	for (;;) {
+		seq = pub->seq;
+		DUTY_BARRIER();
+		for (ch = 0; ch < NUM_DUTY_CHANNELS; ch++)
+			snap->duty[ch] = pub->duty[ch];
+		snap->saturated = pub->saturated;
+		DUTY_BARRIER();
+		if (!(seq & 1) && seq == pub->seq)
+			break;
+		retries++;
+	}
+	snap->seq = seq;
+	return retries;
+}
@@ -0,0 +1,41 @@
+/*
+ * duty_publish.h
+ *
+ *  Sequence-locked publication of the detected duty cycles.
+ *  One writer (the FIT handler for software detection, the main loop for
+ *  hardware detection) publishes all channels at once.  Readers get a
+ *  coherent snapshot of every channel plus the sequence number it was taken
+ *  at, without either side masking interrupts: the writer never waits and
+ *  the reader simply retries if a publish landed in the middle of its copy.
+ */
+
+#ifndef SRC_DUTY_PUBLISH_H_
+#define SRC_DUTY_PUBLISH_H_
+
+#include "xil_types.h"
+
+#define NUM_DUTY_CHANNELS		3		// Red, Green, Blue
+
+// The channel is a constant level, its duty is 0 or 99 because it is stuck
+// low or high rather than measured
+#define DUTY_SATURATED(ch)		(1 << (ch))
+
+/**************************** Type Definitions ******************************/
+
+typedef struct {
+	volatile u32	seq;						// odd while a publish is in progress
+	volatile u8		duty[NUM_DUTY_CHANNELS];	// published duty cycles
+	volatile u8		saturated;					// DUTY_SATURATED(ch) bits
+} DutyPublisher;
+
+typedef struct {
+	u32		seq;						// even sequence number of the snapshot
+	u8		duty[NUM_DUTY_CHANNELS];	// duty cycle of each channel
+	u8		saturated;					// DUTY_SATURATED(ch) bits
+} DutySnapshot;
+
+/************************** Function Prototypes *****************************/
+void DUTY_Publish(DutyPublisher *pub, const u8 *duty, u8 saturated);
+u32  DUTY_Read(const DutyPublisher *pub, DutySnapshot *snap);
+
+#endif /* SRC_DUTY_PUBLISH_H_ */
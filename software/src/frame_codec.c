@@ -0,0 +1,352 @@
+/*
+ * frame_codec.c
+ */
+
+#include <string.h>
+#include "frame_codec.h"
+#include "build_config.h"
+
+#if CFG_HOST_LINK
+
+// Decoder states
+#define DEC_SYNC0		0
+#define DEC_SYNC1		1
+#define DEC_TYPE		2
+#define DEC_LEN			3
+#define DEC_PAYLOAD		4
+#define DEC_CRC_LO		5
+#define DEC_CRC_HI		6
+
+/****************************************************************************/
+/**
+ * CRC-16/CCITT-FALSE (poly 0x1021), bitwise to stay small
+ *
+ * @param	crc is 0xFFFF for a new CRC or the result of the previous call
+ * @param	data is the data to add
+ * @param	len is the number of bytes in data
+ *
+ * @return	the updated CRC
+ *****************************************************************************/
+uint16_t FRAME_Crc16(uint16_t crc, const uint8_t *data, uint16_t len) {
+	uint8_t bit;
+
+	while (len--) {
+		crc ^= (uint16_t) (*data++) << 8;
+		for (bit = 0; bit < 8; bit++)
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+	}
+	return crc;
+}
+
+/****************************************************************************/
+/**
+ * Build a complete frame
+ *
+ * @param	type is the frame type
+ * @param	payload is the payload, len bytes
+ * @param	len is the payload length, at most FRAME_MAX_PAYLOAD
+ * @param	frame receives the frame, at least len + FRAME_OVERHEAD bytes
+ *
+ * @return	the number of bytes in frame, 0 if the payload is too long
+ *****************************************************************************/
+uint16_t FRAME_Encode(uint8_t type, const uint8_t *payload, uint8_t len,
+		uint8_t *frame) {
+	uint16_t crc;
+
+	if (len > FRAME_MAX_PAYLOAD)
+		return 0;
+
+	frame[0] = FRAME_SYNC0;
+	frame[1] = FRAME_SYNC1;
+	frame[2] = type;
+	frame[3] = len;
+	memcpy(&frame[4], payload, len);
+	crc = FRAME_Crc16(0xFFFF, &frame[2], len + 2);
+	FRAME_PutU16(&frame[4 + len], crc);
+	return len + FRAME_OVERHEAD;
+}
+
+/****************************************************************************/
+/**
+ * Reset a stream decoder, counters included
+ *****************************************************************************/
+void FRAME_DecoderInit(FrameDecoder *dec) {
+	memset(dec, 0, sizeof(*dec));
+	dec->state = DEC_SYNC0;
+}
+
+/****************************************************************************/
+/**
+ * Feed one received byte to the decoder
+ *
+ * @param	dec is the decoder
+ * @param	byte is the next byte from the stream
+ *
+ * @return	1 when byte completes a frame with a good CRC.  dec->type,
+ * 			dec->len and dec->payload then hold the frame until the next call.
+ * 			0 otherwise.
+ *****************************************************************************/
+int FRAME_DecodeByte(FrameDecoder *dec, uint8_t byte) {
+	switch (dec->state) {
+	case DEC_SYNC0:
+		if (byte == FRAME_SYNC0)
+			dec->state = DEC_SYNC1;
+		else
+			dec->skipped++;
+		break;
+
+	case DEC_SYNC1:
+		if (byte == FRAME_SYNC1) {
+			dec->state = DEC_TYPE;
+		} else if (byte != FRAME_SYNC0) {
+			dec->skipped += 2;
+			dec->state = DEC_SYNC0;
+		} else {
+			dec->skipped++;
+		}
+		break;
+
+	case DEC_TYPE:
+		dec->type = byte;
+		dec->state = DEC_LEN;
+		break;
+
+	case DEC_LEN:
+		if (byte > FRAME_MAX_PAYLOAD) {
+			dec->crc_errors++;
+			dec->state = DEC_SYNC0;
+			break;
+		}
+		dec->len = byte;
+		dec->idx = 0;
+		dec->state = byte ? DEC_PAYLOAD : DEC_CRC_LO;
+		break;
+
+	case DEC_PAYLOAD:
+		dec->payload[dec->idx++] = byte;
+		if (dec->idx == dec->len)
+			dec->state = DEC_CRC_LO;
+		break;
+
+	case DEC_CRC_LO:
+		dec->crc = byte;
+		dec->state = DEC_CRC_HI;
+		break;
+
+	case DEC_CRC_HI:
+	default:
+		dec->state = DEC_SYNC0;
+		dec->crc |= (uint16_t) byte << 8;
+		{
+			uint8_t hdr[2] = { dec->type, dec->len };
+			uint16_t crc = FRAME_Crc16(0xFFFF, hdr, 2);
+
+			crc = FRAME_Crc16(crc, dec->payload, dec->len);
+			if (crc != dec->crc) {
+				dec->crc_errors++;
+				return 0;
+			}
+		}
+		dec->frames++;
+		return 1;
+	}
+	return 0;
+}
+
+/****************************************************************************/
+/**
+ * Serialize a telemetry record into TLM_PAYLOAD_SIZE bytes
+ *****************************************************************************/
+void FRAME_PackTelemetry(const TelemetryRecord *rec, uint8_t *payload) {
+	FRAME_PutU32(&payload[0], rec->seq);
+	FRAME_PutU32(&payload[4], rec->timestamp);
+	memcpy(&payload[8], rec->cmd, 3);
+	memcpy(&payload[11], rec->sw_duty, 3);
+	memcpy(&payload[14], rec->hw_duty, 3);
+	payload[17] = rec->flags;
+	FRAME_PutU32(&payload[18], rec->loops);
+	FRAME_PutU32(&payload[22], rec->loop_max);
+}
+
+/****************************************************************************/
+/**
+ * Deserialize a telemetry record
+ *
+ * @return	0 on success, -1 if the payload has the wrong length
+ *****************************************************************************/
+int FRAME_UnpackTelemetry(const uint8_t *payload, uint8_t len,
+		TelemetryRecord *rec) {
+	if (len != TLM_PAYLOAD_SIZE)
+		return -1;
+
+	rec->seq = FRAME_GetU32(&payload[0]);
+	rec->timestamp = FRAME_GetU32(&payload[4]);
+	memcpy(rec->cmd, &payload[8], 3);
+	memcpy(rec->sw_duty, &payload[11], 3);
+	memcpy(rec->hw_duty, &payload[14], 3);
+	rec->flags = payload[17];
+	rec->loops = FRAME_GetU32(&payload[18]);
+	rec->loop_max = FRAME_GetU32(&payload[22]);
+	return 0;
+}
+
+/****************************************************************************/
+/**
+ * Serialize a latency summary into LATENCY_PAYLOAD_SIZE bytes
+ *****************************************************************************/
+void FRAME_PackLatency(const LatencyRecord *rec, uint8_t *payload) {
+	payload[0] = rec->source;
+	payload[1] = rec->detector;
+	FRAME_PutU32(&payload[2], rec->count);
+	FRAME_PutU32(&payload[6], rec->unchanged);
+	FRAME_PutU32(&payload[10], rec->timeouts);
+	FRAME_PutU32(&payload[14], rec->min_us);
+	FRAME_PutU32(&payload[18], rec->avg_us);
+	FRAME_PutU32(&payload[22], rec->max_us);
+}
+
+/****************************************************************************/
+/**
+ * Deserialize a latency summary
+ *
+ * @return	0 on success, -1 if the payload has the wrong length
+ *****************************************************************************/
+int FRAME_UnpackLatency(const uint8_t *payload, uint8_t len,
+		LatencyRecord *rec) {
+	if (len != LATENCY_PAYLOAD_SIZE)
+		return -1;
+
+	rec->source = payload[0];
+	rec->detector = payload[1];
+	rec->count = FRAME_GetU32(&payload[2]);
+	rec->unchanged = FRAME_GetU32(&payload[6]);
+	rec->timeouts = FRAME_GetU32(&payload[10]);
+	rec->min_us = FRAME_GetU32(&payload[14]);
+	rec->avg_us = FRAME_GetU32(&payload[18]);
+	rec->max_us = FRAME_GetU32(&payload[22]);
+	return 0;
+}
+
+/****************************************************************************/
+/**
+ * Serialize an A/B comparison into AB_PAYLOAD_SIZE bytes
+ *****************************************************************************/
+void FRAME_PackAb(const AbRecord *rec, uint8_t *payload) {
+	FRAME_PutU32(&payload[0], rec->comparisons);
+	FRAME_PutU32(&payload[4], rec->disagreements);
+	FRAME_PutU32(&payload[8], rec->channel[0]);
+	FRAME_PutU32(&payload[12], rec->channel[1]);
+	FRAME_PutU32(&payload[16], rec->channel[2]);
+	payload[20] = rec->tolerance;
+	FRAME_PutU16(&payload[21], rec->cpu_permille[0]);
+	FRAME_PutU16(&payload[23], rec->cpu_permille[1]);
+}
+
+/****************************************************************************/
+/**
+ * Deserialize an A/B comparison
+ *
+ * @return	0 on success, -1 if the payload has the wrong length
+ *****************************************************************************/
+int FRAME_UnpackAb(const uint8_t *payload, uint8_t len, AbRecord *rec) {
+	if (len != AB_PAYLOAD_SIZE)
+		return -1;
+
+	rec->comparisons = FRAME_GetU32(&payload[0]);
+	rec->disagreements = FRAME_GetU32(&payload[4]);
+	rec->channel[0] = FRAME_GetU32(&payload[8]);
+	rec->channel[1] = FRAME_GetU32(&payload[12]);
+	rec->channel[2] = FRAME_GetU32(&payload[16]);
+	rec->tolerance = payload[20];
+	rec->cpu_permille[0] = FRAME_GetU16(&payload[21]);
+	rec->cpu_permille[1] = FRAME_GetU16(&payload[23]);
+	return 0;
+}
+
+/****************************************************************************/
+/**
+ * Build a FRAME_TYPE_QUEUE payload
+ *
+ * @param	seq is the command sequence number
+ * @param	frames are the colors to queue
+ * @param	count is the number of frames, at most CMD_MAX_BATCH
+ * @param	payload receives 1 + count * CMD_COLOR_FRAME_SIZE bytes
+ *
+ * @return	the payload length, 0 if count is out of range
+ *****************************************************************************/
+uint8_t FRAME_PackColorFrames(uint8_t seq, const ColorFrame *frames,
+		uint8_t count, uint8_t *payload) {
+	uint8_t i;
+	uint8_t *p = &payload[1];
+
+	if (count == 0 || count > CMD_MAX_BATCH)
+		return 0;
+
+	payload[0] = seq;
+	for (i = 0; i < count; i++, p += CMD_COLOR_FRAME_SIZE) {
+		FRAME_PutU16(&p[0], frames[i].hue);
+		p[2] = frames[i].sat;
+		p[3] = frames[i].val;
+		FRAME_PutU16(&p[4], frames[i].hold_ms);
+	}
+	return 1 + count * CMD_COLOR_FRAME_SIZE;
+}
+
+/****************************************************************************/
+/**
+ * Read the color frames of a FRAME_TYPE_QUEUE payload
+ *
+ * @param	frames receives up to CMD_MAX_BATCH frames
+ *
+ * @return	the number of frames, -1 if the length is wrong
+ *****************************************************************************/
+int FRAME_UnpackColorFrames(const uint8_t *payload, uint8_t len,
+		ColorFrame *frames) {
+	uint8_t i, count;
+	const uint8_t *p = &payload[1];
+
+	if (len < 1 + CMD_COLOR_FRAME_SIZE
+			|| (len - 1) % CMD_COLOR_FRAME_SIZE != 0)
+		return -1;
+
+	count = (len - 1) / CMD_COLOR_FRAME_SIZE;
+	for (i = 0; i < count; i++, p += CMD_COLOR_FRAME_SIZE) {
+		frames[i].hue = FRAME_GetU16(&p[0]);
+		frames[i].sat = p[2];
+		frames[i].val = p[3];
+		frames[i].hold_ms = FRAME_GetU16(&p[4]);
+	}
+	return count;
+}
+
+/****************************************************************************/
+/**
+ * Serialize a command ACK into CMD_ACK_SIZE bytes
+ *****************************************************************************/
+void FRAME_PackAck(const CommandAck *ack, uint8_t *payload) {
+	payload[0] = ack->seq;
+	payload[1] = ack->type;
+	payload[2] = ack->status;
+	FRAME_PutU16(&payload[3], ack->queued);
+	FRAME_PutU16(&payload[5], ack->free);
+}
+
+/****************************************************************************/
+/**
+ * Deserialize a command ACK
+ *
+ * @return	0 on success, -1 if the payload has the wrong length
+ *****************************************************************************/
+int FRAME_UnpackAck(const uint8_t *payload, uint8_t len, CommandAck *ack) {
+	if (len != CMD_ACK_SIZE)
+		return -1;
+
+	ack->seq = payload[0];
+	ack->type = payload[1];
+	ack->status = payload[2];
+	ack->queued = FRAME_GetU16(&payload[3]);
+	ack->free = FRAME_GetU16(&payload[5]);
+	return 0;
+}
+
+#endif /* CFG_HOST_LINK */
@@ -0,0 +1,180 @@
+/*
+ * frame_codec.h
+ *
+ *  Framing for the binary streams on the USB-UART.  Plain C with no Xilinx
+ *  headers so the host tools in tools/ build the same file.
+ *
+ *  Frame layout, multi-byte fields little endian:
+ *
+ *      0xA5 0x5A | type | len | payload[len] | crc16
+ *
+ *  The CRC is CRC-16/CCITT-FALSE over type, len and the payload.  Anything
+ *  between frames (e.g. xil_printf text) is skipped by the decoder.
+ */
+
+#ifndef SRC_FRAME_CODEC_H_
+#define SRC_FRAME_CODEC_H_
+
+#include <stdint.h>
+
+/************************** Constant Definitions ****************************/
+
+#define FRAME_SYNC0					0xA5
+#define FRAME_SYNC1					0x5A
+#define FRAME_MAX_PAYLOAD			64
+#define FRAME_OVERHEAD				6		// sync, type, len, crc
+#define FRAME_MAX_SIZE				(FRAME_MAX_PAYLOAD + FRAME_OVERHEAD)
+
+// Frame types, board -> host
+#define FRAME_TYPE_TELEMETRY		0x01	// TelemetryRecord
+#define FRAME_TYPE_LATENCY			0x02	// LatencyRecord, sent in place of a printed report
+#define FRAME_TYPE_AB				0x03	// AbRecord, sent in place of the printed A/B report
+#define FRAME_TYPE_ACK				0x81	// CommandAck, answers every command
+
+// Frame types, host -> board.  The first payload byte of every command is a
+// sequence number that the board echoes in the ACK.  A command repeated with
+// the same sequence number (a retry after a lost ACK) is only ACKed again.
+#define FRAME_TYPE_SET_HSV			0x10	// seq, hue u16, sat, val
+#define FRAME_TYPE_SET_RGB			0x11	// seq, R, G, B
+#define FRAME_TYPE_SET_MODE			0x12	// seq, CMD_MODE_x flags
+#define FRAME_TYPE_QUEUE			0x13	// seq, 1 to CMD_MAX_BATCH ColorFrames
+#define FRAME_TYPE_PLAY				0x14	// seq, loop (0 or 1); while playing only
+										// updates loop, the ACK is a status poll
+#define FRAME_TYPE_STOP				0x15	// seq; stops playback, empties the queue
+
+#define CMD_MODE_HW_DETECT			0x01	// show the hardware detector
+#define CMD_MODE_AB					0x02	// run both detectors (A/B mode)
+
+#define CMD_COLOR_FRAME_SIZE		6		// hue u16, sat, val, hold_ms u16
+#define CMD_MAX_BATCH				((FRAME_MAX_PAYLOAD - 1) / CMD_COLOR_FRAME_SIZE)
+#define CMD_ACK_SIZE				7
+
+// CommandAck status
+#define CMD_STATUS_OK				0
+#define CMD_STATUS_BAD_LENGTH		1
+#define CMD_STATUS_QUEUE_FULL		2		// nothing from the batch was queued
+#define CMD_STATUS_UNKNOWN			3
+
+#define TLM_PAYLOAD_SIZE			26
+
+// TelemetryRecord flags
+#define TLM_FLAG_HW_DETECT			0x01	// display shows the hardware detector
+
+#define LATENCY_PAYLOAD_SIZE		26
+#define AB_PAYLOAD_SIZE				25
+
+// LatencyRecord source
+#define LATENCY_SOURCE_BENCH		0		// latency benchmark, every step
+#define LATENCY_SOURCE_BENCH_SAT	1		// latency benchmark, steps to full off or on
+#define LATENCY_SOURCE_AB			2		// A/B mode, every command change
+
+/**************************** Type Definitions ******************************/
+
+typedef struct {
+	uint32_t	seq;				// sample number, increments by 1
+	uint32_t	timestamp;			// TS ticks (AXI clock) when sampled
+	uint8_t		cmd[3];				// commanded R, G, B (0 - 255)
+	uint8_t		sw_duty[3];			// software detected R, G, B duty (%)
+	uint8_t		hw_duty[3];			// hardware detected R, G, B duty (%)
+	uint8_t		flags;				// TLM_FLAG_x
+	uint32_t	loops;				// main loop passes since the previous sample
+	uint32_t	loop_max;			// longest main loop pass since then, TS ticks
+} TelemetryRecord;
+
+// Settling times of one detector, what the benchmark prints per detector
+typedef struct {
+	uint8_t		source;				// LATENCY_SOURCE_x
+	uint8_t		detector;			// 0 software, 1 hardware
+	uint32_t	count;				// color changes timed
+	uint32_t	unchanged;			// changes the detector already read the same
+	uint32_t	timeouts;			// changes it did not settle on in time
+	uint32_t	min_us;
+	uint32_t	avg_us;
+	uint32_t	max_us;
+} LatencyRecord;
+
+// A/B comparison of the two detectors, the settling times go as LatencyRecords
+typedef struct {
+	uint32_t	comparisons;		// new readings compared
+	uint32_t	disagreements;		// readings more than tolerance apart
+	uint32_t	channel[3];			// the same per channel, R, G, B
+	uint8_t		tolerance;			// duty %
+	uint16_t	cpu_permille[2];	// software and hardware detection
+} AbRecord;
+
+// One timed color for scheduled playback
+typedef struct {
+	uint16_t	hue;				// 0 - 360
+	uint8_t		sat;				// 0 - 100
+	uint8_t		val;				// 0 - 100
+	uint16_t	hold_ms;			// time until the next frame
+} ColorFrame;
+
+typedef struct {
+	uint8_t		seq;				// sequence number of the command
+	uint8_t		type;				// FRAME_TYPE_x of the command
+	uint8_t		status;				// CMD_STATUS_x
+	uint16_t	queued;				// frames waiting for playback
+	uint16_t	free;				// room left in the queue
+} CommandAck;
+
+typedef struct {
+	uint8_t		state;
+	uint8_t		type;
+	uint8_t		len;
+	uint8_t		idx;
+	uint16_t	crc;
+	uint8_t		payload[FRAME_MAX_PAYLOAD];
+	uint32_t	frames;				// good frames decoded
+	uint32_t	crc_errors;			// frames dropped for a bad CRC
+	uint32_t	skipped;			// bytes skipped looking for a sync
+} FrameDecoder;
+
+/***************** Macros (Inline Functions) Definitions ********************/
+
+static inline void FRAME_PutU32(uint8_t *p, uint32_t v) {
+	p[0] = (uint8_t) v;
+	p[1] = (uint8_t) (v >> 8);
+	p[2] = (uint8_t) (v >> 16);
+	p[3] = (uint8_t) (v >> 24);
+}
+
+static inline uint32_t FRAME_GetU32(const uint8_t *p) {
+	return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16)
+			| ((uint32_t) p[3] << 24);
+}
+
+static inline void FRAME_PutU16(uint8_t *p, uint16_t v) {
+	p[0] = (uint8_t) v;
+	p[1] = (uint8_t) (v >> 8);
+}
+
+static inline uint16_t FRAME_GetU16(const uint8_t *p) {
+	return (uint16_t) (p[0] | (p[1] << 8));
+}
+
+/************************** Function Prototypes *****************************/
+uint16_t FRAME_Crc16(uint16_t crc, const uint8_t *data, uint16_t len);
+uint16_t FRAME_Encode(uint8_t type, const uint8_t *payload, uint8_t len,
+		uint8_t *frame);
+void FRAME_DecoderInit(FrameDecoder *dec);
+int FRAME_DecodeByte(FrameDecoder *dec, uint8_t byte);
+
+void FRAME_PackTelemetry(const TelemetryRecord *rec, uint8_t *payload);
+int FRAME_UnpackTelemetry(const uint8_t *payload, uint8_t len,
+		TelemetryRecord *rec);
+
+void FRAME_PackLatency(const LatencyRecord *rec, uint8_t *payload);
+int FRAME_UnpackLatency(const uint8_t *payload, uint8_t len,
+		LatencyRecord *rec);
+void FRAME_PackAb(const AbRecord *rec, uint8_t *payload);
+int FRAME_UnpackAb(const uint8_t *payload, uint8_t len, AbRecord *rec);
+
+uint8_t FRAME_PackColorFrames(uint8_t seq, const ColorFrame *frames,
+		uint8_t count, uint8_t *payload);
+int FRAME_UnpackColorFrames(const uint8_t *payload, uint8_t len,
+		ColorFrame *frames);
+void FRAME_PackAck(const CommandAck *ack, uint8_t *payload);
+int FRAME_UnpackAck(const uint8_t *payload, uint8_t len, CommandAck *ack);
+
+#endif /* SRC_FRAME_CODEC_H_ */
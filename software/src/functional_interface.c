@@ -7,6 +7,11 @@
 
 #include "functional_interface.h"
 
+// Last R, G, B written to the RGB LEDs
+static u8 rgb_command[3];
+static u8 rgb_shown[3];					// drawn by UpdateDispaly()
+static bool rgb_pending;
+
 /* ------------------------------------------------------------ */
 /*** HSV to RGB Converter
  **
@@ -92,205 +97,320 @@ void UpdateRGBled(u8 hue, u8 sat, u8 val)
 void UpdateRGBled(u16 hue, u8 sat, u8 val, bool display) {
 	static u16 h = 0;
 	static u8 s = 0, v = 0;
-	u8 region, p, q, t;
-	float remain, S = sat / 100.0, V = val / 100.0;
 	u8 R, G, B;
-	if (h != hue || s != sat || v != val || display) {
-		region = hue / 60;
-		remain = ((hue / 60.0) - region);
-		p = V * (1.0 - S);
-		q = V * (1.0 - (S * remain));
-		t = V * (1.0 - (S * (1.0 - remain)));
-		V = V * 255;
-		p = p * 255;
-		q = q * 255;
-		t = t * 255;
-		switch (region) {
-		case 0:
-			R = val;
-			G = t;
-			B = p;
-			break;
-		case 1:
-			R = q;
-			G = val;
-			B = p;
-			break;
-		case 2:
-			R = p;
-			G = val;
-			B = t;
-			break;
-		case 3:
-			R = p;
-			G = q;
-			B = val;
-			break;
-		case 4:
-			R = t;
-			G = p;
-			B = val;
-			break;
-		default:
-			R = val;
-			G = p;
-			B = q;
-			break;
-		}
 
-		// For RGB1
-		NX4IO_RGBLED_setChnlEn(RGB1, true, true, true);
-		NX4IO_RGBLED_setDutyCycle(RGB1, R, G, B);
-		// For RGB2
-		NX4IO_RGBLED_setChnlEn(RGB2, true, true, true);
-		NX4IO_RGBLED_setDutyCycle(RGB2, R, G, B);
+	if (h == hue && s == sat && v == val && !display)
+		return;
 
-		xil_printf("LED's R=%d,G=%d,B=%d\n", R, G, B);
-		OLEDrgb_PutStringXY(0, 7, "R                    ");
-		OLEDrgb_PutIntigerXY(1, 7, R, 10);
-		OLEDrgb_PutStringXY(4, 7, "G");
-		OLEDrgb_PutIntigerXY(5, 7, G, 10);
-		OLEDrgb_PutStringXY(8, 7, "B");
-		OLEDrgb_PutIntigerXY(9, 7, B, 10);
-
-		OLEDrgb_DrawRectangle(&pmodOLEDrgb_inst, 50, 0, 95, 103,
-				OLEDrgb_BuildRGB(R, G, B), true, OLEDrgb_BuildRGB(R, G, B));
-		OLEDrgb_DrawRectangle(&pmodOLEDrgb_inst, 50, 0, 95, 103,
-				OLEDrgb_BuildRGB(R, G, B), true, OLEDrgb_BuildRGB(R, G, B));
-		h = hue;
-		s = sat;
-		v = val;
+	TRACE_ON(TRACE_COLOR);
+	if (HSVPWM_InUse()) {
+		// One write, the fabric converts and drives the LEDs
+		HSVPWM_Set(hue, sat, val);
+		HSVPWM_GetRGB(&R, &G, &B);
+		rgb_command[0] = R;
+		rgb_command[1] = G;
+		rgb_command[2] = B;
+	} else {
+		HSVtoRGB(hue, sat, val, &R, &G, &B);
+		SetRGBled(R, G, B);
 	}
+	TRACE_OFF(TRACE_COLOR);
+
+	// Text would land in the middle of the telemetry or ACK frames
+	if (!TLM_Enabled() && !CMD_HostActive())
+		xil_printf("LED's R=%d,G=%d,B=%d\n", R, G, B);
+	// Shown by UpdateDispaly() once the display is up and free
+	rgb_shown[0] = R;
+	rgb_shown[1] = G;
+	rgb_shown[2] = B;
+	rgb_pending = true;
+	h = hue;
+	s = sat;
+	v = val;
 }
 
-/** u16 GetHue(void)
+/** void SetRGBled(u8 R, u8 G, u8 B)
  *
- * @return The Hue value for the color
+ * @param R Red duty cycle
+ * @param G Green duty cycle
+ * @param B Blue duty cycle
  *
- *  Description:
- *        Updates the Hue value value based on the rotatry encoder turn direction
+ * Description:
+ *        Writes the duty cycles to both RGB LEDs and remembers them as the
+ *        current command, through Nexys4IO even if the fabric converter
+ *        had the LEDs.  Nothing is displayed.
  */
-u16 GetHue(void) {
-	u32 state = ENC_getState(&pmodENC_inst);
-	;
-	static u32 prev_state;
-	static int Hue = 0;
-	Hue += ENC_getRotation(state, prev_state);
-	if (Hue > 360)
-		Hue = 0;
-	if (Hue < 0)
-		Hue = 360;
-	prev_state = state;
-	return Hue;
+void SetRGBled(u8 R, u8 G, u8 B) {
+	HSVPWM_Release();
+	// For RGB1
+	NX4IO_RGBLED_setChnlEn(RGB1, true, true, true);
+	NX4IO_RGBLED_setDutyCycle(RGB1, R, G, B);
+	// For RGB2
+	NX4IO_RGBLED_setChnlEn(RGB2, true, true, true);
+	NX4IO_RGBLED_setDutyCycle(RGB2, R, G, B);
+
+	rgb_command[0] = R;
+	rgb_command[1] = G;
+	rgb_command[2] = B;
 }
 
-/**u8 GetSat(void)
+/** void HSVtoRGB(u16 hue, u8 sat, u8 val, u8 *R, u8 *G, u8 *B)
  *
- * @return the saturation value for the color
+ * @param hue Hue of color, 0 - 360
+ * @param sat Saturation of color, 0 - 100
+ * @param val Value of color, 0 - 100
+ * @param R, G, B receive the color, 0 - 255
  *
  * Description:
- *       Updates the saturation based on left and right buttons
- *       Uses de-bounce delay for the button press
+ *        Integer HSV to RGB, cheap enough to run for every pixel of a frame.
+ *        Needs no divide instruction.
  */
-u8 GetSat(void) {
-	static u8 Sat = 0;
-	if (NX4IO_isPressed (BTNR)) {
-		usleep(90000); // Debounce delay
-		if (NX4IO_isPressed(BTNR)) {
-			if (Sat == 100)
-				Sat = 0;
-			else
-				Sat++;
-		}
-	}
-	if (NX4IO_isPressed (BTNL)) {
-		usleep(90000); // Debounce delay
-		if (NX4IO_isPressed(BTNL)) {
-			if (Sat > 0)
-				Sat--;
-			if (Sat == 0)
-				Sat = 100;
-		}
+#define DIV255(x)	(((x) + 1 + ((x) >> 8)) >> 8)		// exact for x < 65535
+
+void HSVtoRGB(u16 hue, u8 sat, u8 val, u8 *R, u8 *G, u8 *B) {
+	u32 v, s, rem, p, q, t;
+	u16 region;
+
+	if (hue >= 360)
+		hue -= 360;
+	v = ((u32) val * 653) >> 8;				// 0 - 100 to 0 - 255
+	s = ((u32) sat * 653) >> 8;
+	region = (hue * 1093) >> 16;			// hue / 60
+	rem = ((hue - region * 60) * 1105) >> 8;	// fraction of the region, 0 - 255
+
+	p = DIV255(v * (255 - s));
+	q = DIV255(v * (255 - DIV255(s * rem)));
+	t = DIV255(v * (255 - DIV255(s * (255 - rem))));
+
+	switch (region) {
+	case 0:
+		*R = v; *G = t; *B = p;
+		break;
+	case 1:
+		*R = q; *G = v; *B = p;
+		break;
+	case 2:
+		*R = p; *G = v; *B = t;
+		break;
+	case 3:
+		*R = p; *G = q; *B = v;
+		break;
+	case 4:
+		*R = t; *G = p; *B = v;
+		break;
+	default:
+		*R = v; *G = p; *B = q;
+		break;
 	}
-	return Sat;
 }
 
-/**u8 GetVal(void)
+/** void UpdateStrip(u32 now, u16 hue, u8 sat, u8 val)
  *
- * @return Val for the color
+ * @param now TS_now() at the top of the main loop
+ * @param hue Hue of the first pixel
+ * @param sat Saturation of color
+ * @param val Value of color
  *
  * Description:
- *       Updates the V value based on up and down buttons
- *       Uses de-bounce delay for the button press
+ *        Drives the WS2812 strip at up to WS2812_FPS.  The strip shows one
+ *        turn of the color wheel starting at the current hue.  The frame is
+ *        only uploaded again when the controls change, otherwise the front
+ *        bank is sent again.  The upload goes to the back bank, so it is
+ *        done even while the engine is still sending the front one; the new
+ *        frame is then shown on the first pass the engine is free.
  */
-u8 GetVal(void) {
-	static u8 Val = 0;
-	if (NX4IO_isPressed (BTNU)) {
-		usleep(90000); // Debounce delay
-		if (NX4IO_isPressed(BTNU)) {
-			if (Val == 100)
-				Val = 0;
-			else
-				Val++;
-		}
-	}
-	if (NX4IO_isPressed (BTND)) {
-		usleep(90000); // Debounce delay
-		if (NX4IO_isPressed(BTND)) {
-			if (Val > 0)
-				Val--;
-			if (Val == 0)
-				Val = 100;
+void UpdateStrip(u32 now, u16 hue, u8 sat, u8 val) {
+	static u32 next_frame;
+	static u16 h = 0xFFFF;
+	static u8 s, v;
+	static bool uploaded;			// the back bank holds a frame not shown yet
+	u32 step, acc;
+	u16 i, n;
+	u8 R, G, B;
+
+	n = WS_NumPixels();
+	if (!WS_Present() || n == 0 || (s32) (now - next_frame) < 0)
+		return;
+
+	if (h != hue || s != sat || v != val) {
+		step = (360UL << 16) / n;
+		acc = (u32) hue << 16;
+		WS_BeginUpload();
+		for (i = 0; i < n; i++) {
+			HSVtoRGB((acc >> 16) % 360, sat, val, &R, &G, &B);
+			WS_SetPixel(i, R, G, B);
+			acc += step;
 		}
+		WS_EndUpload();
+		h = hue;
+		s = sat;
+		v = val;
+		uploaded = true;
 	}
-	return Val;
+
+	if (!WS_Show(uploaded))
+		return;									// still sending, try again next pass
+	uploaded = false;
+	next_frame += AXI_CLOCK_FREQ_HZ / WS2812_FPS;
+	if ((s32) (now - next_frame) >= 0)			// fell behind, don't try to catch up
+		next_frame = now + AXI_CLOCK_FREQ_HZ / WS2812_FPS;
 }
 
-/**bool GetDetectType(void)
+/** const u8 *GetRGBcommand(void)
+ *
+ * @return The R, G and B values last written to the RGB LEDs
+ */
+const u8 *GetRGBcommand(void) {
+	return rgb_command;
+}
+
+#if CFG_HW_DETECT
+/** void ReadHwDetector(void)
  *
- * @return which type of pwm detection is needed
- *         1 - for HW detect
- *         2 - for SW detect
  * Description:
- *        Based on the zero switch position to detect which type of PWM detection to use
- *        and turn on and off LED0 based on that.
+ *        Reads the high and low counts of the pwm_detector for each color,
+ *        converts them to duty cycles and publishes them through hw_duty.
+ *        pwm_detector reports a constant level with one of the counts 0 and
+ *        the other not, those channels are published as saturated.
+ *        pwm_detector updates the counts once a PWM period, so nothing is
+ *        published until one of them changes, the same as FIT_Handler only
+ *        publishes sw_duty when a duty changes.
+ *        Must only be called from the main loop, it is the only writer.
  */
-bool GetDetectType(void) {
-	u32 leds_data = NX4IO_getLEDS_DATA();
-	if ((NX4IO_getSwitches() & 0x001) == 1) {
-		NX4IO_setLEDs(leds_data | (1UL << 0));
-		//OLEDrgb_PutStringXY(7,7, "HW" );
-		return true;
-	} else {
-		NX4IO_setLEDs(leds_data & ~(1UL << 0));
-		//OLEDrgb_PutStringXY(7,7, "SW" );
-		return false;
+void ReadHwDetector(void) {
+	static u32 last_high[NUM_DUTY_CHANNELS], last_low[NUM_DUTY_CHANNELS];
+	static bool have_last = false;
+	u8 duty[NUM_DUTY_CHANNELS];
+	u32 high[NUM_DUTY_CHANNELS], low[NUM_DUTY_CHANNELS];
+	bool changed = !have_last;
+	u8 saturated = 0;
+	u32 start = TS_now();
+	u8 ch;
+
+	high[0] = XGpio_DiscreteRead(&GPIOInstR, GPIO_R_INPUT_HIGH_CHANNEL);
+	low[0] = XGpio_DiscreteRead(&GPIOInstR, GPIO_R_INPUT_LOW_CHANNEL);
+	high[1] = XGpio_DiscreteRead(&GPIOInstG, GPIO_G_INPUT_HIGH_CHANNEL);
+	low[1] = XGpio_DiscreteRead(&GPIOInstG, GPIO_G_INPUT_LOW_CHANNEL);
+	high[2] = XGpio_DiscreteRead(&GPIOInstB, GPIO_B_INPUT_HIGH_CHANNEL);
+	low[2] = XGpio_DiscreteRead(&GPIOInstB, GPIO_B_INPUT_LOW_CHANNEL);
+	for (ch = 0; ch < NUM_DUTY_CHANNELS; ch++) {
+		changed |= (high[ch] != last_high[ch]) || (low[ch] != last_low[ch]);
+		last_high[ch] = high[ch];
+		last_low[ch] = low[ch];
+		duty[ch] = calc_duty(high[ch], low[ch]);
+		if ((high[ch] == 0) != (low[ch] == 0))
+			saturated |= DUTY_SATURATED(ch);
 	}
+	have_last = true;
+	if (changed) {
+		DUTY_Publish(&hw_duty, duty, saturated);
+		TRACE_PULSE(TRACE_HW_PUBLISH);
+	}
+	COST_Add(&hw_cost, TS_now() - start);
 }
+#endif /* CFG_HW_DETECT */
 
-/** bool IsExit(void)
+/** bool HandleInputEvents(ColorControl *ctl)
  *
- * @return 1 for running; 0 for exit
+ * @param ctl the color controls to update
+ * @return true if any of the controls changed
  *
  * Description:
- *       Checks the buttons and encoder when to exit
- *       Uses de-bounce delay for the button press
+ *        Drains the input event queue and applies each event to the controls
+ *        - Rotary encoder steps change the hue (0 - 360, wraps around)
+ *        - Right and left buttons increment and decrement the saturation
+ *        - Up and down buttons increment and decrement the value
+ *        - Switch 0 selects hardware (up) or software (down) PWM detection,
+ *          LED0 follows it
+ *        - Switch 1 runs both detectors side by side (A/B mode), LED1 follows it
+ *        - Switch 2 going up prints the A/B statistics
+ *        - Switch 3 going up runs the color change latency benchmark
+ *        - Switches 6:4 select the pwm_detector prescale (resolution)
+ *        - Switches 9:7 select the RGB PWM carrier period (pwm_carrier_us[])
+ *        - Switch 10 shows the duty strip chart in place of the color picker,
+ *          switches 12:11 select its sample rate (chart_rate_hz[])
+ *        - Switch 13 converts HSV to RGB and runs the LED PWM in the fabric
+ *        - Switch 15 turns the binary telemetry stream on
+ *        - Center button or the encoder button exits
+ *        Holding a button auto repeats, the debouncing is done by the scan.
  */
-bool IsExit(void) {
-	u32 state = ENC_getState(&pmodENC_inst);
-	if (ENC_buttonPressed(state)) {
-		usleep(5000); // Debounce delay
-		if (ENC_buttonPressed(state))
-			return 0;
-	}
+bool HandleInputEvents(ColorControl *ctl) {
+	InputEvent ev;
+	bool changed = false;
+	int hue;
+	u32 leds_data;
 
-	if (NX4IO_isPressed (BTNC)) {
-		usleep(5000); // Debounce delay
-		if (NX4IO_isPressed(BTNC))
-			return 0;
-	}
+	while (INPUT_Get(&ev)) {
+		switch (ev.type) {
+		case EVT_ENC_STEP:
+			hue = ctl->hue + ev.value;
+			if (hue > 360)
+				hue = 0;
+			if (hue < 0)
+				hue = 360;
+			ctl->hue = hue;
+			changed = true;
+			break;
+
+		case EVT_BTN_PRESS:
+		case EVT_BTN_REPEAT:
+			switch (ev.code) {
+			case INPUT_BTN_R:
+				if (ctl->sat == 100)
+					ctl->sat = 0;
+				else
+					ctl->sat++;
+				break;
+			case INPUT_BTN_L:
+				if (ctl->sat > 0)
+					ctl->sat--;
+				if (ctl->sat == 0)
+					ctl->sat = 100;
+				break;
+			case INPUT_BTN_U:
+				if (ctl->val == 100)
+					ctl->val = 0;
+				else
+					ctl->val++;
+				break;
+			case INPUT_BTN_D:
+				if (ctl->val > 0)
+					ctl->val--;
+				if (ctl->val == 0)
+					ctl->val = 100;
+				break;
+			case INPUT_BTN_C:
+			case INPUT_BTN_ENC:
+				ctl->exit = true;
+				break;
+			}
+			changed = true;
+			break;
 
-	return 1;
+		case EVT_SW_CHANGE:
+			if ((u16) ev.value & ~ctl->switches & 0x004)
+				ctl->ab_report = true;
+			if ((u16) ev.value & ~ctl->switches & 0x008)
+				ctl->bench_start = true;
+			ctl->switches = (u16) ev.value;
+			ctl->hw_detect = (ctl->switches & 0x001) != 0;
+			ctl->ab_mode = (ctl->switches & 0x002) != 0;
+			ctl->prescale = (ctl->switches >> 4) & 0x7;
+			ctl->carrier = (ctl->switches >> 7) & 0x7;
+			ctl->chart = (ctl->switches & 0x400) != 0;
+			ctl->chart_rate = (ctl->switches >> 11) & 0x3;
+			ctl->hw_color = (ctl->switches & 0x2000) != 0;
+			ctl->telemetry = (ctl->switches & 0x8000) != 0;
+			leds_data = NX4IO_getLEDS_DATA() & ~0x3UL;
+			NX4IO_setLEDs(leds_data | (ctl->switches & 0x3));
+			changed = true;
+			break;
+
+		default:
+			break;
+		}
+	}
+	return changed;
 }
 
 /**
@@ -323,8 +443,10 @@ void DisplayDutycycle(u8 r_duty, u8 g_duty, u8 b_duty) {
  *        Displays the string at xy location on the pmod oled display
  */
 void OLEDrgb_PutStringXY(u8 x, u8 y, char* s) {
+	TRACE_ON(TRACE_OLED);
 	OLEDrgb_SetCursor(&pmodOLEDrgb_inst, x, y);
 	OLEDrgb_PutString(&pmodOLEDrgb_inst, s);
+	TRACE_OFF(TRACE_OLED);
 }
 
 /**
@@ -338,10 +460,36 @@ void OLEDrgb_PutStringXY(u8 x, u8 y, char* s) {
  *        Displays the number at xy location on the pmod oled display
  */
 void OLEDrgb_PutIntigerXY(u8 x, u8 y, int32_t num, int32_t radix) {
-	char buf[16];
+	char buf[33];
+	TRACE_ON(TRACE_OLED);
 	OLEDrgb_SetCursor(&pmodOLEDrgb_inst, x, y);
-	PMDIO_itoa(num, buf, radix);
+	if (FMT_itoa(num, buf, radix) == 0)
+		PMDIO_itoa(num, buf, radix);
 	OLEDrgb_PutString(&pmodOLEDrgb_inst, buf);
+	TRACE_OFF(TRACE_OLED);
+}
+
+/**
+ *
+ * @param x x axis for the display
+ * @param y y axis for the display
+ * @param num Integer to be displayed on the screen in decimal
+ * @param width Number of characters the field takes on the screen
+ * @param pad Fill character for the field, ' ' or '0'
+ *
+ * Description:
+ *        Displays the number right aligned in a fixed width field at xy location
+ *        on the pmod oled display.  Overwrites whatever was in the field before.
+ */
+void OLEDrgb_PutFixedXY(u8 x, u8 y, int32_t num, u8 width, char pad) {
+	char buf[FMT_MAX_CHARS + 8];
+	if (width > sizeof(buf) - 1)
+		width = sizeof(buf) - 1;
+	FMT_i32toa_fixed(num, buf, width, pad);
+	TRACE_ON(TRACE_OLED);
+	OLEDrgb_SetCursor(&pmodOLEDrgb_inst, x, y);
+	OLEDrgb_PutString(&pmodOLEDrgb_inst, buf);
+	TRACE_OFF(TRACE_OLED);
 }
 
 /**
@@ -351,25 +499,62 @@ void OLEDrgb_PutIntigerXY(u8 x, u8 y, int32_t num, int32_t radix) {
  * @param val
  *
  * Description:
- *        Updates the the values of HSV on the display.
+ *        Updates the the values of HSV and the RGB set by UpdateRGBled() on
+ *        the display and moves the color picker cursors (see color_view.h)
+ *        unless the strip chart is shown.  Everything on the PmodOLEDrgb is
+ *        drawn from here once it is up, so call it on every main loop pass:
+ *        nothing is sent while CHART_DisplayBusy(), it is drawn on a later
+ *        pass instead.
  */
 void UpdateDispaly(u16 hue, u8 sat, u8 val) {
-	static u16 h = 0;
+	static u16 h = 0xFFFF;				// nothing shown yet
 	static u8 s = 0, v = 0;
+	static bool labels = false;
+	static bool picker = false;			// the color picker is on the screen
+	char buf[13];
 
+	if (!BOOT_DisplayReady() || CHART_DisplayBusy())
+		return;
+	if (!labels) {
+		OLEDrgb_PutStringXY(0, 1, "H:");
+		OLEDrgb_PutStringXY(0, 3, "S:");
+		OLEDrgb_PutStringXY(0, 5, "V:");
+		labels = true;
+	}
+	if (CHART_Active()) {
+		picker = false;
+	} else if (!picker || h != hue || s != sat || v != val) {
+		VIEW_Update(hue, sat, val);
+		picker = true;
+	}
 	if (h != hue || s != sat || v != val) {
-		OLEDrgb_PutStringXY(0, 1, "H:   ");
-		OLEDrgb_PutIntigerXY(2, 1, hue, 10);
-		OLEDrgb_PutStringXY(0, 3, "S:   ");
-		OLEDrgb_PutIntigerXY(2, 3, sat, 10);
-		OLEDrgb_PutStringXY(0, 5, "V:   ");
-		OLEDrgb_PutIntigerXY(2, 5, val, 10);
-		//OLEDrgb_DrawRectangle(&pmodOLEDrgb_inst ,50,0,95,103, OLEDrgb_BuildHSV(h,s,v) ,true, OLEDrgb_BuildHSV(h,s,v));
+		OLEDrgb_PutFixedXY(2, 1, hue, 3, ' ');
+		OLEDrgb_PutFixedXY(2, 3, sat, 3, ' ');
+		OLEDrgb_PutFixedXY(2, 5, val, 3, ' ');
 		h = hue;
 		s = sat;
 		v = val;
 	}
+	if (rgb_pending) {
+		// "R255G255B255" in one write, fixed width so no blanking is needed
+		buf[0] = 'R';
+		FMT_i32toa_fixed(rgb_shown[0], &buf[1], 3, ' ');
+		buf[4] = 'G';
+		FMT_i32toa_fixed(rgb_shown[1], &buf[5], 3, ' ');
+		buf[8] = 'B';
+		FMT_i32toa_fixed(rgb_shown[2], &buf[9], 3, ' ');
+		OLEDrgb_PutStringXY(0, 7, buf);
 
+		// Swatch under the color picker, see color_view.h
+		TRACE_ON(TRACE_OLED);
+		OLEDrgb_DrawRectangle(&pmodOLEDrgb_inst, VIEW_X0, VIEW_SWATCH_Y0,
+				VIEW_X0 + VIEW_WIDTH - 1,
+				VIEW_SWATCH_Y0 + VIEW_SWATCH_HEIGHT - 1,
+				OLEDrgb_BuildRGB(rgb_shown[0], rgb_shown[1], rgb_shown[2]), true,
+				OLEDrgb_BuildRGB(rgb_shown[0], rgb_shown[1], rgb_shown[2]));
+		TRACE_OFF(TRACE_OLED);
+		rgb_pending = false;
+	}
 }
 
 /**
@@ -380,25 +565,78 @@ void UpdateDispaly(u16 hue, u8 sat, u8 val) {
  *
  * Description:
  *        Calculates the Duty cycle based on the counts
+ *        Keeps no state so it is safe to call from FIT_Handler and the
+ *        main loop at the same time
  */
 u8 calc_duty(u32 high, u32 low) {
-	static u32 h = 1, l = 1;
 	u32 sum;
-	static u8 duty;
-	if (h != high || l != low) {
-		h = high;
-		l = low;
-
-		sum = (high) + (low);
-		duty = (100 * (high)) / sum;
-		duty = duty * 2;
-		if (duty < 0)
-			duty = 0;
-		if (duty > 99)
-			duty = 99;
-
-		return duty;
-	}
+	u32 duty;
+
+	sum = (high) + (low);
+	if (sum == 0)
+		return 0;
+	duty = (100 * (high)) / sum;
+	duty = duty * 2;
+	if (duty > 99)
+		duty = 99;
+
 	return duty;
+}
+
+#ifdef FMT_BENCHMARK
+/**
+ *
+ * Description:
+ *        Times the display number conversions on the target and prints the
+ *        cycles per conversion for PMDIO_itoa() against the num_format routines.
+ *        Also checks both produce the same string.
+ */
+void RunFormatBenchmark(void) {
+	static const int32_t values[] = { 0, 7, 42, 99, 100, 255, 360, 12345,
+			-42, 2147483647 };
+	const u32 nvalues = sizeof(values) / sizeof(values[0]);
+	const u32 iterations = 1000;
+	char ref[33], buf[33];
+	u32 start, itoa_dec, fmt_dec, itoa_hex, fmt_hex, mismatches = 0;
+	u32 i, n;
+
+	for (n = 0; n < nvalues; n++) {
+		PMDIO_itoa(values[n], ref, 10);
+		FMT_itoa(values[n], buf, 10);
+		mismatches += (strcmp(ref, buf) != 0);
+		PMDIO_itoa(values[n], ref, 16);
+		FMT_itoa(values[n], buf, 16);
+		mismatches += (strcmp(ref, buf) != 0);
+	}
+
+	start = TS_now();
+	for (i = 0; i < iterations; i++)
+		for (n = 0; n < nvalues; n++)
+			PMDIO_itoa(values[n], buf, 10);
+	itoa_dec = TS_now() - start;
+
+	start = TS_now();
+	for (i = 0; i < iterations; i++)
+		for (n = 0; n < nvalues; n++)
+			FMT_i32toa(values[n], buf);
+	fmt_dec = TS_now() - start;
+
+	start = TS_now();
+	for (i = 0; i < iterations; i++)
+		for (n = 0; n < nvalues; n++)
+			PMDIO_itoa(values[n], buf, 16);
+	itoa_hex = TS_now() - start;
+
+	start = TS_now();
+	for (i = 0; i < iterations; i++)
+		for (n = 0; n < nvalues; n++)
+			FMT_u32tohex(values[n], buf, 0);
+	fmt_hex = TS_now() - start;
 
+	n = iterations * nvalues;
+	xil_printf("Format benchmark, cycles per conversion (%d conversions)\n", n);
+	xil_printf("  dec: PMDIO_itoa %d  FMT_i32toa   %d\n", itoa_dec / n, fmt_dec / n);
+	xil_printf("  hex: PMDIO_itoa %d  FMT_u32tohex %d\n", itoa_hex / n, fmt_hex / n);
+	xil_printf("  mismatches: %d\n", mismatches);
 }
+#endif /* FMT_BENCHMARK */
@@ -8,17 +8,56 @@
 #ifndef SRC_FUNCTIONAL_INTERFACE_H_
 #define SRC_FUNCTIONAL_INTERFACE_H_
 
+#include <string.h>
 #include "hw_interface.h"
+#include "input_events.h"
+#include "telemetry.h"
+#include "ab_compare.h"
+#include "latency_bench.h"
+#include "ws2812.h"
+#include "color_view.h"
+#include "boot.h"
+#include "isr_bench.h"
+#include "uart_command.h"
+#include "strip_chart.h"
+#include "hsv_pwm.h"
+#include "trace.h"
 
+/**************************** Type Definitions ******************************/
+
+// Everything the user controls, updated from the input events
+typedef struct ColorControl {
+	u16		hue;			// 0 - 360
+	u8		sat;			// 0 - 100
+	u8		val;			// 0 - 100
+	u16		switches;		// last slide switch positions
+	bool	hw_detect;		// switch 0: true - HW detect; false - SW detect
+	bool	ab_mode;		// switch 1: run and compare both detectors
+	bool	ab_report;		// switch 2 went up: print the A/B statistics
+	bool	bench_start;	// switch 3 went up: run the latency benchmark
+	u8		prescale;		// switches 6:4: pwm_detector prescale select
+	u8		carrier;		// switches 9:7: index into pwm_carrier_us[]
+	bool	chart;			// switch 10: duty strip chart instead of the picker
+	u8		chart_rate;		// switches 12:11: index into chart_rate_hz[]
+	bool	hw_color;		// switch 13: HSV to RGB and PWM in the fabric
+	bool	telemetry;		// switch 15: binary telemetry on the UART
+	bool	exit;			// center or encoder button pressed
+} ColorControl;
+
+/************************** Function Prototypes *****************************/
 void UpdateRGBled(u16 hue, u8 sat, u8 val, bool display);
-u16 GetHue(void);
-u8 GetSat(void);
-u8 GetVal(void);
-bool GetDetectType(void);
-bool IsExit(void);
+bool HandleInputEvents(ColorControl *ctl);
+void SetRGBled(u8 R, u8 G, u8 B);
+const u8 *GetRGBcommand(void);
+void HSVtoRGB(u16 hue, u8 sat, u8 val, u8 *R, u8 *G, u8 *B);
+void UpdateStrip(u32 now, u16 hue, u8 sat, u8 val);
+#if CFG_HW_DETECT
+void ReadHwDetector(void);
+#endif
 void DisplayDutycycle(u8 r_duty, u8 g_duty, u8 b_duty);
 void OLEDrgb_PutStringXY(u8 x, u8 y, char* s);
 void OLEDrgb_PutIntigerXY(u8 x, u8 y, int32_t num, int32_t radix);
+void OLEDrgb_PutFixedXY(u8 x, u8 y, int32_t num, u8 width, char pad);
 void UpdateDispaly(u16 hue, u8 sat, u8 val);
 u8 calc_duty(u32 high, u32 low);
 
@@ -28,5 +67,8 @@ void RunTest2(void);
 void RunTest3(void);
 void RunTest4(void);
 void RunTest5(void);
+#ifdef FMT_BENCHMARK
+void RunFormatBenchmark(void);
+#endif
 
 #endif /* SRC_FUNCTIONAL_INTERFACE_H_ */
@@ -0,0 +1,134 @@
+/*
+ * hsv_pwm.c
+ */
+
+#include "hsv_pwm.h"
+#include "xil_io.h"
+
+static bool use;				// UpdateRGBled() goes through the fabric
+static bool driving;			// the fabric has the LEDs
+
+#ifdef HSVPWM_BASEADDR
+
+#define HSVPWM_WriteReg(offset, value)	Xil_Out32(HSVPWM_BASEADDR + (offset), (value))
+#define HSVPWM_ReadReg(offset)			Xil_In32(HSVPWM_BASEADDR + (offset))
+
+/****************************************************************************/
+/**
+ * Initialize the HSV color register, Nexys4IO keeps the LEDs
+ *
+ * @return	XST_SUCCESS
+ *****************************************************************************/
+int HSVPWM_Init(void) {
+	driving = false;
+	HSVPWM_WriteReg(HSVPWM_HSV_OFFSET, 0);
+	HSVPWM_SetCarrierPeriod(PWM_CarrierPeriod());
+	return XST_SUCCESS;
+}
+
+/****************************************************************************/
+/**
+ * @return	true if the HSV color register is in the hardware
+ *****************************************************************************/
+bool HSVPWM_Present(void) {
+	return true;
+}
+
+/****************************************************************************/
+/**
+ * Set the color and give the LEDs to the fabric
+ *
+ * One AXI write, the conversion and PWM take it from there.
+ *
+ * @param	hue is 0 - 360
+ * @param	sat is 0 - 100
+ * @param	val is 0 - 100
+ *****************************************************************************/
+void HSVPWM_Set(u16 hue, u8 sat, u8 val) {
+	HSVPWM_WriteReg(HSVPWM_HSV_OFFSET, HSVPWM_HSV_ENABLE
+			| ((u32) val << 24) | ((u32) sat << 16) | hue);
+	driving = true;
+}
+
+/****************************************************************************/
+/**
+ * Give the LEDs back to Nexys4IO
+ *****************************************************************************/
+void HSVPWM_Release(void) {
+	if (driving) {
+		HSVPWM_WriteReg(HSVPWM_HSV_OFFSET,
+				HSVPWM_ReadReg(HSVPWM_HSV_OFFSET) & ~HSVPWM_HSV_ENABLE);
+		driving = false;
+	}
+}
+
+/****************************************************************************/
+/**
+ * Get the R, G and B the fabric made of the last color
+ *
+ * The read waits for a conversion in flight, so this is the color just set.
+ *****************************************************************************/
+void HSVPWM_GetRGB(u8 *R, u8 *G, u8 *B) {
+	u32 rgb = HSVPWM_ReadReg(HSVPWM_RGB_OFFSET);
+
+	*R = rgb >> 16;
+	*G = rgb >> 8;
+	*B = rgb;
+}
+
+/****************************************************************************/
+/**
+ * Match the fabric PWM period to the Nexys4IO one
+ *
+ * @param	period_us is the carrier period, see PWM_SetCarrierPeriod()
+ *****************************************************************************/
+void HSVPWM_SetCarrierPeriod(u32 period_us) {
+	HSVPWM_WriteReg(HSVPWM_PWM_DIV_OFFSET,
+			period_us * (AXI_CLOCK_FREQ_HZ / 1000000) / HSVPWM_STEPS_PER_PERIOD);
+}
+
+#else
+
+int HSVPWM_Init(void) {
+	return XST_DEVICE_NOT_FOUND;
+}
+
+bool HSVPWM_Present(void) {
+	return false;
+}
+
+void HSVPWM_Set(u16 hue, u8 sat, u8 val) {
+}
+
+void HSVPWM_Release(void) {
+}
+
+void HSVPWM_GetRGB(u8 *R, u8 *G, u8 *B) {
+	*R = *G = *B = 0;
+}
+
+void HSVPWM_SetCarrierPeriod(u32 period_us) {
+}
+
+#endif /* HSVPWM_BASEADDR */
+
+/****************************************************************************/
+/**
+ * Choose how UpdateRGBled() sets the LEDs
+ *
+ * @param	on is true for the fabric converter, false for the firmware one
+ * 			and Nexys4IO.  Ignored when the converter is not in the design.
+ *****************************************************************************/
+void HSVPWM_Use(bool on) {
+	use = on && HSVPWM_Present();
+	if (!use)
+		HSVPWM_Release();
+}
+
+/****************************************************************************/
+/**
+ * @return	true if UpdateRGBled() goes through the fabric converter
+ *****************************************************************************/
+bool HSVPWM_InUse(void) {
+	return use;
+}
@@ -0,0 +1,48 @@
+/*
+ * hsv_pwm.h
+ *
+ *  Driver for the HSV color register (hardware/hsv_pwm_axi.v).  The fabric
+ *  converts the color to R, G and B with the same arithmetic as HSVtoRGB()
+ *  and runs the RGB1/RGB2 PWM itself, so a color change is one AXI write
+ *  instead of the conversion and the Nexys4IO channel and duty cycle
+ *  writes for both LEDs.  The new color is on the pins from the start of
+ *  the next PWM period.
+ *
+ *  Writing a color hands the LEDs to the fabric, HSVPWM_Release() hands
+ *  them back to Nexys4IO.  With switch 13 up UpdateRGBled() goes through
+ *  here, SetRGBled() always goes through Nexys4IO.
+ *
+ *  The register sits behind an AXI port exported from the block design.
+ *  The driver compiles to stubs when the BSP has no address for it.
+ */
+
+#ifndef SRC_HSV_PWM_H_
+#define SRC_HSV_PWM_H_
+
+#include "hw_interface.h"
+
+/************************** Constant Definitions ****************************/
+
+#if CFG_HSV_FABRIC && defined(XPAR_M_AXI_HSV_BASEADDR)
+#define HSVPWM_BASEADDR			XPAR_M_AXI_HSV_BASEADDR
+#endif
+
+// Register offsets, see hsv_pwm_axi.v
+#define HSVPWM_HSV_OFFSET		0x0
+#define HSVPWM_RGB_OFFSET		0x4
+#define HSVPWM_PWM_DIV_OFFSET	0x8
+
+#define HSVPWM_HSV_ENABLE		0x80000000
+#define HSVPWM_STEPS_PER_PERIOD	512			// half scale, as Nexys4IO
+
+/************************** Function Prototypes *****************************/
+int HSVPWM_Init(void);
+bool HSVPWM_Present(void);
+void HSVPWM_Use(bool on);
+bool HSVPWM_InUse(void);
+void HSVPWM_Set(u16 hue, u8 sat, u8 val);
+void HSVPWM_Release(void);
+void HSVPWM_GetRGB(u8 *R, u8 *G, u8 *B);
+void HSVPWM_SetCarrierPeriod(u32 period_us);
+
+#endif /* SRC_HSV_PWM_H_ */
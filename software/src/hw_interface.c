@@ -6,18 +6,29 @@
  */
 
 #include "hw_interface.h"
+#include "boot.h"
+#include "trace.h"
 
 /****************************************************************************/
 /**
  * initialize the system
  *
- * This function is executed once at start-up and after resets.  It initializes
- * the peripherals and registers the interrupt handler(s)
+ * This function is executed once at start-up and after resets.  It only
+ * brings up what the RGB LEDs need: the PWM clock, the timestamp counter and
+ * Nexys4IO.  The inputs follow in do_init_inputs() once the first color is
+ * showing and the PmodOLEDrgb in do_init_display(), see boot.h.
  *****************************************************************************/
 
 int do_init(void) {
 	uint32_t status;				// status from Xilinx Lib calls
 
+	status = AXI_Timer_initialize();
+	if (status != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+	TS_initialize();
+	BOOT_Mark(BOOT_TIMERS);
+
 	// initialize the Nexys4 driver and (some of)the devices
 	status = (uint32_t) NX4IO_initialize(NX4IO_BASEADDR);
 	if (status != XST_SUCCESS) {
@@ -33,11 +44,21 @@ int do_init(void) {
 	NX4IO_SSEG_setSSEG_DATA(SSEGHI, 0x0058E30E);
 	NX4IO_SSEG_setSSEG_DATA(SSEGLO, 0x00144116);
 
-	//Initializing PMODoLEDRGB
-	OLEDrgb_begin(&pmodOLEDrgb_inst, RGBDSPLY_GPIO_BASEADDR,
-			RGBDSPLY_SPI_BASEADDR);
-	//Set Default font color to Blue
-	OLEDrgb_SetFontColor(&pmodOLEDrgb_inst, OLEDrgb_BuildHSV(255, 255, 255));
+	//Clear the LED's
+	NX4IO_setLEDs(0x00);
+
+	return XST_SUCCESS;
+}
+
+/****************************************************************************/
+/**
+ * initialize the input path
+ *
+ * GPIO (software and hardware PWM detection), the pmodENC and the FIT
+ * interrupt.  Interrupts are enabled by the caller.
+ *****************************************************************************/
+int do_init_inputs(void) {
+	uint32_t status;				// status from Xilinx Lib calls
 
 	// initialize the pmodENC and hardware
 	ENC_begin(&pmodENC_inst, PMODENC_BASEADDR);
@@ -48,6 +69,7 @@ int do_init(void) {
 		return XST_FAILURE;
 	}
 
+#if CFG_HW_DETECT
 	status = XGpio_Initialize(&GPIOInstR, GPIO_R_DEVICE_ID);
 	if (status != XST_SUCCESS) {
 		return XST_FAILURE;
@@ -62,11 +84,14 @@ int do_init(void) {
 	if (status != XST_SUCCESS) {
 		return XST_FAILURE;
 	}
+#endif
 
 	// Set all GPIO direction weather it is Input or output
 	XGpio_SetDataDirection(&GPIOInst0, GPIO_0_INPUT_0_CHANNEL, 0xFF);
 	XGpio_SetDataDirection(&GPIOInst0, GPIO_0_OUTPUT_0_CHANNEL, 0x00);
+	HWDET_SetPrescale(HWDET_PRESCALE_DEFAULT);
 
+#if CFG_HW_DETECT
 	XGpio_SetDataDirection(&GPIOInstR, GPIO_R_INPUT_HIGH_CHANNEL, 0xFFFFFFFF);
 	XGpio_SetDataDirection(&GPIOInstR, GPIO_R_INPUT_LOW_CHANNEL, 0xFFFFFFFF);
 
@@ -75,11 +100,7 @@ int do_init(void) {
 
 	XGpio_SetDataDirection(&GPIOInstB, GPIO_B_INPUT_HIGH_CHANNEL, 0xFFFFFFFF);
 	XGpio_SetDataDirection(&GPIOInstB, GPIO_B_INPUT_LOW_CHANNEL, 0xFFFFFFFF);
-
-	status = AXI_Timer_initialize();
-	if (status != XST_SUCCESS) {
-		return XST_FAILURE;
-	}
+#endif
 
 	// initialize the interrupt controller
 	status = XIntc_Initialize(&IntrptCtlrInst, INTC_DEVICE_ID);
@@ -88,8 +109,13 @@ int do_init(void) {
 	}
 
 	// connect the fixed interval timer (FIT) handler to the interrupt
+#ifdef FIT_FAST_INTERRUPT
+	status = XIntc_ConnectFastHandler(&IntrptCtlrInst, FIT_INTERRUPT_ID,
+			(XFastInterruptHandler) FIT_Handler);
+#else
 	status = XIntc_Connect(&IntrptCtlrInst, FIT_INTERRUPT_ID,
 			(XInterruptHandler) FIT_Handler, (void *) 0);
+#endif
 	if (status != XST_SUCCESS) {
 		return XST_FAILURE;
 
@@ -105,14 +131,44 @@ int do_init(void) {
 	// enable the FIT interrupt
 	XIntc_Enable(&IntrptCtlrInst, FIT_INTERRUPT_ID);
 
-	//Clear the LED's
-	NX4IO_setLEDs(0x00);
-
 	return XST_SUCCESS;
 }
+
+/****************************************************************************/
+/**
+ * initialize the PmodOLEDrgb
+ *
+ * The driver's power up sequence waits for the panel, so this is run from
+ * the main loop after everything else is going (BOOT_Poll()).
+ *****************************************************************************/
+void do_init_display(void) {
+	TRACE_ON(TRACE_OLED);
+	//Initializing PMODoLEDRGB
+	OLEDrgb_begin(&pmodOLEDrgb_inst, RGBDSPLY_GPIO_BASEADDR,
+			RGBDSPLY_SPI_BASEADDR);
+	//Set Default font color to Blue
+	OLEDrgb_SetFontColor(&pmodOLEDrgb_inst, OLEDrgb_BuildHSV(255, 255, 255));
+	TRACE_OFF(TRACE_OLED);
+}
+// Carrier periods selected by switches 9:7, the default first
+const u32 pwm_carrier_us[PWM_CARRIER_SETTINGS] = {
+	PWM_PERIOD_DEFAULT_US, 32000, 16000, 8000, 4000, PWM_PERIOD_MIN_US,
+	96000, 128000
+};
+
+static u32 pwm_period_us;
+
+/*
+ * Timer load for a carrier period.  In down count auto reload mode the
+ * timer generates one pulse every load + 2 clocks.
+ */
+static u32 pwm_load(u32 period_us) {
+	return period_us * TS_TICKS_PER_USEC / PWM_STEPS_PER_PERIOD - 2;
+}
+
 /*
  * AXI timer initializes it to generate out a 4Khz signal, Which is given to the Nexys4IO module as clock input.
- * DO NOT MODIFY
+ * The carrier can be changed afterwards with PWM_SetCarrierPeriod().
  */
 int AXI_Timer_initialize(void) {
 
@@ -123,16 +179,21 @@ int AXI_Timer_initialize(void) {
 	if (status != XST_SUCCESS) {
 		return XST_FAILURE;
 	}
-	status = XTmrCtr_SelfTest(&AXITimerInst, TmrCtrNumber);
-	if (status != XST_SUCCESS) {
-		return XST_FAILURE;
+	// the timer passed on the cold boot, a warm reset does not change it
+	if (!BOOT_IsWarm()) {
+		status = XTmrCtr_SelfTest(&AXITimerInst, TmrCtrNumber);
+		if (status != XST_SUCCESS) {
+			return XST_FAILURE;
+		}
 	}
 	ctlsts = XTC_CSR_AUTO_RELOAD_MASK | XTC_CSR_EXT_GENERATE_MASK
 			| XTC_CSR_LOAD_MASK | XTC_CSR_DOWN_COUNT_MASK;
 	XTmrCtr_SetControlStatusReg(AXI_TIMER_BASEADDR, TmrCtrNumber, ctlsts);
 
 	//Set the value that is loaded into the timer counter and cause it to be loaded into the timer counter
-	XTmrCtr_SetLoadReg(AXI_TIMER_BASEADDR, TmrCtrNumber, 24998);
+	pwm_period_us = PWM_PERIOD_DEFAULT_US;
+	XTmrCtr_SetLoadReg(AXI_TIMER_BASEADDR, TmrCtrNumber,
+			pwm_load(pwm_period_us));
 	XTmrCtr_LoadTimerCounterReg(AXI_TIMER_BASEADDR, TmrCtrNumber);
 	ctlsts = XTmrCtr_GetControlStatusReg(AXI_TIMER_BASEADDR, TmrCtrNumber);
 	ctlsts &= (~XTC_CSR_LOAD_MASK);
@@ -147,6 +208,67 @@ int AXI_Timer_initialize(void) {
 
 }
 
+/*
+ * Starts the second counter of the AXI timer free-running up from 0.
+ * It is used as a cycle timestamp for the measurements, see TS_now().
+ */
+void TS_initialize(void) {
+	u32 ctlsts;		// control/status register or mask
+
+	ctlsts = XTC_CSR_AUTO_RELOAD_MASK | XTC_CSR_LOAD_MASK;
+	XTmrCtr_SetControlStatusReg(AXI_TIMER_BASEADDR, TmrCtrTsNumber, ctlsts);
+	XTmrCtr_SetLoadReg(AXI_TIMER_BASEADDR, TmrCtrTsNumber, 0);
+	XTmrCtr_LoadTimerCounterReg(AXI_TIMER_BASEADDR, TmrCtrTsNumber);
+
+	ctlsts &= (~XTC_CSR_LOAD_MASK);
+	ctlsts |= XTC_CSR_ENABLE_TMR_MASK;
+	XTmrCtr_SetControlStatusReg(AXI_TIMER_BASEADDR, TmrCtrTsNumber, ctlsts);
+}
+
+/*
+ * Sets the pwm_detector resolution.  The detectors count once every
+ * 2^sel clocks of clk_pwm_detect, so a larger setting saves power and
+ * reports smaller counts.  The duty cycle does not depend on it.
+ *
+ * @param	sel is 0 (every clock) to HWDET_PRESCALE_MAX
+ */
+void HWDET_SetPrescale(u8 sel) {
+	if (sel > HWDET_PRESCALE_MAX)
+		sel = HWDET_PRESCALE_MAX;
+	XGpio_DiscreteWrite(&GPIOInst0, GPIO_0_OUTPUT_0_CHANNEL,
+			sel << HWDET_PRESCALE_SHIFT);
+}
+
+/*
+ * Sets the RGB PWM carrier period.  The new load is picked up at the next
+ * timer reload, so the current PWM clock period finishes first.
+ *
+ * Both detectors only report a new duty once per carrier period, so a
+ * shorter period cuts the detection latency.  The software detector needs
+ * PWM_MIN_FIT_SAMPLES FIT samples per period for 1% resolution.  Below
+ * that it aliases, above PWM_PERIOD_MAX_US it takes the channel for stuck.
+ * Going to a period more than SW_STUCK_PERIODS times longer can show one
+ * false 0% or 99% on each detector before they have measured the new one.
+ *
+ * @param	period_us is PWM_PERIOD_MIN_US to PWM_PERIOD_MAX_US
+ *
+ * @return	XST_SUCCESS, XST_INVALID_PARAM if the period is out of range
+ */
+int PWM_SetCarrierPeriod(u32 period_us) {
+	if (period_us < PWM_PERIOD_MIN_US || period_us > PWM_PERIOD_MAX_US)
+		return XST_INVALID_PARAM;
+	pwm_period_us = period_us;
+	XTmrCtr_SetLoadReg(AXI_TIMER_BASEADDR, TmrCtrNumber, pwm_load(period_us));
+	return XST_SUCCESS;
+}
+
+/*
+ * @return	the RGB PWM carrier period in us
+ */
+u32 PWM_CarrierPeriod(void) {
+	return pwm_period_us;
+}
+
 /*********************** DISPLAY-RELATED FUNCTIONS ***********************************/
 
 /****************************************************************************/
@@ -228,22 +350,8 @@ void PMDIO_itoa(int32_t value, char *string, int32_t radix) {
  *****************************************************************************/
 void PMDIO_puthex(PmodOLEDrgb* InstancePtr, uint32_t num) {
 	char buf[9];
-	int32_t cnt;
-	char *ptr;
-	int32_t digit;
-
-	ptr = buf;
-	for (cnt = 7; cnt >= 0; cnt--) {
-		digit = (num >> (cnt * 4)) & 0xF;
-
-		if (digit <= 9) {
-			*ptr++ = (char) ('0' + digit);
-		} else {
-			*ptr++ = (char) ('a' - 10 + digit);
-		}
-	}
 
-	*ptr = (char) 0;
+	FMT_u32tohex(num, buf, 8);
 	OLEDrgb_PutString(InstancePtr, buf);
 
 	return;
@@ -269,9 +377,10 @@ void PMDIO_puthex(PmodOLEDrgb* InstancePtr, uint32_t num) {
  * or the entire display, for that matter.  Watch your string sizes.
  *****************************************************************************/
 void PMDIO_putnum(PmodOLEDrgb* InstancePtr, int32_t num, int32_t radix) {
-	char buf[16];
+	char buf[33];
 
-	PMDIO_itoa(num, buf, radix);
+	if (FMT_itoa(num, buf, radix) == 0)
+		PMDIO_itoa(num, buf, radix);
 	OLEDrgb_PutString(InstancePtr, buf);
 
 	return;
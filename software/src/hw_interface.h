@@ -11,6 +11,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include "build_config.h"
 #include "platform.h"
 #include "xparameters.h"
 #include "xstatus.h"
@@ -21,6 +22,8 @@
 #include "xgpio.h"
 #include "xintc.h"
 #include "xtmrctr.h"
+#include "num_format.h"
+#include "duty_publish.h"
 
 /************************** Constant Definitions ****************************/
 
@@ -33,6 +36,8 @@
 #define AXI_TIMER_BASEADDR		XPAR_AXI_TIMER_0_BASEADDR
 #define AXI_TIMER_HIGHADDR		XPAR_AXI_TIMER_0_HIGHADDR
 #define TmrCtrNumber			0
+#define TmrCtrTsNumber			1		// free-running timestamp counter
+#define TS_TICKS_PER_USEC		(AXI_CLOCK_FREQ_HZ / 1000000)
 
 
 // Definitions for peripheral NEXYS4IO
@@ -59,11 +64,52 @@
 #define FIT_COUNT				(FIT_IN_CLOCK_FREQ_HZ / FIT_CLOCK_FREQ_HZ)
 #define FIT_COUNT_1MSEC			40
 
+// RGB PWM carrier.  Counter 0 of the AXI timer generates the PWM clock for
+// Nexys4IO, one carrier period is PWM_STEPS_PER_PERIOD of those clocks.
+// Nexys4IO runs all six RGB channels off one counter, so they always switch
+// in phase.
+#define PWM_STEPS_PER_PERIOD		256
+#define PWM_PERIOD_DEFAULT_US		64000		// 4 kHz PWM clock, timer load 24998
+#define PWM_CARRIER_SETTINGS		8			// entries in pwm_carrier_us[]
+
+// FIT_Handler calls a channel 0% or 99% after SW_STUCK_PERIODS of the longer
+// of its last two measured periods without an edge, or SW_DETECT_TIMEOUT_TICKS
+// before a period has been measured (and at most that long)
+#ifndef SW_STUCK_PERIODS
+#define SW_STUCK_PERIODS			2
+#endif
+#define SW_DETECT_TIMEOUT_TICKS		10000
+
+// The software detector needs a FIT sample per duty percent in a period, and
+// a period has to end before its timeout
+#define PWM_MIN_FIT_SAMPLES			100
+#define PWM_PERIOD_MIN_US			(PWM_MIN_FIT_SAMPLES * 1000 / FIT_COUNT_1MSEC)
+#define PWM_PERIOD_MAX_US			(SW_DETECT_TIMEOUT_TICKS * 1000 / FIT_COUNT_1MSEC - 1)
+
+// Build with -DFIT_FAST_INTERRUPT to have the interrupt controller vector
+// straight to FIT_Handler (the fast interrupt path) instead of going through
+// the XIntc dispatcher.  The AXI INTC has to be built with C_HAS_FAST = 1.
+#ifdef FIT_FAST_INTERRUPT
+#if !defined(XPAR_XINTC_HAS_FAST) || (XPAR_XINTC_HAS_FAST != 1)
+#error "FIT_FAST_INTERRUPT needs an AXI INTC with fast interrupts enabled"
+#endif
+#define FIT_HANDLER_ATTR		__attribute__ ((fast_interrupt))
+#else
+#define FIT_HANDLER_ATTR
+#endif
+
 // GPIO parameters
 #define GPIO_0_DEVICE_ID			XPAR_AXI_GPIO_0_DEVICE_ID
 #define GPIO_0_INPUT_0_CHANNEL		1
 #define GPIO_0_OUTPUT_0_CHANNEL		2
 
+// pwm_detector prescale select on GPIO_0_OUTPUT_0_CHANNEL bits [2:0]
+#define HWDET_PRESCALE_SHIFT		0
+#define HWDET_PRESCALE_MAX			7
+#ifndef HWDET_PRESCALE_DEFAULT
+#define HWDET_PRESCALE_DEFAULT		0		// count every clock, as before
+#endif
+
 #define GPIO_R_DEVICE_ID			XPAR_AXI_GPIO_0_DEVICE_ID
 #define GPIO_R_INPUT_HIGH_CHANNEL		1
 #define GPIO_R_INPUT_LOW_CHANNEL		2
@@ -84,12 +130,18 @@
 
 /***************** Macros (Inline Functions) Definitions ********************/
 
+// Current value of the timestamp counter in AXI clock ticks.  Wraps every
+// 2^32 ticks (~43 s at 100MHz) so only use it for differences.
+#define TS_now()	XTmrCtr_GetTimerCounterReg(AXI_TIMER_BASEADDR, TmrCtrTsNumber)
+
 /************************** Variable Definitions ****************************/
 // Microblaze peripheral instances
 PmodOLEDrgb	pmodOLEDrgb_inst;
 PmodENC 	pmodENC_inst;
 XGpio		GPIOInst0;					// GPIO instance
+#if CFG_HW_DETECT
 XGpio		GPIOInstR, GPIOInstG , GPIOInstB;
+#endif
 XIntc 		IntrptCtlrInst;				// Interrupt Controller instance
 XTmrCtr		AXITimerInst;				// PWM timer instance
 
@@ -100,6 +152,9 @@ XTmrCtr		AXITimerInst;				// PWM timer instance
 
 
 volatile u32			gpio_in;			// GPIO input port
+extern const u32		pwm_carrier_us[PWM_CARRIER_SETTINGS];	// switch selectable periods
+extern DutyPublisher	sw_duty;			// duty cycles from FIT_Handler
+extern DutyPublisher	hw_duty;			// duty cycles from pwm_detector
 
 
 /************************** Function Prototypes *****************************/
@@ -107,7 +162,13 @@ void PMDIO_itoa(int32_t value, char *string, int32_t radix);
 void PMDIO_puthex(PmodOLEDrgb* InstancePtr, uint32_t num);
 void PMDIO_putnum(PmodOLEDrgb* InstancePtr, int32_t num, int32_t radix);
 int	 do_init(void);											// initialize system
-void FIT_Handler(void);										// fixed interval timer interrupt handler
+int	 do_init_inputs(void);									// initialize the input path
+void do_init_display(void);									// initialize the PmodOLEDrgb
+void FIT_Handler(void) FIT_HANDLER_ATTR;						// fixed interval timer interrupt handler
 int AXI_Timer_initialize(void);
+void TS_initialize(void);
+void HWDET_SetPrescale(u8 sel);
+int PWM_SetCarrierPeriod(u32 period_us);
+u32 PWM_CarrierPeriod(void);
 
 #endif /* SRC_HW_INTERFACE_H_ */
@@ -0,0 +1,207 @@
+/*
+ * input_events.c
+ */
+
+#include "input_events.h"
+
+// Queue shared between INPUT_Scan() (writes head) and INPUT_Get() (writes tail)
+static InputEvent queue[INPUT_QUEUE_SIZE];
+static volatile u8 queue_head;
+static volatile u8 queue_tail;
+static volatile u32 queue_dropped;
+
+// Owned by the main loop
+static InputStats stats;
+static u32 taken;					// events got but not handled yet
+static u32 taken_first;				// timestamp of the oldest of them
+static u32 taken_ts_sum;			// sum of their timestamps, wraps
+
+// Encoder state, both written in FIT_Handler only
+static u32 enc_state;				// last ENC_getState(), for the push button
+static s8 enc_count;				// quadrature states moved, not yet reported
+
+// Quadrature states moved going from [prev << 2 | cur], state = B << 1 | A.
+// Up runs 2, 3, 1, 0, i.e. A rises while B is high.  Both lines changing
+// at once is a missed state and counts 0.
+static const s8 enc_table[16] = {
+	 0, -1,  1,  0,
+	 1,  0,  0, -1,
+	-1,  0,  0,  1,
+	 0,  1, -1,  0
+};
+
+/****************************************************************************/
+/**
+ * Add an event to the queue.  Called from the ISR only.
+ *****************************************************************************/
+static void queue_event(u32 timestamp, u8 type, u8 code, s16 value) {
+	u8 head = queue_head;
+	u8 next = (head + 1) & (INPUT_QUEUE_SIZE - 1);
+
+	if (next == queue_tail) {
+		queue_dropped++;
+		return;
+	}
+	queue[head].timestamp = timestamp;
+	queue[head].type = type;
+	queue[head].code = code;
+	queue[head].value = value;
+	__asm__ __volatile__("" ::: "memory");
+	queue_head = next;
+}
+
+/****************************************************************************/
+/**
+ * Decode the encoder's quadrature lines
+ *
+ * Called from FIT_Handler on every tick.  The table decode follows every
+ * state change, so contact bounce on one line only moves the count back and
+ * forth, and a fast spin is not lost the way sampling ENC_getRotation()
+ * once a scan loses it.
+ *****************************************************************************/
+void INPUT_SampleEncoder(void) {
+	static u8 ab_prev;
+	static bool ab_valid = false;
+	u32 enc = ENC_getState(&pmodENC_inst);
+	u8 ab = enc & 0x3;
+
+	if (ab_valid)
+		enc_count += enc_table[(ab_prev << 2) | ab];
+	ab_prev = ab;
+	ab_valid = true;
+	enc_state = enc;
+}
+
+/****************************************************************************/
+/**
+ * Scan the inputs and queue an event for every debounced change
+ *
+ * Called from FIT_Handler every INPUT_SCAN_DIVIDER ticks.  Reads the
+ * buttons and switches once per scan, the encoder comes from the last
+ * INPUT_SampleEncoder().
+ *****************************************************************************/
+void INPUT_Scan(void) {
+	static u8 btn_stable, btn_last;
+	static u16 btn_count[INPUT_NUM_BTNS];
+	static u16 sw_stable = 0xFFFF, sw_last, sw_count;
+	static bool sw_valid = false;
+
+	u32 now = TS_now();
+	u32 raw = NX4IO_getBtns();
+	u16 sw = NX4IO_getSwitches();
+	u8 btns = 0;
+	u8 i, mask;
+
+	if (raw & BTNC)
+		btns |= INPUT_BTN_C;
+	if (raw & BTNU)
+		btns |= INPUT_BTN_U;
+	if (raw & BTND)
+		btns |= INPUT_BTN_D;
+	if (raw & BTNL)
+		btns |= INPUT_BTN_L;
+	if (raw & BTNR)
+		btns |= INPUT_BTN_R;
+	if (ENC_buttonPressed(enc_state))
+		btns |= INPUT_BTN_ENC;
+
+	// Buttons: a new level has to be seen for INPUT_DEBOUNCE_SCANS scans in a
+	// row.  Once pressed the same counter times the auto repeat.
+	for (i = 0, mask = 1; i < INPUT_NUM_BTNS; i++, mask <<= 1) {
+		if ((btns ^ btn_last) & mask) {
+			btn_count[i] = 0;
+		} else if ((btns ^ btn_stable) & mask) {
+			if (++btn_count[i] >= INPUT_DEBOUNCE_SCANS) {
+				btn_stable ^= mask;
+				btn_count[i] = 0;
+				queue_event(now,
+						(btns & mask) ? EVT_BTN_PRESS : EVT_BTN_RELEASE, mask,
+						0);
+			}
+		} else if (btn_stable & mask) {
+			if (++btn_count[i] >= INPUT_REPEAT_DELAY_SCANS) {
+				btn_count[i] = INPUT_REPEAT_DELAY_SCANS - INPUT_REPEAT_SCANS;
+				queue_event(now, EVT_BTN_REPEAT, mask, 0);
+			}
+		}
+	}
+	btn_last = btns;
+
+	// Switches: same debounce on the whole word.  The first stable reading
+	// is always reported so the main loop learns the start-up positions.
+	if (sw != sw_last) {
+		sw_count = 0;
+	} else if (!sw_valid || sw != sw_stable) {
+		if (++sw_count >= INPUT_DEBOUNCE_SCANS) {
+			sw_stable = sw;
+			sw_valid = true;
+			queue_event(now, EVT_SW_CHANGE, 0, (s16) sw);
+		}
+	}
+	sw_last = sw;
+
+	// Encoder: one event per whole detent turned since the last scan
+	while (enc_count >= INPUT_ENC_STATES_PER_DETENT) {
+		enc_count -= INPUT_ENC_STATES_PER_DETENT;
+		queue_event(now, EVT_ENC_STEP, 0, 1);
+	}
+	while (enc_count <= -INPUT_ENC_STATES_PER_DETENT) {
+		enc_count += INPUT_ENC_STATES_PER_DETENT;
+		queue_event(now, EVT_ENC_STEP, 0, -1);
+	}
+}
+
+/****************************************************************************/
+/**
+ * Get the next input event
+ *
+ * @param	ev receives the oldest queued event
+ *
+ * @return	true if an event was returned, false if the queue is empty
+ *****************************************************************************/
+bool INPUT_Get(InputEvent *ev) {
+	u8 tail = queue_tail;
+
+	if (tail == queue_head)
+		return false;
+	*ev = queue[tail];
+	__asm__ __volatile__("" ::: "memory");
+	queue_tail = (tail + 1) & (INPUT_QUEUE_SIZE - 1);
+	stats.events++;
+	if (taken++ == 0)
+		taken_first = ev->timestamp;
+	taken_ts_sum += ev->timestamp;
+	return true;
+}
+
+/****************************************************************************/
+/**
+ * Record that the main loop has finished reacting to the events got since
+ * the last call, i.e. the LEDs and the display have been updated
+ *
+ * The time from the scan that saw each change until now is its input to
+ * reaction latency.  The sum of those is count * now - the timestamps,
+ * exact in 32 bits as long as it is under 2^32 ticks.
+ *****************************************************************************/
+void INPUT_Handled(void) {
+	u32 now, latency;
+
+	if (taken == 0)
+		return;
+	now = TS_now();
+	latency = now - taken_first;
+	if (latency > stats.latency_max)
+		stats.latency_max = latency;
+	stats.latency_sum += now * taken - taken_ts_sum;
+	taken = 0;
+	taken_ts_sum = 0;
+}
+
+/****************************************************************************/
+/**
+ * Get the queue statistics
+ *****************************************************************************/
+void INPUT_GetStats(InputStats *s) {
+	*s = stats;
+	s->dropped = queue_dropped;
+}
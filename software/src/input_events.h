@@ -0,0 +1,71 @@
+/*
+ * input_events.h
+ *
+ *  Interrupt fed input event queue.
+ *  INPUT_Scan() runs from FIT_Handler once a millisecond, debounces the
+ *  push buttons, slide switches and rotary encoder and queues a timestamped
+ *  event for every change.  The main loop drains the queue with INPUT_Get()
+ *  and calls INPUT_Handled() once the LEDs and display show the result.
+ *  The encoder's A and B lines are decoded by INPUT_SampleEncoder() on every
+ *  FIT tick instead, so no quadrature state is missed however fast the knob
+ *  turns; INPUT_Scan() turns the whole detents into events.
+ *  The queue is single producer (the ISR) / single consumer (main) and needs
+ *  no locking.
+ */
+
+#ifndef SRC_INPUT_EVENTS_H_
+#define SRC_INPUT_EVENTS_H_
+
+#include "hw_interface.h"
+
+/************************** Constant Definitions ****************************/
+
+#define INPUT_QUEUE_SIZE			32					// events, must be a power of 2
+#define INPUT_SCAN_DIVIDER			FIT_COUNT_1MSEC		// FIT ticks between scans (1 ms)
+#define INPUT_DEBOUNCE_SCANS		20					// input must be stable this long
+#define INPUT_REPEAT_DELAY_SCANS	400					// hold time before auto repeat
+#define INPUT_REPEAT_SCANS			90					// auto repeat period
+#define INPUT_ENC_STATES_PER_DETENT	4					// one quadrature cycle per click
+
+// Button codes used in the events.  The encoder push button is treated as
+// a sixth button.
+#define INPUT_BTN_C					0x01
+#define INPUT_BTN_U					0x02
+#define INPUT_BTN_D					0x04
+#define INPUT_BTN_L					0x08
+#define INPUT_BTN_R					0x10
+#define INPUT_BTN_ENC				0x20
+#define INPUT_NUM_BTNS				6
+
+/**************************** Type Definitions ******************************/
+
+typedef enum {
+	EVT_BTN_PRESS,			// code = INPUT_BTN_x
+	EVT_BTN_RELEASE,		// code = INPUT_BTN_x
+	EVT_BTN_REPEAT,			// code = INPUT_BTN_x, button still held
+	EVT_SW_CHANGE,			// value = new switch word (read it as a u16)
+	EVT_ENC_STEP			// value = +1 or -1 per detent
+} InputEventType;
+
+typedef struct {
+	u32		timestamp;		// TS_now() at the scan that saw the change
+	u8		type;			// InputEventType
+	u8		code;
+	s16		value;
+} InputEvent;
+
+typedef struct {
+	u32		events;			// events handed to the main loop
+	u32		dropped;		// events lost because the queue was full
+	u32		latency_max;	// worst input to reaction time, TS ticks
+	u64		latency_sum;	// for the average, TS ticks
+} InputStats;
+
+/************************** Function Prototypes *****************************/
+void INPUT_SampleEncoder(void);
+void INPUT_Scan(void);
+bool INPUT_Get(InputEvent *ev);
+void INPUT_Handled(void);
+void INPUT_GetStats(InputStats *stats);
+
+#endif /* SRC_INPUT_EVENTS_H_ */
@@ -0,0 +1,102 @@
+/*
+ * isr_bench.c
+ */
+
+#include "isr_bench.h"
+#include "xintc_l.h"
+#include "telemetry.h"
+#include "uart_command.h"
+
+#ifdef ISR_BENCHMARK
+
+#define INTC_BASEADDR		XPAR_INTC_0_BASEADDR
+#define FIT_INTR_MASK		(1UL << FIT_INTERRUPT_ID)
+
+CostStats fit_entry;
+u32 fit_expected;
+bool fit_phase_valid;
+
+static u32 poll_ticks;				// one pass of the pending bit poll
+static u32 spin_off, spin_on;		// spin loop passes without and with the FIT
+
+/****************************************************************************/
+/**
+ * Count loop passes for ISR_SPIN_TICKS
+ *****************************************************************************/
+static u32 spin(void) {
+	u32 start = TS_now();
+	u32 passes = 0;
+
+	while (TS_now() - start < ISR_SPIN_TICKS)
+		passes++;
+	return passes;
+}
+
+/****************************************************************************/
+/**
+ * Measure the FIT phase and the total cost per interrupt
+ *
+ * Call from the main loop with interrupts enabled.  Takes about
+ * 2 * ISR_SPIN_TICKS.
+ *****************************************************************************/
+void ISR_Calibrate(void) {
+	u32 t0, t1;
+
+	microblaze_disable_interrupts();
+
+	spin_off = spin();
+
+	// Wait for the next FIT assertion.  The time is good to one poll pass.
+	XIntc_AckIntr(INTC_BASEADDR, FIT_INTR_MASK);
+	t0 = TS_now();
+	XIntc_GetIntrStatus(INTC_BASEADDR);
+	t1 = TS_now();
+	poll_ticks = t1 - t0;
+	while (!(XIntc_GetIntrStatus(INTC_BASEADDR) & FIT_INTR_MASK))
+		;
+	fit_expected = TS_now();
+	XIntc_AckIntr(INTC_BASEADDR, FIT_INTR_MASK);
+	fit_expected += FIT_PERIOD_TICKS;
+	fit_phase_valid = true;
+	fit_entry.calls = 0;
+	fit_entry.cycles = 0;
+	fit_entry.max = 0;
+
+	microblaze_enable_interrupts();
+
+	spin_on = spin();
+}
+
+/****************************************************************************/
+/**
+ * Print the FIT interrupt costs, in AXI clock cycles
+ * Nothing is printed while telemetry or a host is using the UART
+ *****************************************************************************/
+void ISR_Report(void) {
+	u32 total;
+
+	// Text would land in the middle of the telemetry or ACK frames
+	if (TLM_Enabled() || CMD_HostActive())
+		return;
+
+#ifdef FIT_FAST_INTERRUPT
+	xil_printf("FIT interrupt: fast\n");
+#else
+	xil_printf("FIT interrupt: standard XIntc dispatch\n");
+#endif
+	if (fit_entry.calls)
+		xil_printf("  entry latency avg %d, max %d cycles (+/- %d)\n",
+				(u32) (fit_entry.cycles / fit_entry.calls), fit_entry.max,
+				poll_ticks);
+	if (fit_cost.calls)
+		xil_printf("  handler body avg %d, max %d cycles\n",
+				(u32) (fit_cost.cycles / fit_cost.calls), fit_cost.max);
+	if (spin_off > spin_on) {
+		// passes lost / passes per tick = ticks lost, over the interrupts seen
+		total = (u32) ((u64) (spin_off - spin_on) * FIT_PERIOD_TICKS / spin_off);
+		xil_printf("  total per interrupt %d cycles, %d%% of the CPU\n", total,
+				total * 100 / FIT_PERIOD_TICKS);
+	}
+}
+
+#endif /* ISR_BENCHMARK */
@@ -0,0 +1,58 @@
+/*
+ * isr_bench.h
+ *
+ *  FIT interrupt cost measurement, built with -DISR_BENCHMARK.
+ *
+ *  Entry latency: ISR_Calibrate() polls the interrupt controller with the
+ *  CPU interrupts off to find when the FIT asserts.  From then on every
+ *  assertion time is known (the FIT is exactly periodic), so FIT_Handler
+ *  gets its own entry latency from the timestamp it already takes.
+ *
+ *  Total cost: ISR_Calibrate() also counts spin loop passes for a fixed
+ *  time with interrupts off and on.  The passes lost, scaled by the number
+ *  of interrupts, give the cycles each interrupt costs including the
+ *  dispatch, register save/restore and return that the handler cannot time
+ *  itself.
+ *
+ *  Run it once with and once without -DFIT_FAST_INTERRUPT to compare the
+ *  standard XIntc dispatch with the fast interrupt path.
+ */
+
+#ifndef SRC_ISR_BENCH_H_
+#define SRC_ISR_BENCH_H_
+
+#include "hw_interface.h"
+#include "ab_compare.h"
+
+/************************** Constant Definitions ****************************/
+
+#define FIT_PERIOD_TICKS		(AXI_CLOCK_FREQ_HZ / FIT_CLOCK_FREQ_HZ)	// TS ticks per FIT interrupt
+#define ISR_SPIN_TICKS			(AXI_CLOCK_FREQ_HZ / 20)				// 50 ms per spin measurement
+
+/************************** Variable Definitions ****************************/
+extern CostStats fit_entry;				// FIT assertion to FIT_Handler's first timestamp
+extern u32 fit_expected;				// next FIT assertion, TS ticks
+extern bool fit_phase_valid;			// fit_expected has been calibrated
+
+/***************** Macros (Inline Functions) Definitions ********************/
+
+// Called by FIT_Handler with the timestamp it takes on entry
+static inline void ISR_EntrySample(u32 start) {
+	u32 latency;
+
+	if (!fit_phase_valid)
+		return;
+	latency = start - fit_expected;
+	while (latency >= FIT_PERIOD_TICKS) {		// at most once unless one was missed
+		fit_expected += FIT_PERIOD_TICKS;
+		latency -= FIT_PERIOD_TICKS;
+	}
+	fit_expected += FIT_PERIOD_TICKS;
+	COST_Add(&fit_entry, latency);
+}
+
+/************************** Function Prototypes *****************************/
+void ISR_Calibrate(void);
+void ISR_Report(void);
+
+#endif /* SRC_ISR_BENCH_H_ */
@@ -0,0 +1,279 @@
+/*
+ * latency_bench.c
+ */
+
+#include <string.h>
+#include "latency_bench.h"
+#include "telemetry.h"
+#include "uart_command.h"
+
+#if CFG_COMPARE
+
+// Full off, full on, each primary and a few mid levels
+const BenchStep bench_default_steps[] = {
+	{   0,   0,   0, 500 },
+	{ 255, 255, 255, 500 },
+	{ 255,   0,   0, 500 },
+	{   0, 255,   0, 500 },
+	{   0,   0, 255, 500 },
+	{  64, 128, 192, 500 },
+	{ 192,  64, 128, 500 },
+	{ 128, 192,  64, 500 },
+	{  16,  16,  16, 500 },
+	{ 240, 240, 240, 500 },
+};
+const u8 bench_default_nsteps = sizeof(bench_default_steps)
+		/ sizeof(bench_default_steps[0]);
+
+static struct {
+	const BenchStep	*steps;
+	u8				nsteps;
+	u8				repeats;
+	u8				step;
+	u8				pass;
+	bool			running;
+	bool			commanded;		// BENCH_Commanded() seen for this step
+	u32				step_start;
+	u32				bin_us;			// histogram bin width
+	u32				min_hold;		// ticks, BENCH_HOLD_PERIODS
+	u8				before[2][NUM_DUTY_CHANNELS];	// output at the command
+	SettleTracker	settle[2];
+	LatencyStats	stats[2];
+	LatencyStats	sat_stats[2];	// steps to full off or on on every channel
+} bench;
+
+/****************************************************************************/
+/**
+ * Start a benchmark run.  Clears the results of the previous run.
+ *
+ * @param	steps is the sequence of targets
+ * @param	nsteps is the number of entries in steps
+ * @param	repeats is how many times to run through the sequence
+ *****************************************************************************/
+void BENCH_Start(const BenchStep *steps, u8 nsteps, u8 repeats) {
+	memset(&bench, 0, sizeof(bench));
+	bench.steps = steps;
+	bench.nsteps = nsteps;
+	bench.repeats = repeats;
+	bench.running = (nsteps != 0 && repeats != 0);
+	bench.bin_us = PWM_CarrierPeriod() * BENCH_HIST_PERIODS / BENCH_HIST_BINS;
+	if (bench.bin_us == 0)
+		bench.bin_us = 1;
+	// Up to 3 periods to settle and 3 more to see it stay put (see
+	// SETTLE_Update()), which is more than 500 ms at the long carriers
+	bench.min_hold = PWM_CarrierPeriod() * BENCH_HOLD_PERIODS * TS_TICKS_PER_USEC;
+
+	// Peak FIT_Handler cost for this run.  Racing the handler can at worst
+	// lose the sample it is adding.
+	fit_cost.max = 0;
+}
+
+/****************************************************************************/
+/**
+ * @return	true while a run is in progress
+ *****************************************************************************/
+bool BENCH_Running(void) {
+	return bench.running;
+}
+
+static void record(LatencyStats *st, u32 ticks) {
+	u32 us = ticks / TS_TICKS_PER_USEC;
+	u32 bin = us / bench.bin_us;
+
+	if (bin > BENCH_HIST_BINS)
+		bin = BENCH_HIST_BINS;
+	st->hist[bin]++;
+	if (st->count == 0 || us < st->min)
+		st->min = us;
+	if (us > st->max)
+		st->max = us;
+	st->sum += us;
+	st->count++;
+}
+
+// Every channel goes fully off or on, so the detectors have to call it
+// from the saturated state rather than a measured period
+static bool saturating(const BenchStep *st) {
+	return (st->r == 0 || st->r == 255) && (st->g == 0 || st->g == 255)
+			&& (st->b == 0 || st->b == 255);
+}
+
+/****************************************************************************/
+/**
+ * Advance the benchmark
+ *
+ * Call once per main loop pass while BENCH_Running().
+ *
+ * @param	now is TS_now()
+ * @param	sw_duty is the latest software detector output
+ * @param	hw_duty is the latest hardware detector output
+ * @param	cmd receives the next R, G, B to command
+ *
+ * @return	true if cmd holds a new command.  The caller writes it to the
+ * 			LEDs and then calls BENCH_Commanded().
+ *****************************************************************************/
+bool BENCH_Update(u32 now, const u8 *sw_duty, const u8 *hw_duty, u8 *cmd) {
+	const u8 *duty[2] = { sw_duty, hw_duty };
+	const BenchStep *st;
+	u32 ticks, hold;
+	u8 det;
+
+	if (!bench.running)
+		return false;
+
+	if (bench.commanded) {
+		st = &bench.steps[bench.step];
+		for (det = BENCH_SW; det <= BENCH_HW; det++)
+			if (SETTLE_Update(&bench.settle[det], now, duty[det], &ticks)) {
+				// Nothing to time, it would go down as 0 us
+				if (memcmp(bench.settle[det].last, bench.before[det],
+						NUM_DUTY_CHANNELS) == 0) {
+					bench.stats[det].unchanged++;
+					continue;
+				}
+				record(&bench.stats[det], ticks);
+				if (saturating(st))
+					record(&bench.sat_stats[det], ticks);
+			}
+
+		hold = (u32) st->hold_ms * 1000 * TS_TICKS_PER_USEC;
+		if (hold < bench.min_hold)
+			hold = bench.min_hold;
+		if (now - bench.step_start < hold)
+			return false;
+
+		for (det = BENCH_SW; det <= BENCH_HW; det++)
+			if (bench.settle[det].pending)
+				bench.stats[det].timeouts++;
+
+		if (++bench.step >= bench.nsteps) {
+			bench.step = 0;
+			if (++bench.pass >= bench.repeats) {
+				bench.running = false;
+				return false;
+			}
+		}
+	}
+
+	st = &bench.steps[bench.step];
+	cmd[0] = st->r;
+	cmd[1] = st->g;
+	cmd[2] = st->b;
+	bench.commanded = false;
+	return true;
+}
+
+/****************************************************************************/
+/**
+ * Timestamp the command returned by BENCH_Update()
+ *
+ * @param	now is TS_now() right after the command was written to the LEDs
+ * @param	sw_duty is the software detector output at that time
+ * @param	hw_duty is the hardware detector output at that time
+ *****************************************************************************/
+void BENCH_Commanded(u32 now, const u8 *sw_duty, const u8 *hw_duty) {
+	SETTLE_Start(&bench.settle[BENCH_SW], now, sw_duty);
+	SETTLE_Start(&bench.settle[BENCH_HW], now, hw_duty);
+	memcpy(bench.before[BENCH_SW], sw_duty, NUM_DUTY_CHANNELS);
+	memcpy(bench.before[BENCH_HW], hw_duty, NUM_DUTY_CHANNELS);
+	bench.step_start = now;
+	bench.commanded = true;
+}
+
+/****************************************************************************/
+/**
+ * Get the results of the last run
+ *
+ * @param	det is BENCH_SW or BENCH_HW
+ * @param	all receives the results over every step
+ * @param	sat receives the results over the steps to full off or on
+ *****************************************************************************/
+void BENCH_GetStats(u8 det, LatencyStats *all, LatencyStats *sat) {
+	*all = bench.stats[det];
+	*sat = bench.sat_stats[det];
+}
+
+/****************************************************************************/
+/**
+ * Get the width of the histogram bins of the last run, in microseconds
+ *****************************************************************************/
+u32 BENCH_BinWidth(void) {
+	return bench.bin_us;
+}
+
+/****************************************************************************/
+/**
+ * Send one detector's results as a FRAME_TYPE_LATENCY frame
+ *
+ * Waits for room in the transmit ring if it is full, as the printed report
+ * waits for the UART.
+ *****************************************************************************/
+static void send_latency(u8 source, u8 det, const LatencyStats *st) {
+	LatencyRecord rec;
+	u8 payload[LATENCY_PAYLOAD_SIZE];
+
+	rec.source = source;
+	rec.detector = det;
+	rec.count = st->count;
+	rec.unchanged = st->unchanged;
+	rec.timeouts = st->timeouts;
+	rec.min_us = st->min;
+	rec.avg_us = st->count ? (u32) (st->sum / st->count) : 0;
+	rec.max_us = st->max;
+	FRAME_PackLatency(&rec, payload);
+	while (!TLM_SendFrame(FRAME_TYPE_LATENCY, payload, LATENCY_PAYLOAD_SIZE))
+		TLM_Poll();
+}
+
+/****************************************************************************/
+/**
+ * Print the latency summary and histograms on the UART
+ * While telemetry or a host is using the UART the summaries are sent as
+ * FRAME_TYPE_LATENCY frames instead, without the histograms.
+ *****************************************************************************/
+void BENCH_Report(void) {
+	static const char *name[2] = { "SW", "HW" };
+	const LatencyStats *st;
+	u32 bin, bar, peak;
+	u8 det;
+
+	// Text would land in the middle of the telemetry or ACK frames
+	if (TLM_Enabled() || CMD_HostActive()) {
+		for (det = BENCH_SW; det <= BENCH_HW; det++) {
+			send_latency(LATENCY_SOURCE_BENCH, det, &bench.stats[det]);
+			send_latency(LATENCY_SOURCE_BENCH_SAT, det, &bench.sat_stats[det]);
+		}
+		return;
+	}
+
+	xil_printf("Latency benchmark: %d steps x %d passes, carrier %d us\n",
+			bench.nsteps, bench.repeats, PWM_CarrierPeriod());
+	xil_printf("FIT_Handler: peak %d cycles\n", fit_cost.max);
+	for (det = BENCH_SW; det <= BENCH_HW; det++) {
+		st = &bench.stats[det];
+		xil_printf("%s: %d settled, %d unchanged, %d timed out, min %d us, avg %d us, max %d us\n",
+				name[det], st->count, st->unchanged, st->timeouts, st->min,
+				st->count ? (u32) (st->sum / st->count) : 0, st->max);
+		st = &bench.sat_stats[det];
+		xil_printf("  to full off/on: %d settled, min %d us, avg %d us, max %d us\n",
+				st->count, st->min,
+				st->count ? (u32) (st->sum / st->count) : 0, st->max);
+		st = &bench.stats[det];
+
+		peak = 1;
+		for (bin = 0; bin <= BENCH_HIST_BINS; bin++)
+			if (st->hist[bin] > peak)
+				peak = st->hist[bin];
+		for (bin = 0; bin <= BENCH_HIST_BINS; bin++) {
+			if (bin < BENCH_HIST_BINS)
+				xil_printf("  %6d us |", (bin + 1) * bench.bin_us);
+			else
+				xil_printf("  longer    |");
+			for (bar = 0; bar < st->hist[bin] * 40 / peak; bar++)
+				xil_printf("#");
+			xil_printf(" %d\n", st->hist[bin]);
+		}
+	}
+}
+
+#endif /* CFG_COMPARE */
@@ -0,0 +1,74 @@
+/*
+ * latency_bench.h
+ *
+ *  End-to-end color change latency benchmark.
+ *  Steps the RGB LEDs through a sequence of duty targets and, for every
+ *  step, measures the time from the command to the first value of each
+ *  detector that then stays stable (see SettleTracker).  Results are kept
+ *  in a histogram per detector and printed on the UART when the run ends,
+ *  or sent as FRAME_TYPE_LATENCY frames if the UART is carrying frames.
+ *  A step a detector already read the same before the command, e.g. the
+ *  first one, has nothing to time and is only counted.  The histogram
+ *  covers BENCH_HIST_PERIODS carrier periods, whatever the carrier.
+ *
+ *  The benchmark only sees timestamps and duty cycles; the caller writes
+ *  the commands to the LEDs and supplies the detector snapshots.
+ */
+
+#ifndef SRC_LATENCY_BENCH_H_
+#define SRC_LATENCY_BENCH_H_
+
+#include "ab_compare.h"
+
+/************************** Constant Definitions ****************************/
+
+#define BENCH_HIST_BINS			16			// plus one overflow bin
+#define BENCH_HIST_PERIODS		4			// carrier periods the bins cover
+#define BENCH_REPEATS			4			// times through the sequence
+#define BENCH_HOLD_PERIODS		7			// shortest step in carrier periods
+
+#define BENCH_SW				0			// detector numbers for BENCH_GetStats()
+#define BENCH_HW				1
+
+/**************************** Type Definitions ******************************/
+
+typedef struct {
+	u8		r, g, b;		// commanded duty cycles
+	u16		hold_ms;		// time before the next step, must cover the
+							// settling time plus the settle window.  Held
+							// for BENCH_HOLD_PERIODS if that is longer.
+} BenchStep;
+
+typedef struct {
+	u32		hist[BENCH_HIST_BINS + 1];	// settling times, BENCH_BinWidth() us per bin
+	u32		count;			// steps timed
+	u64		sum;			// microseconds
+	u32		min;
+	u32		max;
+	u32		timeouts;		// steps that ended before the detector settled
+	u32		unchanged;		// steps that read the same before and after
+} LatencyStats;
+
+#if CFG_COMPARE
+
+/************************** Variable Definitions ****************************/
+extern const BenchStep bench_default_steps[];
+extern const u8 bench_default_nsteps;
+
+/************************** Function Prototypes *****************************/
+void BENCH_Start(const BenchStep *steps, u8 nsteps, u8 repeats);
+bool BENCH_Running(void);
+bool BENCH_Update(u32 now, const u8 *sw_duty, const u8 *hw_duty, u8 *cmd);
+void BENCH_Commanded(u32 now, const u8 *sw_duty, const u8 *hw_duty);
+void BENCH_GetStats(u8 det, LatencyStats *all, LatencyStats *sat);
+u32 BENCH_BinWidth(void);
+void BENCH_Report(void);
+
+#else
+
+// Not in this build, see build_config.h
+static inline bool BENCH_Running(void) { return false; }
+
+#endif /* CFG_COMPARE */
+
+#endif /* SRC_LATENCY_BENCH_H_ */
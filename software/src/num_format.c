@@ -0,0 +1,196 @@
+/*
+ * num_format.c
+ */
+
+#include "num_format.h"
+
+// "00" "01" ... "99" - two decimal digits per table entry
+static const char digit_pairs[200] = {
+	'0','0','0','1','0','2','0','3','0','4','0','5','0','6','0','7','0','8','0','9',
+	'1','0','1','1','1','2','1','3','1','4','1','5','1','6','1','7','1','8','1','9',
+	'2','0','2','1','2','2','2','3','2','4','2','5','2','6','2','7','2','8','2','9',
+	'3','0','3','1','3','2','3','3','3','4','3','5','3','6','3','7','3','8','3','9',
+	'4','0','4','1','4','2','4','3','4','4','4','5','4','6','4','7','4','8','4','9',
+	'5','0','5','1','5','2','5','3','5','4','5','5','5','6','5','7','5','8','5','9',
+	'6','0','6','1','6','2','6','3','6','4','6','5','6','6','6','7','6','8','6','9',
+	'7','0','7','1','7','2','7','3','7','4','7','5','7','6','7','7','7','8','7','9',
+	'8','0','8','1','8','2','8','3','8','4','8','5','8','6','8','7','8','8','8','9',
+	'9','0','9','1','9','2','9','3','9','4','9','5','9','6','9','7','9','8','9','9'
+};
+
+static const uint32_t pow10[10] = {
+	1UL, 10UL, 100UL, 1000UL, 10000UL,
+	100000UL, 1000000UL, 10000000UL, 100000000UL, 1000000000UL
+};
+
+static const char hex_digits[16] = {
+	'0','1','2','3','4','5','6','7','8','9','a','b','c','d','e','f'
+};
+
+/****************************************************************************/
+/**
+ * Divide by 100 using a reciprocal multiply
+ *
+ * 0x51EB851F / 2^37 is 1/100 rounded up; the rounding error is small enough
+ * that the quotient is exact for every 32-bit input.  On a MicroBlaze with
+ * C_USE_HW_MUL = 2 this compiles to a single mulhu.
+ *****************************************************************************/
+static inline uint32_t div100(uint32_t value) {
+	return (uint32_t) (((uint64_t) value * 0x51EB851FULL) >> 37);
+}
+
+/****************************************************************************/
+/**
+ * Count the decimal digits in value (1 for a value of 0)
+ *****************************************************************************/
+static inline uint8_t count_digits(uint32_t value) {
+	uint8_t n = 1;
+
+	while (n < 10 && value >= pow10[n])
+		n++;
+	return n;
+}
+
+/****************************************************************************/
+/**
+ * Write the decimal digits of value so that the last one lands just before end
+ *****************************************************************************/
+static inline void put_digits(uint32_t value, char *end) {
+	uint32_t q;
+	uint32_t r;
+
+	while (value >= 100) {
+		q = div100(value);
+		r = (value - q * 100) << 1;
+		*--end = digit_pairs[r + 1];
+		*--end = digit_pairs[r];
+		value = q;
+	}
+	if (value >= 10) {
+		r = value << 1;
+		*--end = digit_pairs[r + 1];
+		*--end = digit_pairs[r];
+	} else {
+		*--end = (char) ('0' + value);
+	}
+}
+
+/****************************************************************************/
+/**
+ * Converts an unsigned integer to a decimal string
+ *
+ * @param	value is the integer to convert
+ * @param	*string is the output buffer, at least FMT_MAX_CHARS long
+ *
+ * @return	the number of characters written, not counting the terminating null
+ *****************************************************************************/
+uint8_t FMT_u32toa(uint32_t value, char *string) {
+	uint8_t n = count_digits(value);
+
+	put_digits(value, string + n);
+	string[n] = 0;
+	return n;
+}
+
+/****************************************************************************/
+/**
+ * Converts a signed integer to a decimal string
+ *
+ * @param	value is the integer to convert
+ * @param	*string is the output buffer, at least FMT_MAX_CHARS long
+ *
+ * @return	the number of characters written, not counting the terminating null
+ *****************************************************************************/
+uint8_t FMT_i32toa(int32_t value, char *string) {
+	if (value < 0) {
+		*string = '-';
+		return FMT_u32toa(-(uint32_t) value, string + 1) + 1;
+	}
+	return FMT_u32toa((uint32_t) value, string);
+}
+
+/****************************************************************************/
+/**
+ * Converts an unsigned integer to a lower case hex string
+ *
+ * @param	value is the integer to convert
+ * @param	*string is the output buffer, at least width + 1 (or 9) long
+ * @param	width is the number of digits to write, zero padded.  0 writes
+ * 			only as many digits as needed.  Values wider than width are
+ * 			written in full.
+ *
+ * @return	the number of characters written, not counting the terminating null
+ *****************************************************************************/
+uint8_t FMT_u32tohex(uint32_t value, char *string, uint8_t width) {
+	uint8_t n = 1;
+	uint8_t i;
+
+	while (n < 8 && (value >> (n * 4)) != 0)
+		n++;
+	if (width > n)
+		n = width;
+
+	for (i = n; i > 0; i--) {
+		string[i - 1] = hex_digits[value & 0xF];
+		value >>= 4;
+	}
+	string[n] = 0;
+	return n;
+}
+
+/****************************************************************************/
+/**
+ * Converts a signed integer to a right aligned, fixed width decimal string
+ *
+ * Lets callers overwrite a field on the display in one write instead of
+ * blanking it first.
+ *
+ * @param	value is the integer to convert
+ * @param	*string is the output buffer, at least width + 1 (or FMT_MAX_CHARS) long
+ * @param	width is the field width.  Values wider than width are written in full.
+ * @param	pad is the fill character, normally ' ' or '0'.  With '0' the sign
+ * 			of a negative number goes in front of the padding.
+ *
+ * @return	the number of characters written, not counting the terminating null
+ *****************************************************************************/
+uint8_t FMT_i32toa_fixed(int32_t value, char *string, uint8_t width, char pad) {
+	uint32_t v = (value < 0) ? -(uint32_t) value : (uint32_t) value;
+	uint8_t ndigits = count_digits(v);
+	uint8_t len = ndigits + (value < 0);
+	uint8_t i = 0;
+
+	if (width < len)
+		width = len;
+
+	if (value < 0 && pad == '0')
+		string[i++] = '-';
+	while (i < width - len + (value < 0 && pad == '0'))
+		string[i++] = pad;
+	if (value < 0 && pad != '0')
+		string[i++] = '-';
+
+	put_digits(v, string + width);
+	string[width] = 0;
+	return width;
+}
+
+/****************************************************************************/
+/**
+ * Converts an integer to ASCII using the fast path for the radix
+ *
+ * Radix 10 is signed, radix 16 prints the two's complement bit pattern
+ * (the same as PMDIO_itoa() does).
+ *
+ * @return	the number of characters written, or 0 if the radix has no fast
+ * 			path and the caller has to fall back to PMDIO_itoa()
+ *****************************************************************************/
+uint8_t FMT_itoa(int32_t value, char *string, int32_t radix) {
+	switch (radix) {
+	case 10:
+		return FMT_i32toa(value, string);
+	case 16:
+		return FMT_u32tohex((uint32_t) value, string, 0);
+	default:
+		return 0;
+	}
+}
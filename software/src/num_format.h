@@ -0,0 +1,24 @@
+/*
+ * num_format.h
+ *
+ *  Fast integer to ASCII conversion for the display paths.
+ *  Base 10 is converted two digits at a time from a digit-pair table and
+ *  divides by 100 are done with a reciprocal multiply, so no run-time
+ *  divide is ever issued.  Base 16 has its own shift/mask path.
+ */
+
+#ifndef SRC_NUM_FORMAT_H_
+#define SRC_NUM_FORMAT_H_
+
+#include <stdint.h>
+
+// Largest string any FMT_ function writes, including sign and terminating null
+#define FMT_MAX_CHARS		12
+
+uint8_t FMT_u32toa(uint32_t value, char *string);
+uint8_t FMT_i32toa(int32_t value, char *string);
+uint8_t FMT_u32tohex(uint32_t value, char *string, uint8_t width);
+uint8_t FMT_i32toa_fixed(int32_t value, char *string, uint8_t width, char pad);
+uint8_t FMT_itoa(int32_t value, char *string, int32_t radix);
+
+#endif /* SRC_NUM_FORMAT_H_ */
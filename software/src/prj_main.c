@@ -6,14 +6,31 @@
  */
 
 #include "functional_interface.h"
+/**
+ * Duty cycles published by the software (FIT_Handler) and hardware (main loop)
+ * detection paths.  Read with DUTY_Read() to get a coherent snapshot.
+ */
+DutyPublisher sw_duty, hw_duty;
+
+/**
+ * Cycles spent in each detection path, see ab_compare.h
+ */
+CostStats fit_cost, hw_cost;
+
+/**
+ * Main loop period, for the build profile report
+ */
+CostStats loop_cost;
+
+#if CFG_SW_DETECT
 /**
  * Volatile variables for using in interrupt handler for software pwm detection
  */
-volatile u8 duty_cycle[3] = { 1, 2, 3 };
 volatile bool signal[3];
 volatile bool old_signal[3];
 volatile u32 high_level[3];
 volatile u32 low_level[3];
+#endif
 
 /**
  * ************************ MAIN PROGRAM for the Project***********************************
@@ -22,49 +39,258 @@ int main(void) {
 	init_platform();
 
 	uint32_t sts;
-	u16 hue;
-	u8 sat, val;
-	bool detect;
+	ColorControl ctl = { 0 };
+	InputStats input_stats;
+	DutySnapshot sw_snap = { 0 }, hw_snap = { 0 };
+	DutySnapshot *duty;
+	u32 torn_reads = 0;
+	u32 now, last_pass;
+	bool telemetry = false;
+	bool ab_mode = false;
+	u8 prescale = HWDET_PRESCALE_DEFAULT;
+	u8 carrier = 0;
+	bool chart = false;
+	u8 chart_rate = 0;
+	bool hw_color = false;
+#if CFG_COMPARE
+	u8 bench_cmd[3];
+#endif
+	WsStats ws_stats;
+	ViewStats view_stats;
+	CommandStats cmd_stats;
+	ChartStats chart_stats;
+	u32 start_ts;
+	bool changed = false;
 
+	// LEDs first, then the inputs, the display is brought up from the loop
+	BOOT_Start();
 	sts = do_init();
 	if (XST_SUCCESS != sts) {
 		exit(1);
 	}
+	BOOT_Restore(&ctl.hue, &ctl.sat, &ctl.val);
+	// The same conversion as every later color change, written even if
+	// the restored color is black
+	UpdateRGBled(ctl.hue, ctl.sat, ctl.val, 1);
+	BOOT_Mark(BOOT_FIRST_COLOR);
+
+	sts = do_init_inputs();
+	if (XST_SUCCESS != sts) {
+		exit(1);
+	}
+
+#ifdef FMT_BENCHMARK
+	RunFormatBenchmark();
+#endif
+
+	sts = CMD_Init();
+	if (XST_SUCCESS != sts) {
+		exit(1);
+	}
+
+	if (WS_Init(WS2812_NUM_PIXELS) != XST_SUCCESS)
+		xil_printf("No WS2812 strip engine in this design\n");
+	if (HSVPWM_Init() != XST_SUCCESS)
+		xil_printf("No HSV color register in this design\n");
 
 	xil_printf("Starting Main Application\n");
-	while (IsExit()) {
-		hue = GetHue();
-		sat = GetSat();
-		val = GetVal();
-		UpdateRGBled(hue, sat, val, 0);
-		UpdateDispaly(hue, sat, val);
-		detect = GetDetectType(); // 0 - Sw Detect; 1- HW Detect
-		if (detect) {
-			//Hw Detect
-			microblaze_disable_interrupts();
-			duty_cycle[0] = calc_duty(
-					XGpio_DiscreteRead(&GPIOInstR, GPIO_R_INPUT_HIGH_CHANNEL),
-					XGpio_DiscreteRead(&GPIOInstR, GPIO_R_INPUT_LOW_CHANNEL));
-			duty_cycle[1] = calc_duty(
-					XGpio_DiscreteRead(&GPIOInstG, GPIO_G_INPUT_HIGH_CHANNEL),
-					XGpio_DiscreteRead(&GPIOInstG, GPIO_G_INPUT_LOW_CHANNEL));
-			duty_cycle[2] = calc_duty(
-					XGpio_DiscreteRead(&GPIOInstB, GPIO_B_INPUT_HIGH_CHANNEL),
-					XGpio_DiscreteRead(&GPIOInstB, GPIO_B_INPUT_LOW_CHANNEL));
-
-		} else {
-			//SW Detect
-			microblaze_enable_interrupts();
+	BUILD_Report();
+	// FIT_Handler publishes through sw_duty so it never has to be masked
+	microblaze_enable_interrupts();
+	BOOT_Mark(BOOT_INPUTS);
+#ifdef ISR_BENCHMARK
+	ISR_Calibrate();
+#endif
+	start_ts = TS_now();
+	last_pass = start_ts;
+	BOOT_Mark(BOOT_LOOP);
+	while (!ctl.exit) {
+		TRACE_TOGGLE(TRACE_LOOP);
+		now = TS_now();
+		COST_Add(&loop_cost, now - last_pass);
+		last_pass = now;
+		TLM_LoopTick(now);
+
+		// Deferred start-up steps.  Once the display is up draw all of it,
+		// the color picker is only drawn in full this once.
+		if (BOOT_Poll()) {
+			UpdateRGBled(ctl.hue, ctl.sat, ctl.val, 1);
+			UpdateDispaly(ctl.hue, ctl.sat, ctl.val);
+			BOOT_Mark(BOOT_DISPLAY_DRAWN);
+			if (!TLM_Enabled() && !CMD_HostActive())
+				BOOT_Report();
 		}
 
-		DisplayDutycycle(duty_cycle[0], duty_cycle[1], duty_cycle[2]);
+		// Inputs are scanned by FIT_Handler, only react when something changed.
+		// Host commands and the playback queue change the same controls.
+		// The benchmark owns the LEDs while it runs, what changed meanwhile
+		// is applied once it is done
+		changed |= HandleInputEvents(&ctl);
+		changed |= CMD_Poll(&ctl);
+		changed |= CMD_Playback(now, &ctl);
+		if (changed && !BENCH_Running()) {
+			changed = false;
+			if (ctl.telemetry != telemetry) {
+				telemetry = ctl.telemetry;
+				TLM_SetRate(telemetry ? TLM_RATE_HZ : 0);
+			}
+			if (ctl.prescale != prescale) {
+				prescale = ctl.prescale;
+				HWDET_SetPrescale(prescale);
+			}
+			if (ctl.carrier != carrier) {
+				carrier = ctl.carrier;
+				PWM_SetCarrierPeriod(pwm_carrier_us[carrier]);
+				HSVPWM_SetCarrierPeriod(PWM_CarrierPeriod());
+			}
+			if (ctl.chart != chart || ctl.chart_rate != chart_rate) {
+				chart = ctl.chart;
+				chart_rate = ctl.chart_rate;
+				if (chart) {
+					CHART_Start(chart_rate);
+				} else if (CHART_Active()) {
+					// UpdateDispaly() puts the picker back in full once
+					// the last chart copy is done
+					CHART_Stop();
+					VIEW_Invalidate();
+				}
+			}
+			if (ctl.hw_color != hw_color) {
+				// Set the LEDs again through the other path
+				hw_color = ctl.hw_color;
+				HSVPWM_Use(hw_color);
+				UpdateRGBled(ctl.hue, ctl.sat, ctl.val, 1);
+			}
+			if (ctl.ab_mode && !ab_mode)
+				AB_Reset();
+			ab_mode = ctl.ab_mode;
+			UpdateRGBled(ctl.hue, ctl.sat, ctl.val, 0);
+			UpdateDispaly(ctl.hue, ctl.sat, ctl.val);
+			if (BOOT_DisplayReady())
+				VIEW_FrameTime(TS_now() - now);
+			INPUT_Handled();					// LEDs and display show the events
+			BOOT_Save(ctl.hue, ctl.sat, ctl.val);
+		}
+
+		// Hw Detect is read here, SW Detect is published by FIT_Handler.
+		// A/B mode, the benchmark and telemetry use both.
+#if CFG_HW_DETECT && CFG_SW_DETECT
+		if (ctl.hw_detect || ab_mode || telemetry || BENCH_Running())
+			ReadHwDetector();
+		torn_reads += DUTY_Read(&sw_duty, &sw_snap);
+		torn_reads += DUTY_Read(&hw_duty, &hw_snap);
+		duty = ctl.hw_detect ? &hw_snap : &sw_snap;
+#elif CFG_HW_DETECT
+		ReadHwDetector();
+		torn_reads += DUTY_Read(&hw_duty, &hw_snap);
+		duty = &hw_snap;
+#else
+		torn_reads += DUTY_Read(&sw_duty, &sw_snap);
+		duty = &sw_snap;
+#endif
+
+#if CFG_COMPARE
+		if (ab_mode)
+			AB_Update(now, GetRGBcommand(), &sw_snap, &hw_snap);
+		if (ctl.ab_report) {
+			ctl.ab_report = false;
+			AB_Report();
+		}
+
+		if (ctl.bench_start) {
+			ctl.bench_start = false;
+			BENCH_Start(bench_default_steps, bench_default_nsteps,
+					BENCH_REPEATS);
+		}
+		if (BENCH_Running()) {
+			if (BENCH_Update(now, sw_snap.duty, hw_snap.duty, bench_cmd)) {
+				SetRGBled(bench_cmd[0], bench_cmd[1], bench_cmd[2]);
+				BENCH_Commanded(TS_now(), sw_snap.duty, hw_snap.duty);
+			} else if (!BENCH_Running()) {
+				BENCH_Report();
+				UpdateRGBled(ctl.hue, ctl.sat, ctl.val, 1);
+			}
+		}
+#endif
+
+		DisplayDutycycle(duty->duty[0], duty->duty[1], duty->duty[2]);
+		CHART_Sample(now, duty->duty);
+		UpdateDispaly(ctl.hue, ctl.sat, ctl.val);	// what a chart copy held back
+		UpdateStrip(now, ctl.hue, ctl.sat, ctl.val);
+
+		TLM_Sample(now, GetRGBcommand(), sw_snap.duty, hw_snap.duty,
+				ctl.hw_detect ? TLM_FLAG_HW_DETECT : 0);
+		TLM_Poll();
+	}
+	TLM_SetRate(0);
+	if (ab_mode)
+		AB_Report();
+	TLM_Flush();						// frames still queued go out before the text
+	xil_printf("Duty snapshots retried: %d\n", torn_reads);
+#if CFG_HOST_LINK
+	xil_printf("Telemetry samples dropped: %d\n", TLM_Overruns());
+#endif
+	xil_printf("Main loop (%s build): %d passes, avg %d cycles, max %d cycles\n",
+			BUILD_PROFILE_NAME, loop_cost.calls,
+			(u32) (loop_cost.cycles / (loop_cost.calls ? loop_cost.calls : 1)),
+			loop_cost.max);
+#ifdef ISR_BENCHMARK
+	ISR_Report();
+#endif
+	VIEW_GetStats(&view_stats);
+	if (view_stats.frames != 0)
+		xil_printf("Display updates: %d, avg %d us, max %d us, %d bytes/update\n",
+				view_stats.frames,
+				view_stats.time_sum / view_stats.frames / TS_TICKS_PER_USEC,
+				view_stats.time_max / TS_TICKS_PER_USEC,
+				view_stats.bytes / view_stats.frames);
+	CHART_GetStats(&chart_stats);
+	if (chart_stats.samples != 0)
+		xil_printf("Strip chart: %d samples, %d skipped, %d bytes and %d us/sample, max %d us\n",
+				chart_stats.samples, chart_stats.skipped,
+				chart_stats.bytes / chart_stats.samples,
+				chart_stats.time_sum / chart_stats.samples / TS_TICKS_PER_USEC,
+				chart_stats.time_max / TS_TICKS_PER_USEC);
+	if (WS_Present()) {
+		WS_GetStats(&ws_stats);
+		if (ws_stats.uploads == 0)
+			ws_stats.uploads = 1;
+		xil_printf("WS2812: %d pixels, %d frames in %d ms, last frame %d us\n",
+				WS_NumPixels(), ws_stats.frames,
+				(TS_now() - start_ts) / (TS_TICKS_PER_USEC * 1000),
+				ws_stats.frame_clks / TS_TICKS_PER_USEC);
+		xil_printf("WS2812 upload: avg %d us, max %d us over %d uploads\n",
+				ws_stats.upload_sum / ws_stats.uploads / TS_TICKS_PER_USEC,
+				ws_stats.upload_max / TS_TICKS_PER_USEC, ws_stats.uploads);
 	}
+	CMD_GetStats(&cmd_stats);
+	if (cmd_stats.bytes != 0) {
+		xil_printf("Commands: %d, %d repeated, %d rejected, %d CRC errors\n",
+				cmd_stats.commands, cmd_stats.duplicates, cmd_stats.rejected,
+				cmd_stats.crc_errors);
+		xil_printf("Command receive: %d bytes, %d dropped, %d UART overruns\n",
+				cmd_stats.bytes, cmd_stats.overflows, cmd_stats.uart_overruns);
+		xil_printf("Playback: %d frames, worst %d us late\n", cmd_stats.played,
+				cmd_stats.late_max / TS_TICKS_PER_USEC);
+	}
+	INPUT_GetStats(&input_stats);
+	if (input_stats.events == 0)
+		input_stats.events = 1;
+	xil_printf("Input events: %d, dropped: %d, latency avg %d us, max %d us\n",
+			input_stats.events, input_stats.dropped,
+			(u32) (input_stats.latency_sum / input_stats.events) / TS_TICKS_PER_USEC,
+			input_stats.latency_max / TS_TICKS_PER_USEC);
+
+	// Exiting before the display came up
+	BOOT_Finish();
 
 	// Announce that we're done and clear the LED's
 	xil_printf("\nThat's All Folks!\n\n");
 	NX4IO_setLEDs(0x00);
 	NX4IO_RGBLED_setChnlEn(RGB1, false, false, false);
 	NX4IO_RGBLED_setChnlEn(RGB2, false, false, false);
+	while (CHART_DisplayBusy())
+		;
 	OLEDrgb_Clear (&pmodOLEDrgb_inst);
 
 	OLEDrgb_PutStringXY(4, 2, "BYE BYE");
@@ -88,10 +314,50 @@ int main(void) {
  *
  * Reads the GPIO port which reads back the hardware generated PWM wave for the RGB Leds
  *
- * Calculates the duty cycle at every rising edge
+ * Calculates the duty cycle and the period at every rising edge
  * Counts low and high signals depending on previous signals
+ * Calls a channel saturated (0% or 99%) after SW_STUCK_PERIODS periods at
+ * one level, taking the longer of the last two periods so that the short
+ * period a duty change can cut does not make the next one look stuck.
+ * The edge that ends a saturated level does not end a period, the duty is
+ * measured again from the next one, and until then the wait is the full
+ * SW_DETECT_TIMEOUT_TICKS.
+ * Publishes all three duty cycles through sw_duty whenever one of them changes
+ * Decodes the encoder every tick and scans the buttons, switches and
+ * encoder detents every INPUT_SCAN_DIVIDER ticks
+ * Empties the UART receive FIFO when there is no UART interrupt
+ * Builds without the software detector (build_config.h) only do the scans
+ *
+ * With FIT_FAST_INTERRUPT the controller vectors here directly, otherwise
+ * it is called by the XIntc dispatcher.  The controller is acknowledged
+ * by the hardware or the dispatcher, not here.
  *****************************************************************************/
 void FIT_Handler(void) {
+	static u8 scan_ticks;
+#if CFG_SW_DETECT || defined(ISR_BENCHMARK)
+	u32 start;
+#endif
+#if CFG_SW_DETECT
+	static u8 duty_cycle[NUM_DUTY_CHANNELS];
+	static u32 stuck_limit[NUM_DUTY_CHANNELS] = { SW_DETECT_TIMEOUT_TICKS,
+			SW_DETECT_TIMEOUT_TICKS, SW_DETECT_TIMEOUT_TICKS };
+	static u32 last_period[NUM_DUTY_CHANNELS];
+	static u8 saturated;			// DUTY_SATURATED() bits
+	static u8 resync;				// the next rising edge is not a period
+	bool changed = false;
+	u32 period, longer;
+	u8 duty, bit;
+#endif
+
+	TRACE_ON(TRACE_FIT);
+#if CFG_SW_DETECT || defined(ISR_BENCHMARK)
+	start = TS_now();
+#endif
+#ifdef ISR_BENCHMARK
+	ISR_EntrySample(start);
+#endif
+
+#if CFG_SW_DETECT
 	// Read the GPIO port to read back the generated PWM signal for RGB led's
 	gpio_in = XGpio_DiscreteRead(&GPIOInst0, GPIO_0_INPUT_0_CHANNEL);
 
@@ -101,23 +367,66 @@ void FIT_Handler(void) {
 	signal[2] = (gpio_in & 0x02) >> 1;
 
 	for (u8 color = 0; color < 3; color++) {
+		bit = DUTY_SATURATED(color);
 		if (!old_signal[color] && signal[color]) //detect_rising_edge(signal);
 				{
-			duty_cycle[color] = calc_duty(high_level[color], low_level[color]);
+			if (resync & bit) {
+				resync &= ~bit;
+			} else {
+				duty = calc_duty(high_level[color], low_level[color]);
+				changed |= (duty != duty_cycle[color]) || (saturated & bit);
+				duty_cycle[color] = duty;
+				saturated &= ~bit;
+				period = high_level[color] + low_level[color];
+				longer = (period > last_period[color]) ? period : last_period[color];
+				last_period[color] = period;
+				stuck_limit[color] =
+						(longer < SW_DETECT_TIMEOUT_TICKS / SW_STUCK_PERIODS) ?
+								longer * SW_STUCK_PERIODS : SW_DETECT_TIMEOUT_TICKS;
+			}
 			high_level[color] = 1;
 		} else if (old_signal[color] && !signal[color]) //detect_failing_edge(signal);
 				{
 			low_level[color] = 0;
 		} else if (old_signal[color] && signal[color]) {
 			high_level[color]++;
-			if (high_level[color] == 10000)
+			if (high_level[color] == stuck_limit[color]) {
+				changed |= (duty_cycle[color] != 99) || !(saturated & bit);
 				duty_cycle[color] = 99;
+				saturated |= bit;
+				resync |= bit;
+				stuck_limit[color] = SW_DETECT_TIMEOUT_TICKS;
+			}
 
 		} else if (!old_signal[color] && !signal[color]) {
 			low_level[color]++;
-			if (low_level[color] == 10000)
+			if (low_level[color] == stuck_limit[color]) {
+				changed |= (duty_cycle[color] != 0) || !(saturated & bit);
 				duty_cycle[color] = 0;
+				saturated |= bit;
+				resync |= bit;
+				stuck_limit[color] = SW_DETECT_TIMEOUT_TICKS;
+			}
 		}
 		old_signal[color] = signal[color];
 	}
+
+	if (changed) {
+		DUTY_Publish(&sw_duty, duty_cycle, saturated);
+		TRACE_PULSE(TRACE_SW_PUBLISH);
+	}
+	COST_Add(&fit_cost, TS_now() - start);
+#endif
+
+	INPUT_SampleEncoder();
+	if (++scan_ticks >= INPUT_SCAN_DIVIDER) {
+		scan_ticks = 0;
+		INPUT_Scan();
+	}
+
+#ifndef CMD_UART_INTERRUPT_ID
+	// No UART interrupt in this design, 16 byte FIFO / 40 kHz is plenty
+	CMD_RxIsr((void *) 0);
+#endif
+	TRACE_OFF(TRACE_FIT);
 }
@@ -0,0 +1,187 @@
+/*
+ * strip_chart.c
+ */
+
+#include "strip_chart.h"
+#include "boot.h"
+#include "trace.h"
+
+#if CFG_GRAPHICS
+
+#define CHART_X1			(CHART_X0 + CHART_WIDTH - 1)
+#define CHART_Y1			(CHART_Y0 + CHART_HEIGHT - 1)
+#define COPY_WAIT_TICKS		(CHART_COPY_WAIT_US * TS_TICKS_PER_USEC)
+
+#define GRID_COLOR			0x2104			// dark grey, 50% line
+
+// Sample rates selected by switches 12:11, the default first
+const u8 chart_rate_hz[CHART_RATES] = { 20, 50, 100, 10 };
+
+static const u16 channel_color[NUM_DUTY_CHANNELS] = {
+	0xF800, 0x07E0, 0x001F					// red, green, blue
+};
+
+static bool active;
+static bool drawn;					// the plot area has been cleared
+static bool column_pending;			// column[] goes out once the copy is done
+static bool copying;				// a copy or clear may still be running
+static u32 busy_since;				// last copy or clear sent to the SSD1331
+static u32 period;					// TS ticks between samples
+static u32 next_sample;
+static u8 column[CHART_HEIGHT * 2];
+static ChartStats stats;
+
+/****************************************************************************/
+/**
+ * Send a graphic acceleration command, the SSD1331 runs it on its own
+ *****************************************************************************/
+static void send_command(u8 *cmd, u8 len, u32 now) {
+	TRACE_ON(TRACE_OLED);
+	OLEDrgb_WriteSPI(&pmodOLEDrgb_inst, cmd, len, NULL, 0);
+	TRACE_OFF(TRACE_OLED);
+	stats.bytes += len;
+	busy_since = now;
+	copying = true;
+}
+
+/****************************************************************************/
+/**
+ * Build the new right hand column from the duty cycles
+ *****************************************************************************/
+static void build_column(const u8 *duty) {
+	u16 color[CHART_HEIGHT];
+	u8 ch, y;
+
+	for (y = 0; y < CHART_HEIGHT; y++)
+		color[y] = 0;
+	color[(CHART_HEIGHT - 1) / 2] = GRID_COLOR;
+	for (ch = 0; ch < NUM_DUTY_CHANNELS; ch++) {
+		y = CHART_HEIGHT - 1 - (u16) (duty[ch] > 99 ? 99 : duty[ch])
+				* (CHART_HEIGHT - 1) / 99;
+		color[y] = (color[y] == GRID_COLOR ? 0 : color[y]) | channel_color[ch];
+	}
+	for (y = 0; y < CHART_HEIGHT; y++) {
+		column[2 * y] = color[y] >> 8;
+		column[2 * y + 1] = color[y];
+	}
+}
+
+/****************************************************************************/
+/**
+ * Start plotting, from an empty chart
+ *
+ * @param	rate is an index into chart_rate_hz[]
+ *****************************************************************************/
+void CHART_Start(u8 rate) {
+	if (rate >= CHART_RATES)
+		rate = 0;
+	period = AXI_CLOCK_FREQ_HZ / chart_rate_hz[rate];
+	if (!active) {
+		active = true;
+		drawn = false;
+		column_pending = false;
+	}
+}
+
+/****************************************************************************/
+/**
+ * Stop plotting.  The caller redraws whatever goes in the area.
+ *****************************************************************************/
+void CHART_Stop(void) {
+	active = false;
+}
+
+/****************************************************************************/
+/**
+ * @return	true while the chart owns its part of the display
+ *****************************************************************************/
+bool CHART_Active(void) {
+	return active;
+}
+
+/****************************************************************************/
+/**
+ * @return	true while the SSD1331 may still be running the last copy or clear
+ * 			window command.  No other command or pixel data may be sent then.
+ *****************************************************************************/
+bool CHART_DisplayBusy(void) {
+	if (copying && TS_now() - busy_since >= COPY_WAIT_TICKS)
+		copying = false;
+	return copying;
+}
+
+/****************************************************************************/
+/**
+ * Plot a sample when one is due
+ *
+ * Call once per main loop pass.  Never waits for the display: a sample
+ * is sent as a copy window command in one call and its column in a later
+ * one, CHART_COPY_WAIT_US after the copy.
+ *
+ * @param	now is TS_now()
+ * @param	duty is the latest R, G, B duty cycles
+ *****************************************************************************/
+void CHART_Sample(u32 now, const u8 *duty) {
+	u8 cmd[7];
+	u32 start, ticks;
+
+	if (!active || !BOOT_DisplayReady())
+		return;
+	if (drawn && !column_pending && (s32) (now - next_sample) < 0)
+		return;
+	if ((drawn || column_pending) && now - busy_since < COPY_WAIT_TICKS)
+		return;
+
+	start = TS_now();
+	if (!drawn) {
+		cmd[0] = CMD_CLEARWINDOW;
+		cmd[1] = CHART_X0;
+		cmd[2] = CHART_Y0;
+		cmd[3] = CHART_X1;
+		cmd[4] = CHART_Y1;
+		send_command(cmd, 5, start);
+		drawn = true;
+		next_sample = now;
+		return;
+	} else if (column_pending) {
+		TRACE_ON(TRACE_OLED);
+		OLEDrgb_DrawBitmap(&pmodOLEDrgb_inst, CHART_X1, CHART_Y0, CHART_X1,
+				CHART_Y1, column);
+		TRACE_OFF(TRACE_OLED);
+		stats.bytes += 6 + sizeof(column);		// column, row address commands
+		stats.samples++;
+		column_pending = false;
+	} else {
+		// Fell more than a sample behind, e.g. while the display was busy
+		next_sample += period;
+		if ((s32) (now - next_sample) >= 0) {
+			stats.skipped += (now - next_sample) / period + 1;
+			next_sample = now + period;
+		}
+		build_column(duty);
+		cmd[0] = CMD_COPYWINDOW;
+		cmd[1] = CHART_X0 + 1;
+		cmd[2] = CHART_Y0;
+		cmd[3] = CHART_X1;
+		cmd[4] = CHART_Y1;
+		cmd[5] = CHART_X0;
+		cmd[6] = CHART_Y0;
+		send_command(cmd, 7, start);
+		column_pending = true;
+	}
+
+	ticks = TS_now() - start;
+	stats.time_sum += ticks;
+	if (ticks > stats.time_max)
+		stats.time_max = ticks;
+}
+
+/****************************************************************************/
+/**
+ * Get the chart statistics
+ *****************************************************************************/
+void CHART_GetStats(ChartStats *s) {
+	*s = stats;
+}
+
+#endif /* CFG_GRAPHICS */
@@ -0,0 +1,69 @@
+/*
+ * strip_chart.h
+ *
+ *  Scrolling plot of the detected R, G and B duty cycles on the PmodOLEDrgb.
+ *  With switch 10 up it takes the place of the color picker:
+ *
+ *      x 48 - 95, y  0 - 47   duty 99% at the top, 0% at the bottom
+ *
+ *  Each sample moves the plot one column left with the SSD1331 copy window
+ *  command and then writes only the new right hand column, so a sample is
+ *  about 110 SPI bytes however much is on the screen.  The copy runs in the
+ *  controller, the new column is written CHART_COPY_WAIT_US later from a
+ *  following main loop pass rather than waiting for it.  Nothing else may be
+ *  sent to the SSD1331 while it copies: every other OLED writer checks
+ *  CHART_DisplayBusy() first and draws on a later pass.
+ *
+ *  Switches 12:11 pick the sample rate from chart_rate_hz[].
+ */
+
+#ifndef SRC_STRIP_CHART_H_
+#define SRC_STRIP_CHART_H_
+
+#include "hw_interface.h"
+
+/************************** Constant Definitions ****************************/
+
+#define CHART_X0			48
+#define CHART_WIDTH			48
+#define CHART_Y0			0
+#define CHART_HEIGHT		48
+#define CHART_RATES			4			// entries in chart_rate_hz[]
+#define CHART_COPY_WAIT_US	1000		// SSD1331 copy window time, generous
+
+/**************************** Type Definitions ******************************/
+
+typedef struct {
+	u32		samples;		// columns drawn
+	u32		skipped;		// samples due while the last was still drawing
+	u32		bytes;			// SPI bytes sent, commands and pixels
+	u32		time_sum;		// TS ticks spent in CHART_Sample() doing work
+	u32		time_max;		// TS ticks, the worst single call
+} ChartStats;
+
+#if CFG_GRAPHICS
+
+/************************** Variable Definitions ****************************/
+extern const u8 chart_rate_hz[CHART_RATES];
+
+/************************** Function Prototypes *****************************/
+void CHART_Start(u8 rate);
+void CHART_Stop(void);
+bool CHART_Active(void);
+bool CHART_DisplayBusy(void);
+void CHART_Sample(u32 now, const u8 *duty);
+void CHART_GetStats(ChartStats *stats);
+
+#else
+
+// Not in this build, see build_config.h
+static inline void CHART_Start(u8 rate) { }
+static inline void CHART_Stop(void) { }
+static inline bool CHART_Active(void) { return false; }
+static inline bool CHART_DisplayBusy(void) { return false; }
+static inline void CHART_Sample(u32 now, const u8 *duty) { }
+static inline void CHART_GetStats(ChartStats *stats) { *stats = (ChartStats) { 0 }; }
+
+#endif /* CFG_GRAPHICS */
+
+#endif /* SRC_STRIP_CHART_H_ */
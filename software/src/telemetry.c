@@ -0,0 +1,151 @@
+/*
+ * telemetry.c
+ */
+
+#include <string.h>
+#include "telemetry.h"
+#include "xuartlite_l.h"
+
+#if CFG_HOST_LINK
+
+static u8 tx_buf[TLM_TX_BUFFER_SIZE];
+static u16 tx_head, tx_tail;
+
+static u32 period_ticks;		// 0 when telemetry is off
+static u32 next_sample;
+static u32 seq;
+static u32 overruns;			// samples dropped because the ring was full
+
+static u32 loop_last, loop_count, loop_max;
+
+/****************************************************************************/
+/**
+ * Set the telemetry rate
+ *
+ * @param	rate_hz is the number of samples per second, 0 turns telemetry
+ * 			off.  Clamped to TLM_MAX_RATE_HZ.
+ *****************************************************************************/
+void TLM_SetRate(u32 rate_hz) {
+	if (rate_hz > TLM_MAX_RATE_HZ)
+		rate_hz = TLM_MAX_RATE_HZ;
+	period_ticks = rate_hz ? AXI_CLOCK_FREQ_HZ / rate_hz : 0;
+	next_sample = TS_now();
+}
+
+/****************************************************************************/
+/**
+ * @return	true if telemetry frames are being sent
+ *****************************************************************************/
+bool TLM_Enabled(void) {
+	return period_ticks != 0;
+}
+
+/****************************************************************************/
+/**
+ * Account for one main loop pass
+ *
+ * @param	now is TS_now() at the top of the loop
+ *****************************************************************************/
+void TLM_LoopTick(u32 now) {
+	u32 elapsed = now - loop_last;
+
+	if (loop_count && elapsed > loop_max)
+		loop_max = elapsed;
+	loop_last = now;
+	loop_count++;
+}
+
+/****************************************************************************/
+/**
+ * Queue a telemetry frame if one is due
+ *
+ * @param	now is the current TS_now()
+ * @param	cmd is the commanded R, G, B
+ * @param	sw_duty is the software detected duty cycle of each channel
+ * @param	hw_duty is the hardware detected duty cycle of each channel
+ * @param	flags is a combination of TLM_FLAG_x
+ *****************************************************************************/
+void TLM_Sample(u32 now, const u8 *cmd, const u8 *sw_duty, const u8 *hw_duty,
+		u8 flags) {
+	TelemetryRecord rec;
+	u8 payload[TLM_PAYLOAD_SIZE];
+
+	if (!period_ticks || (s32) (now - next_sample) < 0)
+		return;
+	next_sample += period_ticks;
+	if ((s32) (now - next_sample) >= 0)		// fell behind, don't burst
+		next_sample = now + period_ticks;
+
+	rec.seq = seq++;
+	rec.timestamp = now;
+	memcpy(rec.cmd, cmd, 3);
+	memcpy(rec.sw_duty, sw_duty, 3);
+	memcpy(rec.hw_duty, hw_duty, 3);
+	rec.flags = flags;
+	rec.loops = loop_count;
+	rec.loop_max = loop_max;
+	loop_count = 0;
+	loop_max = 0;
+
+	FRAME_PackTelemetry(&rec, payload);
+	if (!TLM_SendFrame(FRAME_TYPE_TELEMETRY, payload, TLM_PAYLOAD_SIZE))
+		overruns++;
+}
+
+/****************************************************************************/
+/**
+ * Queue any frame for transmission, e.g. a command ACK
+ *
+ * @param	type is the frame type
+ * @param	payload is the payload, len bytes
+ * @param	len is the payload length, at most FRAME_MAX_PAYLOAD
+ *
+ * @return	true if the frame was queued, false if the ring is too full
+ *****************************************************************************/
+bool TLM_SendFrame(u8 type, const u8 *payload, u8 len) {
+	u8 frame[FRAME_MAX_SIZE];
+	u16 size, free, i;
+
+	size = FRAME_Encode(type, payload, len, frame);
+	free = (tx_tail - tx_head - 1) & (TLM_TX_BUFFER_SIZE - 1);
+	if (size == 0 || size > free)
+		return false;
+	for (i = 0; i < size; i++) {
+		tx_buf[tx_head] = frame[i];
+		tx_head = (tx_head + 1) & (TLM_TX_BUFFER_SIZE - 1);
+	}
+	return true;
+}
+
+/****************************************************************************/
+/**
+ * Move queued bytes into the UART transmit FIFO until it is full
+ *
+ * Never waits, call it once per main loop pass.
+ *****************************************************************************/
+void TLM_Poll(void) {
+	while (tx_tail != tx_head && !XUartLite_IsTransmitFull(TLM_UART_BASEADDR)) {
+		XUartLite_SendByte(TLM_UART_BASEADDR, tx_buf[tx_tail]);
+		tx_tail = (tx_tail + 1) & (TLM_TX_BUFFER_SIZE - 1);
+	}
+}
+
+/****************************************************************************/
+/**
+ * Send everything queued, waiting on the UART.  For the end of the run,
+ * when TLM_Poll() is no longer called.
+ *****************************************************************************/
+void TLM_Flush(void) {
+	while (tx_tail != tx_head)
+		TLM_Poll();
+}
+
+/****************************************************************************/
+/**
+ * @return	the number of samples dropped because the UART could not keep up
+ *****************************************************************************/
+u32 TLM_Overruns(void) {
+	return overruns;
+}
+
+#endif /* CFG_HOST_LINK */
@@ -0,0 +1,52 @@
+/*
+ * telemetry.h
+ *
+ *  Binary telemetry over the USB-UART.
+ *  At the configured rate the main loop packs the commanded RGB values, both
+ *  detectors' duty cycles and the loop timing into a FRAME_TYPE_TELEMETRY
+ *  frame (see frame_codec.h).  Frames are queued in a transmit ring and
+ *  trickled into the UART FIFO by TLM_Poll() so the loop never waits on the
+ *  UART.  tools/tlm_decode decodes the stream on the host.
+ *  TLM_SendFrame() queues other frames (command ACKs) on the same ring.
+ */
+
+#ifndef SRC_TELEMETRY_H_
+#define SRC_TELEMETRY_H_
+
+#include "hw_interface.h"
+#include "frame_codec.h"
+
+/************************** Constant Definitions ****************************/
+
+#define TLM_UART_BASEADDR		STDOUT_BASEADDRESS
+#define TLM_TX_BUFFER_SIZE		256		// bytes, must be a power of 2
+#ifndef TLM_RATE_HZ
+#define TLM_RATE_HZ				20		// rate used when switch 15 turns telemetry on
+#endif
+#define TLM_MAX_RATE_HZ			200		// ~6.4 KB/s, about half of 115200 baud
+
+/************************** Function Prototypes *****************************/
+#if CFG_HOST_LINK
+void TLM_SetRate(u32 rate_hz);
+bool TLM_Enabled(void);
+void TLM_LoopTick(u32 now);
+void TLM_Sample(u32 now, const u8 *cmd, const u8 *sw_duty, const u8 *hw_duty,
+		u8 flags);
+bool TLM_SendFrame(u8 type, const u8 *payload, u8 len);
+void TLM_Poll(void);
+void TLM_Flush(void);
+u32 TLM_Overruns(void);
+#else
+// Not in this build, see build_config.h
+static inline void TLM_SetRate(u32 rate_hz) { }
+static inline bool TLM_Enabled(void) { return false; }
+static inline void TLM_LoopTick(u32 now) { }
+static inline void TLM_Sample(u32 now, const u8 *cmd, const u8 *sw_duty,
+		const u8 *hw_duty, u8 flags) { }
+static inline bool TLM_SendFrame(u8 type, const u8 *payload, u8 len) { return false; }
+static inline void TLM_Poll(void) { }
+static inline void TLM_Flush(void) { }
+static inline u32 TLM_Overruns(void) { return 0; }
+#endif /* CFG_HOST_LINK */
+
+#endif /* SRC_TELEMETRY_H_ */
@@ -0,0 +1,65 @@
+/*
+ * trace.h
+ *
+ *  Timing trace on the JC Pmod header for a logic analyzer
+ *  (hardware/trace_axi.v).  Each macro is one AXI store to a set, clear or
+ *  toggle register, so nothing has to be read back and the FIT handler and
+ *  the main loop can share the port.  The pins follow a fixed number of
+ *  clocks after the store.
+ *
+ *      JC pin 1   TRACE_FIT         high while FIT_Handler runs
+ *      JC pin 2   TRACE_LOOP        toggles at the top of each main loop pass
+ *      JC pin 3   TRACE_OLED        high during a PmodOLEDrgb transfer
+ *      JC pin 4   TRACE_SW_PUBLISH  pulse when FIT_Handler publishes sw_duty
+ *      JC pin 7   TRACE_HW_PUBLISH  pulse when ReadHwDetector() publishes hw_duty
+ *      JC pin 8   TRACE_COLOR       high while UpdateRGBled() converts and sets
+ *      JC pin 9   TRACE_USER0       free for ad hoc measurements
+ *      JC pin 10  TRACE_USER1
+ *
+ *  The macros compile to nothing without the trace register in the BSP or
+ *  with CFG_TRACE 0 (build_config.h).
+ */
+
+#ifndef SRC_TRACE_H_
+#define SRC_TRACE_H_
+
+#include "hw_interface.h"
+#include "xil_io.h"
+
+/************************** Constant Definitions ****************************/
+
+#if CFG_TRACE && defined(XPAR_M_AXI_TRACE_BASEADDR)
+#define TRACE_BASEADDR			XPAR_M_AXI_TRACE_BASEADDR
+#endif
+
+// Register offsets, see trace_axi.v
+#define TRACE_DATA_OFFSET		0x0
+#define TRACE_SET_OFFSET		0x4
+#define TRACE_CLEAR_OFFSET		0x8
+#define TRACE_TOGGLE_OFFSET		0xC
+
+#define TRACE_FIT				0x01
+#define TRACE_LOOP				0x02
+#define TRACE_OLED				0x04
+#define TRACE_SW_PUBLISH		0x08
+#define TRACE_HW_PUBLISH		0x10
+#define TRACE_COLOR				0x20
+#define TRACE_USER0				0x40
+#define TRACE_USER1				0x80
+
+/***************** Macros (Inline Functions) Definitions ********************/
+
+#ifdef TRACE_BASEADDR
+#define TRACE_ON(bits)			Xil_Out32(TRACE_BASEADDR + TRACE_SET_OFFSET, (bits))
+#define TRACE_OFF(bits)			Xil_Out32(TRACE_BASEADDR + TRACE_CLEAR_OFFSET, (bits))
+#define TRACE_TOGGLE(bits)		Xil_Out32(TRACE_BASEADDR + TRACE_TOGGLE_OFFSET, (bits))
+#else
+#define TRACE_ON(bits)
+#define TRACE_OFF(bits)
+#define TRACE_TOGGLE(bits)
+#endif
+
+// A pulse as wide as one store, a few AXI clocks
+#define TRACE_PULSE(bits)		do { TRACE_ON(bits); TRACE_OFF(bits); } while (0)
+
+#endif /* SRC_TRACE_H_ */
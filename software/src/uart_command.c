@@ -0,0 +1,317 @@
+/*
+ * uart_command.c
+ */
+
+#include "functional_interface.h"
+#include "xuartlite_l.h"
+#include "mb_interface.h"
+
+#if CFG_HOST_LINK
+
+// Receive buffers shared between CMD_RxIsr() and CMD_Poll().  The ISR only
+// fills a buffer that is not full and the main loop only reads full ones.
+// They are filled and read strictly in turn, so the bytes stay in order.
+static u8 rx_buf[2][CMD_RX_BUFFER_SIZE];
+static volatile u16 rx_len[2];
+static volatile bool rx_full[2];
+static volatile u8 rx_fill;				// buffer the ISR is filling
+static u8 rx_read;						// buffer CMD_Poll() reads next
+static volatile u32 rx_bytes, rx_overflows, rx_uart_overruns;
+
+// Playback queue, owned by the main loop
+static ColorFrame queue[CMD_QUEUE_SIZE];
+static u16 queue_head, queue_tail;
+static bool playing, looping;
+static u32 next_frame;
+
+static FrameDecoder decoder;
+static bool have_seq;
+static u8 last_seq;
+static bool host_active;
+static CommandStats stats;
+
+#define QUEUE_COUNT()		((u16) (queue_head - queue_tail) & (CMD_QUEUE_SIZE - 1))
+#define QUEUE_FREE()		(CMD_QUEUE_SIZE - 1 - QUEUE_COUNT())
+
+/****************************************************************************/
+/**
+ * Start receiving commands
+ *
+ * Connects CMD_RxIsr() to the UART interrupt if there is one.  Call after
+ * do_init_inputs().
+ *
+ * @return	XST_SUCCESS or the XIntc_Connect() error
+ *****************************************************************************/
+int CMD_Init(void) {
+	FRAME_DecoderInit(&decoder);
+
+#ifdef CMD_UART_INTERRUPT_ID
+	{
+		int status = XIntc_Connect(&IntrptCtlrInst, CMD_UART_INTERRUPT_ID,
+				(XInterruptHandler) CMD_RxIsr, (void *) 0);
+		if (status != XST_SUCCESS)
+			return status;
+		XIntc_Enable(&IntrptCtlrInst, CMD_UART_INTERRUPT_ID);
+		XUartLite_EnableIntr(CMD_UART_BASEADDR);
+	}
+#endif
+	return XST_SUCCESS;
+}
+
+/****************************************************************************/
+/**
+ * Move everything in the UART receive FIFO into the fill buffer
+ *
+ * Interrupt context only.  The buffer is handed to the main loop when it
+ * is full and the ISR moves on to the other one.  If main has not read that
+ * one yet the bytes are dropped until it has, so nothing is put in ahead of
+ * a buffer that is still waiting.  CMD_Poll() picks up a partly filled
+ * buffer itself.
+ *****************************************************************************/
+void CMD_RxIsr(void *unused) {
+	u8 fill = rx_fill;
+	u32 status;
+
+	while ((status = XUartLite_GetStatusReg(CMD_UART_BASEADDR))
+			& XUL_SR_RX_FIFO_VALID_DATA) {
+		u8 byte = XUartLite_ReadReg(CMD_UART_BASEADDR, XUL_RX_FIFO_OFFSET);
+
+		if (status & XUL_SR_OVERRUN_ERROR)
+			rx_uart_overruns++;
+		rx_bytes++;
+		if (rx_full[fill]) {			// main has not read this one yet
+			rx_overflows++;
+			continue;
+		}
+		rx_buf[fill][rx_len[fill]++] = byte;
+		if (rx_len[fill] == CMD_RX_BUFFER_SIZE) {
+			rx_full[fill] = true;
+			fill ^= 1;
+		}
+	}
+	rx_fill = fill;
+}
+
+/****************************************************************************/
+/**
+ * Send the ACK for a command
+ *****************************************************************************/
+static void send_ack(u8 seq, u8 type, u8 status) {
+	CommandAck ack;
+	u8 payload[CMD_ACK_SIZE];
+
+	ack.seq = seq;
+	ack.type = type;
+	ack.status = status;
+	ack.queued = QUEUE_COUNT();
+	ack.free = QUEUE_FREE();
+	FRAME_PackAck(&ack, payload);
+	TLM_SendFrame(FRAME_TYPE_ACK, payload, CMD_ACK_SIZE);
+	if (status != CMD_STATUS_OK)
+		stats.rejected++;
+}
+
+/****************************************************************************/
+/**
+ * Carry out one decoded command
+ *
+ * @return	true if the color controls changed
+ *****************************************************************************/
+static bool execute(ColorControl *ctl, u8 type, const u8 *p, u8 len) {
+	ColorFrame frames[CMD_MAX_BATCH];
+	u8 status = CMD_STATUS_OK;
+	bool changed = false;
+	int count, i;
+
+	if (len == 0) {
+		send_ack(0, type, CMD_STATUS_BAD_LENGTH);
+		return false;
+	}
+	if (have_seq && p[0] == last_seq) {
+		stats.duplicates++;
+		send_ack(p[0], type, CMD_STATUS_OK);
+		return false;
+	}
+
+	switch (type) {
+	case FRAME_TYPE_SET_HSV:
+		if (len != 5 || FRAME_GetU16(&p[1]) > 360 || p[3] > 100 || p[4] > 100) {
+			status = CMD_STATUS_BAD_LENGTH;
+			break;
+		}
+		ctl->hue = FRAME_GetU16(&p[1]);
+		ctl->sat = p[3];
+		ctl->val = p[4];
+		changed = true;
+		break;
+
+	case FRAME_TYPE_SET_RGB:
+		if (len != 4) {
+			status = CMD_STATUS_BAD_LENGTH;
+			break;
+		}
+		// Bypasses HSV until the next HSV change
+		SetRGBled(p[1], p[2], p[3]);
+		break;
+
+	case FRAME_TYPE_SET_MODE:
+		if (len != 2) {
+			status = CMD_STATUS_BAD_LENGTH;
+			break;
+		}
+		ctl->hw_detect = (p[1] & CMD_MODE_HW_DETECT) != 0;
+		ctl->ab_mode = (p[1] & CMD_MODE_AB) != 0;
+		changed = true;
+		break;
+
+	case FRAME_TYPE_QUEUE:
+		count = FRAME_UnpackColorFrames(p, len, frames);
+		if (count < 0) {
+			status = CMD_STATUS_BAD_LENGTH;
+			break;
+		}
+		if (count > QUEUE_FREE()) {
+			status = CMD_STATUS_QUEUE_FULL;
+			break;
+		}
+		for (i = 0; i < count; i++) {
+			queue[queue_head] = frames[i];
+			queue_head = (queue_head + 1) & (CMD_QUEUE_SIZE - 1);
+		}
+		break;
+
+	case FRAME_TYPE_PLAY:
+		if (len != 2) {
+			status = CMD_STATUS_BAD_LENGTH;
+			break;
+		}
+		looping = p[1] != 0;
+		if (!playing) {
+			playing = true;
+			next_frame = TS_now();
+		}
+		break;
+
+	case FRAME_TYPE_STOP:
+		playing = false;
+		queue_tail = queue_head;
+		break;
+
+	default:
+		status = CMD_STATUS_UNKNOWN;
+		break;
+	}
+
+	// A rejected command can be sent again with the same number
+	if (status == CMD_STATUS_OK) {
+		have_seq = true;
+		last_seq = p[0];
+	}
+	send_ack(p[0], type, status);
+	return changed;
+}
+
+/****************************************************************************/
+/**
+ * Decode and carry out the commands received since the last call
+ *
+ * Once the full buffers are read, a partly filled one is taken from the ISR
+ * as well, with interrupts off for the handover.  The ISR only runs when
+ * bytes arrive, so it cannot be left to hand over the end of a burst.
+ *
+ * @param	ctl is updated by HSV and mode commands
+ *
+ * @return	true if the controls changed
+ *****************************************************************************/
+bool CMD_Poll(ColorControl *ctl) {
+	bool changed = false;
+	u16 i;
+
+	for (;;) {
+		if (!rx_full[rx_read]) {
+			if (rx_len[rx_read] == 0)
+				break;
+			microblaze_disable_interrupts();
+			if (!rx_full[rx_read]) {	// the ISR did not fill it meanwhile
+				rx_full[rx_read] = true;
+				rx_fill = rx_read ^ 1;
+			}
+			microblaze_enable_interrupts();
+		}
+		for (i = 0; i < rx_len[rx_read]; i++) {
+			if (FRAME_DecodeByte(&decoder, rx_buf[rx_read][i])) {
+				host_active = true;
+				stats.commands++;
+				changed |= execute(ctl, decoder.type, decoder.payload,
+						decoder.len);
+			}
+		}
+		rx_len[rx_read] = 0;
+		__asm__ __volatile__("" ::: "memory");
+		rx_full[rx_read] = false;
+		rx_read ^= 1;
+	}
+	return changed;
+}
+
+/****************************************************************************/
+/**
+ * Play the queued colors on schedule
+ *
+ * Each frame is held for its hold_ms counted from when the previous one was
+ * due, not when it was played, so a late main loop pass does not make the
+ * playback drift.
+ *
+ * @return	true if a new color was put in ctl
+ *****************************************************************************/
+bool CMD_Playback(u32 now, ColorControl *ctl) {
+	ColorFrame *f;
+	u32 late;
+
+	if (!playing || (s32) (now - next_frame) < 0)
+		return false;
+	if (queue_head == queue_tail) {			// ran dry, wait for more frames
+		next_frame = now;
+		return false;
+	}
+
+	late = now - next_frame;
+	if (late > stats.late_max)
+		stats.late_max = late;
+
+	f = &queue[queue_tail];
+	ctl->hue = f->hue;
+	ctl->sat = f->sat;
+	ctl->val = f->val;
+	next_frame += f->hold_ms * (TS_TICKS_PER_USEC * 1000);
+	if (looping)
+		queue[queue_head] = *f;
+	queue_tail = (queue_tail + 1) & (CMD_QUEUE_SIZE - 1);
+	if (looping)
+		queue_head = (queue_head + 1) & (CMD_QUEUE_SIZE - 1);
+	stats.played++;
+	return true;
+}
+
+/****************************************************************************/
+/**
+ * @return	true once a host has sent a good command.  Text output is kept
+ * 			off the UART from then on.
+ *****************************************************************************/
+bool CMD_HostActive(void) {
+	return host_active;
+}
+
+/****************************************************************************/
+/**
+ * Get the command interface statistics
+ *****************************************************************************/
+void CMD_GetStats(CommandStats *s) {
+	*s = stats;
+	s->bytes = rx_bytes;
+	s->overflows = rx_overflows;
+	s->uart_overruns = rx_uart_overruns;
+	s->crc_errors = decoder.crc_errors;
+}
+
+#endif /* CFG_HOST_LINK */
@@ -0,0 +1,70 @@
+/*
+ * uart_command.h
+ *
+ *  Binary command interface on the USB-UART (frame types in frame_codec.h).
+ *  A host can set HSV or RGB, change the detection mode and stream batches
+ *  of timed colors into a RAM queue that is played back on schedule.
+ *
+ *  Receive is interrupt driven.  CMD_RxIsr() empties the UART receive FIFO
+ *  into one of two buffers and hands the buffer to the main loop when it is
+ *  full, then carries on in the other one.  CMD_Poll() decodes the handed
+ *  over buffers and takes a partly filled one at the end of a burst, so at
+ *  115200 baud the main loop only has to come around once per
+ *  CMD_RX_BUFFER_SIZE bytes (~22 ms).  Bytes that arrive while both buffers
+ *  wait for the main loop are dropped and counted, never reordered.
+ *
+ *  CMD_RxIsr() runs from the UART interrupt when the UART is connected to
+ *  the interrupt controller, otherwise from FIT_Handler on every tick.
+ *  tools/cmd_send is the host side.
+ */
+
+#ifndef SRC_UART_COMMAND_H_
+#define SRC_UART_COMMAND_H_
+
+#include "hw_interface.h"
+#include "frame_codec.h"
+
+/************************** Constant Definitions ****************************/
+
+#define CMD_UART_BASEADDR		STDOUT_BASEADDRESS
+#if CFG_HOST_LINK && defined(XPAR_MICROBLAZE_0_AXI_INTC_AXI_UARTLITE_0_INTERRUPT_INTR)
+#define CMD_UART_INTERRUPT_ID	XPAR_MICROBLAZE_0_AXI_INTC_AXI_UARTLITE_0_INTERRUPT_INTR
+#endif
+
+#define CMD_RX_BUFFER_SIZE		256		// bytes per receive buffer, two of them
+#define CMD_QUEUE_SIZE			256		// color frames, must be a power of 2
+
+/**************************** Type Definitions ******************************/
+
+typedef struct {
+	u32		bytes;			// received bytes
+	u32		overflows;		// bytes dropped, both buffers full
+	u32		uart_overruns;	// UART FIFO overruns
+	u32		commands;		// good command frames
+	u32		duplicates;		// repeated commands only ACKed again
+	u32		rejected;		// commands ACKed with an error
+	u32		crc_errors;
+	u32		played;			// color frames played
+	u32		late_max;		// worst playback lateness, TS ticks
+} CommandStats;
+
+/************************** Function Prototypes *****************************/
+struct ColorControl;
+#if CFG_HOST_LINK
+int CMD_Init(void);
+void CMD_RxIsr(void *unused);
+bool CMD_Poll(struct ColorControl *ctl);
+bool CMD_Playback(u32 now, struct ColorControl *ctl);
+bool CMD_HostActive(void);
+void CMD_GetStats(CommandStats *stats);
+#else
+// Not in this build, see build_config.h
+static inline int CMD_Init(void) { return XST_SUCCESS; }
+static inline void CMD_RxIsr(void *unused) { }
+static inline bool CMD_Poll(struct ColorControl *ctl) { return false; }
+static inline bool CMD_Playback(u32 now, struct ColorControl *ctl) { return false; }
+static inline bool CMD_HostActive(void) { return false; }
+static inline void CMD_GetStats(CommandStats *stats) { *stats = (CommandStats) { 0 }; }
+#endif /* CFG_HOST_LINK */
+
+#endif /* SRC_UART_COMMAND_H_ */
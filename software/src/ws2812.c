@@ -0,0 +1,151 @@
+/*
+ * ws2812.c
+ */
+
+#include "ws2812.h"
+#include "xil_io.h"
+
+static u16 num_pixels;
+static u8 back_bank;			// bank WS_SetPixel() writes, the other one is shown
+static u32 upload_start;
+static WsStats stats;
+
+#ifdef WS2812_BASEADDR
+
+#define WS_WriteReg(offset, value)	Xil_Out32(WS2812_BASEADDR + (offset), (value))
+#define WS_ReadReg(offset)			Xil_In32(WS2812_BASEADDR + (offset))
+
+/****************************************************************************/
+/**
+ * Initialize the strip engine
+ *
+ * @param	pixels is the number of pixels on the strip, clamped to
+ * 			WS2812_MAX_PIXELS
+ *
+ * @return	XST_SUCCESS
+ *****************************************************************************/
+int WS_Init(u16 pixels) {
+	if (pixels > WS2812_MAX_PIXELS)
+		pixels = WS2812_MAX_PIXELS;
+	if (pixels == 0)
+		pixels = 1;
+	num_pixels = pixels;
+	back_bank = 0;
+	WS_WriteReg(WS2812_NUM_PIXELS_OFFSET, num_pixels);
+	return XST_SUCCESS;
+}
+
+/****************************************************************************/
+/**
+ * @return	true if the engine is in the hardware
+ *****************************************************************************/
+bool WS_Present(void) {
+	return true;
+}
+
+/****************************************************************************/
+/**
+ * @return	true while a frame is being sent
+ *****************************************************************************/
+bool WS_Busy(void) {
+	return (WS_ReadReg(WS2812_CTRL_OFFSET) & WS2812_CTRL_BUSY) != 0;
+}
+
+/****************************************************************************/
+/**
+ * Set one pixel in the back bank
+ *
+ * One AXI write per pixel, the engine reorders to GRB.
+ *****************************************************************************/
+void WS_SetPixel(u16 index, u8 R, u8 G, u8 B) {
+	u32 offset = WS2812_PIXELS_OFFSET
+			+ ((back_bank * WS2812_MAX_PIXELS + index) << 2);
+
+	WS_WriteReg(offset, ((u32) R << 16) | ((u32) G << 8) | B);
+}
+
+/****************************************************************************/
+/**
+ * Send a frame
+ *
+ * @param	new_frame is true to send the back bank (and make it the front),
+ * 			false to send the front bank again
+ *
+ * @return	true if the frame was started, false if the engine is still busy
+ *****************************************************************************/
+bool WS_Show(bool new_frame) {
+	u32 ctrl;
+
+	if (WS_Busy())
+		return false;
+
+	if (new_frame)
+		back_bank ^= 1;
+	// the front bank is the one that is not written
+	ctrl = WS2812_CTRL_START | (back_bank ? 0 : WS2812_CTRL_BANK);
+	WS_WriteReg(WS2812_CTRL_OFFSET, ctrl);
+	stats.shown++;
+	return true;
+}
+
+#else
+
+int WS_Init(u16 pixels) {
+	num_pixels = 0;
+	return XST_DEVICE_NOT_FOUND;
+}
+
+bool WS_Present(void) {
+	return false;
+}
+
+bool WS_Busy(void) {
+	return true;
+}
+
+void WS_SetPixel(u16 index, u8 R, u8 G, u8 B) {
+}
+
+bool WS_Show(bool new_frame) {
+	return false;
+}
+
+#endif /* WS2812_BASEADDR */
+
+/****************************************************************************/
+/**
+ * @return	the number of pixels on the strip
+ *****************************************************************************/
+u16 WS_NumPixels(void) {
+	return num_pixels;
+}
+
+/****************************************************************************/
+/**
+ * Bracket the WS_SetPixel() calls for a frame to time the upload
+ *****************************************************************************/
+void WS_BeginUpload(void) {
+	upload_start = TS_now();
+}
+
+void WS_EndUpload(void) {
+	u32 ticks = TS_now() - upload_start;
+
+	stats.upload_last = ticks;
+	if (ticks > stats.upload_max)
+		stats.upload_max = ticks;
+	stats.upload_sum += ticks;
+	stats.uploads++;
+}
+
+/****************************************************************************/
+/**
+ * Get the upload statistics and the engine's frame counters
+ *****************************************************************************/
+void WS_GetStats(WsStats *s) {
+	*s = stats;
+#ifdef WS2812_BASEADDR
+	s->frames = WS_ReadReg(WS2812_FRAMES_OFFSET);
+	s->frame_clks = WS_ReadReg(WS2812_FRAME_CLKS_OFFSET);
+#endif
+}
@@ -0,0 +1,69 @@
+/*
+ * ws2812.h
+ *
+ *  Driver for the WS2812 strip engine (hardware/ws2812_axi.v) on JB.
+ *  The engine has two frame buffer banks.  Pixels are written into the
+ *  back bank with WS_SetPixel() and WS_Show() starts sending it, so the
+ *  per bit timing never involves the CPU.  WS_Show() does not wait; it
+ *  returns false while the previous frame is still going out.  The back
+ *  bank is never the one being sent, so the next frame can be written
+ *  while the previous one is still going out.
+ *
+ *  The engine sits behind an AXI port exported from the block design.  The
+ *  driver compiles to stubs when the BSP has no address for it.
+ */
+
+#ifndef SRC_WS2812_H_
+#define SRC_WS2812_H_
+
+#include "hw_interface.h"
+
+/************************** Constant Definitions ****************************/
+
+#if CFG_GRAPHICS && defined(XPAR_M_AXI_WS2812_BASEADDR)
+#define WS2812_BASEADDR			XPAR_M_AXI_WS2812_BASEADDR
+#endif
+
+// Register offsets, see ws2812_axi.v
+#define WS2812_CTRL_OFFSET			0x0000
+#define WS2812_NUM_PIXELS_OFFSET	0x0004
+#define WS2812_FRAMES_OFFSET		0x0008
+#define WS2812_FRAME_CLKS_OFFSET	0x000C
+#define WS2812_PIXELS_OFFSET		0x1000
+
+#define WS2812_CTRL_START			0x01
+#define WS2812_CTRL_BANK			0x02
+#define WS2812_CTRL_BUSY			0x01	// read
+
+#define WS2812_MAX_PIXELS			512		// per bank, as built in n4fpga.v
+#ifndef WS2812_NUM_PIXELS
+#define WS2812_NUM_PIXELS			300		// pixels on the strip
+#endif
+#ifndef WS2812_FPS
+#define WS2812_FPS					60		// frames per second to aim for
+#endif
+
+/**************************** Type Definitions ******************************/
+
+typedef struct {
+	u32		shown;			// frames started by WS_Show()
+	u32		frames;			// frames the engine finished sending
+	u32		frame_clks;		// AXI clocks the last frame took on the wire
+	u32		upload_last;	// TS ticks for the last frame upload
+	u32		upload_max;		// worst upload, TS ticks
+	u32		upload_sum;		// for the average, TS ticks
+	u32		uploads;
+} WsStats;
+
+/************************** Function Prototypes *****************************/
+int WS_Init(u16 pixels);
+bool WS_Present(void);
+u16 WS_NumPixels(void);
+bool WS_Busy(void);
+void WS_BeginUpload(void);
+void WS_SetPixel(u16 index, u8 R, u8 G, u8 B);
+void WS_EndUpload(void);
+bool WS_Show(bool new_frame);
+void WS_GetStats(WsStats *stats);
+
+#endif /* SRC_WS2812_H_ */
@@ -0,0 +1,452 @@
+/*
+ * bench_sim.c
+ *
+ *  Host run of the color change latency benchmark (see
+ *  software/src/latency_bench.h).  latency_bench.c and ab_compare.c are
+ *  built as they are for the board and driven from a simulated clock:
+ *
+ *      PWM         Nexys4IO, half scale, the duty takes effect at once
+ *      software    FIT_Handler's detector, sampled every 25 us
+ *      hardware    pwm_detector at prescale 0 and ReadHwDetector(), to
+ *                  the microsecond
+ *      main loop   a pass every LOOP_US
+ *
+ *  The benchmark is run at every carrier period in pwm_carrier_us[] and
+ *  its report printed.  A run fails if a step times out, lands in the
+ *  histogram's overflow bin or is left unaccounted for, or if a detector
+ *  takes longer than the carrier allows (see max_latency_us()).  The report
+ *  is then made again with a host on the UART, and the FRAME_TYPE_LATENCY
+ *  frames it sends must carry the same results.
+ *
+ *  At every carrier the stuck detection is then timed on its own: a
+ *  running channel is turned off at STUCK_PHASES points in the carrier
+ *  period and each detector must call it 0% within SW_STUCK_PERIODS
+ *  periods of the last falling edge (plus one FIT tick for software).
+ *
+ *  Build (Linux):
+ *      cc -O2 -Wall -fcommon -Ihost -I../software/src -o bench_sim bench_sim.c \
+ *          ../software/src/latency_bench.c ../software/src/ab_compare.c \
+ *          ../software/src/duty_publish.c ../software/src/frame_codec.c
+ *
+ *  Usage:
+ *      bench_sim [-q]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "latency_bench.h"
+#include "telemetry.h"
+
+#define LOOP_US				200			// main loop pass
+#define FIT_US				25			// 40 kHz
+#define HW_CLKS_PER_US		100
+#define HW_PWM_PERIOD_MAX_US	250000	// pwm_detector PWM_PERIOD_MAX_US
+#define HW_STUCK_PERIODS	2			// pwm_detector STUCK_PERIODS
+
+#define STUCK_PHASES		8			// drop points per carrier period
+#define STUCK_CMD			128			// 25% high, reads as 50%
+
+static const u32 carriers_us[] = { 64000, 32000, 16000, 8000, 4000, 2500,
+		96000, 128000 };
+
+static u64 now_us;
+static u32 carrier_us;
+static u8 cmd[NUM_DUTY_CHANNELS];
+
+static bool host_active;
+static LatencyRecord sent[4];			// latency frames from BENCH_Report()
+static u32 nsent, bad_frames;
+
+CostStats fit_cost;
+CostStats hw_cost;
+DutyPublisher sw_duty;
+DutyPublisher hw_duty;
+
+/*
+ * What latency_bench.c and ab_compare.c need from the rest of the firmware
+ */
+u32 XTmrCtr_GetTimerCounterReg(UINTPTR base, u8 counter) {
+	return (u32) (now_us * TS_TICKS_PER_USEC);
+}
+
+u32 PWM_CarrierPeriod(void) {
+	return carrier_us;
+}
+
+bool TLM_Enabled(void) {
+	return false;
+}
+
+bool CMD_HostActive(void) {
+	return host_active;
+}
+
+bool TLM_SendFrame(u8 type, const u8 *payload, u8 len) {
+	if (type == FRAME_TYPE_LATENCY && nsent < 4
+			&& FRAME_UnpackLatency(payload, len, &sent[nsent]) == 0)
+		nsent++;
+	else
+		bad_frames++;
+	return true;
+}
+
+void TLM_Poll(void) {
+}
+
+/*
+ * Nexys4IO PWM output: high for cmd / 512 of the carrier
+ */
+static int pwm_level(u8 ch) {
+	return (now_us % carrier_us) < (u64) cmd[ch] * carrier_us / 512;
+}
+
+/*
+ * calc_duty() from functional_interface.c
+ */
+static u8 calc_duty(u32 high, u32 low) {
+	u32 sum = high + low;
+	u32 duty;
+
+	if (sum == 0)
+		return 0;
+	duty = 100 * high / sum * 2;
+	return duty > 99 ? 99 : duty;
+}
+
+/*
+ * The software detector in FIT_Handler
+ */
+static struct {
+	u32		high[NUM_DUTY_CHANNELS], low[NUM_DUTY_CHANNELS];
+	u8		old[NUM_DUTY_CHANNELS];
+	u8		duty[NUM_DUTY_CHANNELS];
+	u32		stuck_limit[NUM_DUTY_CHANNELS];
+	u32		last_period[NUM_DUTY_CHANNELS];
+	u8		saturated, resync;
+} sw;
+
+static void sw_reset(void) {
+	u8 ch;
+
+	memset(&sw, 0, sizeof(sw));
+	for (ch = 0; ch < NUM_DUTY_CHANNELS; ch++)
+		sw.stuck_limit[ch] = SW_DETECT_TIMEOUT_TICKS;
+}
+
+static void sw_fit_tick(void) {
+	bool changed = false;
+	u32 period, longer;
+	u8 ch, bit, sig, duty;
+
+	for (ch = 0; ch < NUM_DUTY_CHANNELS; ch++) {
+		bit = DUTY_SATURATED(ch);
+		sig = pwm_level(ch);
+		if (!sw.old[ch] && sig) {
+			if (sw.resync & bit) {
+				sw.resync &= ~bit;
+			} else {
+				duty = calc_duty(sw.high[ch], sw.low[ch]);
+				changed |= (duty != sw.duty[ch]) || (sw.saturated & bit);
+				sw.duty[ch] = duty;
+				sw.saturated &= ~bit;
+				period = sw.high[ch] + sw.low[ch];
+				longer = period > sw.last_period[ch] ? period : sw.last_period[ch];
+				sw.last_period[ch] = period;
+				sw.stuck_limit[ch] =
+						(longer < SW_DETECT_TIMEOUT_TICKS / SW_STUCK_PERIODS) ?
+								longer * SW_STUCK_PERIODS : SW_DETECT_TIMEOUT_TICKS;
+			}
+			sw.high[ch] = 1;
+		} else if (sw.old[ch] && !sig) {
+			sw.low[ch] = 0;
+		} else if (sig) {
+			if (++sw.high[ch] == sw.stuck_limit[ch]) {
+				changed |= (sw.duty[ch] != 99) || !(sw.saturated & bit);
+				sw.duty[ch] = 99;
+				sw.saturated |= bit;
+				sw.resync |= bit;
+				sw.stuck_limit[ch] = SW_DETECT_TIMEOUT_TICKS;
+			}
+		} else {
+			if (++sw.low[ch] == sw.stuck_limit[ch]) {
+				changed |= (sw.duty[ch] != 0) || !(sw.saturated & bit);
+				sw.duty[ch] = 0;
+				sw.saturated |= bit;
+				sw.resync |= bit;
+				sw.stuck_limit[ch] = SW_DETECT_TIMEOUT_TICKS;
+			}
+		}
+		sw.old[ch] = sig;
+	}
+	if (changed)
+		DUTY_Publish(&sw_duty, sw.duty, sw.saturated);
+}
+
+/*
+ * pwm_detector at prescale 0, HW_CLKS_PER_US clocks per step
+ */
+static struct {
+	u32		hcount[NUM_DUTY_CHANNELS], lcount[NUM_DUTY_CHANNELS];
+	u32		high_count[NUM_DUTY_CHANNELS], low_count[NUM_DUTY_CHANNELS];
+	u32		stuck_limit[NUM_DUTY_CHANNELS];
+	u8		prev[NUM_DUTY_CHANNELS], stuck[NUM_DUTY_CHANNELS];
+	u8		resync[NUM_DUTY_CHANNELS];
+	u8		limit_valid[NUM_DUTY_CHANNELS];
+	u32		last_period[NUM_DUTY_CHANNELS];
+	u32		last_high[NUM_DUTY_CHANNELS], last_low[NUM_DUTY_CHANNELS];
+} hw;
+
+static void hw_reset(void) {
+	memset(&hw, 0, sizeof(hw));
+}
+
+static void hw_step(void) {
+	const u32 timeout = HW_PWM_PERIOD_MAX_US * HW_CLKS_PER_US - 1;
+	u32 limit, period, longer;
+	u8 ch, sig;
+
+	for (ch = 0; ch < NUM_DUTY_CHANNELS; ch++) {
+		sig = pwm_level(ch);
+		limit = hw.limit_valid[ch] ? hw.stuck_limit[ch] : timeout;
+		if (hw.prev[ch] && sig) {
+			hw.hcount[ch] += HW_CLKS_PER_US;
+			if (!hw.stuck[ch] && hw.hcount[ch] >= limit) {
+				hw.high_count[ch] = hw.hcount[ch];
+				hw.low_count[ch] = 0;
+				hw.stuck[ch] = 1;
+				hw.resync[ch] = 1;
+				hw.limit_valid[ch] = 0;
+			}
+		} else if (!hw.prev[ch] && !sig) {
+			hw.lcount[ch] += HW_CLKS_PER_US;
+			if (!hw.stuck[ch] && hw.lcount[ch] >= limit) {
+				hw.low_count[ch] = hw.lcount[ch];
+				hw.high_count[ch] = 0;
+				hw.stuck[ch] = 1;
+				hw.resync[ch] = 1;
+				hw.limit_valid[ch] = 0;
+			}
+		} else if (sig) {
+			if (hw.resync[ch]) {
+				hw.resync[ch] = 0;
+			} else {
+				hw.high_count[ch] = hw.hcount[ch];
+				hw.low_count[ch] = hw.lcount[ch];
+				period = hw.hcount[ch] + hw.lcount[ch];
+				longer = period > hw.last_period[ch] ? period : hw.last_period[ch];
+				hw.last_period[ch] = period;
+				hw.stuck_limit[ch] = longer * HW_STUCK_PERIODS > timeout ?
+						timeout : longer * HW_STUCK_PERIODS;
+				hw.limit_valid[ch] = 1;
+			}
+			hw.hcount[ch] = HW_CLKS_PER_US;
+			hw.stuck[ch] = 0;
+		} else {
+			hw.lcount[ch] = HW_CLKS_PER_US;
+			hw.stuck[ch] = 0;
+		}
+		hw.prev[ch] = sig;
+	}
+}
+
+/*
+ * ReadHwDetector() from functional_interface.c
+ */
+static void hw_read(void) {
+	u8 duty[NUM_DUTY_CHANNELS];
+	u8 saturated = 0;
+	bool changed = false;
+	u8 ch;
+
+	for (ch = 0; ch < NUM_DUTY_CHANNELS; ch++) {
+		changed |= (hw.high_count[ch] != hw.last_high[ch])
+				|| (hw.low_count[ch] != hw.last_low[ch]);
+		hw.last_high[ch] = hw.high_count[ch];
+		hw.last_low[ch] = hw.low_count[ch];
+		duty[ch] = calc_duty(hw.high_count[ch], hw.low_count[ch]);
+		if ((hw.high_count[ch] == 0) != (hw.low_count[ch] == 0))
+			saturated |= DUTY_SATURATED(ch);
+	}
+	if (changed)
+		DUTY_Publish(&hw_duty, duty, saturated);
+}
+
+/*
+ * Longest a detector may take to settle after a step.  A measured duty
+ * needs the period the command lands in and one whole period after it,
+ * plus one more when it leaves a constant level (the first rising edge
+ * only restarts the measurement).  A constant level is called after the
+ * STUCK_PERIODS timeout of the previous period.
+ */
+static u32 max_latency_us(void) {
+	return 3 * carrier_us + 2 * LOOP_US;
+}
+
+/*
+ * A latency frame against the results it was sent for
+ */
+static int frame_matches(const LatencyRecord *rec, u8 source, u8 det,
+		const LatencyStats *st) {
+	return rec->source == source && rec->detector == det
+			&& rec->count == st->count && rec->unchanged == st->unchanged
+			&& rec->timeouts == st->timeouts && rec->min_us == st->min
+			&& rec->avg_us == (st->count ? (u32) (st->sum / st->count) : 0)
+			&& rec->max_us == st->max;
+}
+
+static int run(u32 carrier, int quiet) {
+	static const char *name[2] = { "SW", "HW" };
+	const u32 steps = bench_default_nsteps * BENCH_REPEATS;
+	DutySnapshot sw_snap, hw_snap;
+	LatencyStats all, sat;
+	u64 end_us;
+	int failures = 0;
+	u8 det;
+
+	carrier_us = carrier;
+	now_us = 0;
+	memset(cmd, 0, sizeof(cmd));
+	memset(&sw_duty, 0, sizeof(sw_duty));
+	memset(&hw_duty, 0, sizeof(hw_duty));
+	sw_reset();
+	hw_reset();
+
+	// Let both detectors see the LEDs off before the run starts
+	end_us = 4 * (u64) carrier_us + 500000;
+	BENCH_Start(bench_default_steps, bench_default_nsteps, BENCH_REPEATS);
+	for (;;) {
+		hw_step();
+		if (now_us % FIT_US == 0)
+			sw_fit_tick();
+		if (now_us % LOOP_US == 0) {
+			hw_read();
+			DUTY_Read(&sw_duty, &sw_snap);
+			DUTY_Read(&hw_duty, &hw_snap);
+			if (now_us >= end_us) {
+				if (!BENCH_Running())
+					break;
+				if (BENCH_Update((u32) (now_us * TS_TICKS_PER_USEC),
+						sw_snap.duty, hw_snap.duty, cmd))
+					BENCH_Commanded((u32) (now_us * TS_TICKS_PER_USEC),
+							sw_snap.duty, hw_snap.duty);
+			}
+		}
+		now_us++;
+	}
+
+	if (!quiet) {
+		BENCH_Report();
+		printf("\n");
+	}
+	for (det = BENCH_SW; det <= BENCH_HW; det++) {
+		BENCH_GetStats(det, &all, &sat);
+		if (all.timeouts != 0 || all.hist[BENCH_HIST_BINS] != 0
+				|| all.count + all.unchanged + all.timeouts != steps
+				|| all.max > max_latency_us()) {
+			printf("FAIL carrier %u us %s: %u timed, %u unchanged, %u timed out, "
+					"%u longer than the histogram, max %u us (limit %u us)\n",
+					carrier, name[det], all.count, all.unchanged, all.timeouts,
+					all.hist[BENCH_HIST_BINS], all.max, max_latency_us());
+			failures++;
+		}
+	}
+
+	// With a host on the UART the same results go out as frames
+	host_active = true;
+	nsent = bad_frames = 0;
+	BENCH_Report();
+	host_active = false;
+	for (det = BENCH_SW; det <= BENCH_HW; det++) {
+		BENCH_GetStats(det, &all, &sat);
+		if (nsent != 4 || bad_frames != 0
+				|| !frame_matches(&sent[2 * det], LATENCY_SOURCE_BENCH, det, &all)
+				|| !frame_matches(&sent[2 * det + 1], LATENCY_SOURCE_BENCH_SAT,
+						det, &sat)) {
+			printf("FAIL carrier %u us %s: %u latency frames, %u others, "
+					"results differ from the report\n", carrier, name[det],
+					nsent, bad_frames);
+			failures++;
+		}
+	}
+	return failures;
+}
+
+/*
+ * Time from the last falling edge to the channel being called stuck low,
+ * turning red off at phase / STUCK_PHASES of a carrier period
+ */
+static int stuck_run(u32 carrier, int quiet) {
+	const u32 high_us = STUCK_CMD * carrier / 512;
+	u32 sw_limit = SW_STUCK_PERIODS * carrier + FIT_US;
+	u32 hw_limit = HW_STUCK_PERIODS * carrier + 1;
+	u32 sw_max = 0, hw_max = 0;
+	u64 off_us, fall_us, sw_us, hw_us;
+	int failures = 0;
+	u32 phase;
+
+	carrier_us = carrier;
+	for (phase = 0; phase < STUCK_PHASES; phase++) {
+		now_us = 0;
+		memset(cmd, STUCK_CMD, sizeof(cmd));
+		memset(&sw_duty, 0, sizeof(sw_duty));
+		sw_reset();
+		hw_reset();
+
+		off_us = 4 * (u64) carrier + phase * carrier / STUCK_PHASES;
+		// The last falling edge, or the drop itself if it cuts a high
+		fall_us = off_us - off_us % carrier + high_us;
+		if (fall_us > off_us)
+			fall_us = off_us;
+		sw_us = hw_us = 0;
+		for (; now_us < off_us + 4 * (u64) carrier && (!sw_us || !hw_us); now_us++) {
+			if (now_us == off_us)
+				cmd[0] = 0;
+			hw_step();
+			if (now_us % FIT_US == 0)
+				sw_fit_tick();
+			if (now_us < off_us) {
+				// Nothing may be called stuck while the PWM runs.  The first
+				// edge after reset ends no period, allow two to start up.
+				if (now_us >= 2 * (u64) carrier && (sw.saturated || hw.stuck[0] || hw.stuck[1] || hw.stuck[2])) {
+					printf("FAIL carrier %u us phase %u/%u: stuck at %llu us "
+							"with the PWM running\n", carrier, phase, STUCK_PHASES,
+							(unsigned long long) now_us);
+					return failures + 1;
+				}
+				continue;
+			}
+			if (!sw_us && (sw.saturated & DUTY_SATURATED(0)) && sw.duty[0] == 0)
+				sw_us = now_us;
+			if (!hw_us && hw.stuck[0] && hw.high_count[0] == 0)
+				hw_us = now_us;
+		}
+		if (!sw_us || sw_us - fall_us > sw_limit || !hw_us || hw_us - fall_us > hw_limit) {
+			printf("FAIL carrier %u us phase %u/%u: stuck low after SW %lld us "
+					"(limit %u), HW %lld us (limit %u)\n", carrier, phase,
+					STUCK_PHASES, sw_us ? (long long) (sw_us - fall_us) : -1LL,
+					sw_limit, hw_us ? (long long) (hw_us - fall_us) : -1LL, hw_limit);
+			failures++;
+			continue;
+		}
+		if (sw_us - fall_us > sw_max)
+			sw_max = sw_us - fall_us;
+		if (hw_us - fall_us > hw_max)
+			hw_max = hw_us - fall_us;
+	}
+	if (!quiet)
+		printf("Stuck low, carrier %u us: SW max %u us, HW max %u us after the "
+				"last edge\n\n", carrier, sw_max, hw_max);
+	return failures;
+}
+
+int main(int argc, char **argv) {
+	int quiet = (argc == 2 && !strcmp(argv[1], "-q"));
+	int failures = 0;
+	u32 i;
+
+	for (i = 0; i < sizeof(carriers_us) / sizeof(carriers_us[0]); i++)
+		failures += run(carriers_us[i], quiet) + stuck_run(carriers_us[i], quiet);
+	printf("%s\n", failures ? "FAIL" : "pass");
+	return failures != 0;
+}
@@ -0,0 +1,197 @@
+/*
+ * cmd_rx_stress.c
+ *
+ *  Host test for the command receive path (see software/src/uart_command.h).
+ *  uart_command.c is built as it is for the board and fed a stream of
+ *  SET_RGB commands through a stand-in UART.  Each command carries its
+ *  number in R, G and B, so SetRGBled() sees whether they are carried out
+ *  in order.  CMD_RxIsr() is called after every burst of bytes and
+ *  CMD_Poll() as often as each run says:
+ *
+ *      steady      a poll after every burst, nothing may be dropped
+ *      slow        a poll after one burst in 8, both buffers fill up and
+ *                  bytes are dropped, what is carried out must stay in order
+ *      tail        more than one buffer of commands with no poll, then
+ *                  polls only; the partly filled buffer must not be held
+ *                  back waiting for another byte
+ *
+ *  Exits non-zero if a command is carried out out of order or a run loses
+ *  commands it should not.
+ *
+ *  Build (Linux):
+ *      cc -O2 -Wall -fcommon -Ihost -I../software/src -o cmd_rx_stress cmd_rx_stress.c \
+ *          ../software/src/uart_command.c ../software/src/frame_codec.c
+ *
+ *  Usage:
+ *      cmd_rx_stress [-n commands_per_run]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "functional_interface.h"
+#include "xuartlite_l.h"
+
+#define MAX_COMMANDS		200000
+#define CMD_FRAME_SIZE		(FRAME_OVERHEAD + 4)	// SET_RGB: seq, R, G, B
+
+static u8 stream[MAX_COMMANDS * CMD_FRAME_SIZE];
+static u32 stream_len, stream_pos, burst_end;
+
+static u32 executed;				// SetRGBled() calls this run
+static s32 last_number;
+static u32 reordered;
+
+static u32 rng_state = 0x2468ace1;
+
+static u32 rng(void) {
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+	return rng_state;
+}
+
+/*
+ * What uart_command.c needs from the UART and the rest of the firmware
+ */
+u32 XUartLite_GetStatusReg(UINTPTR base) {
+	return stream_pos < burst_end ? XUL_SR_RX_FIFO_VALID_DATA : 0;
+}
+
+u32 XUartLite_ReadReg(UINTPTR base, u32 offset) {
+	return stream[stream_pos++];
+}
+
+u32 XTmrCtr_GetTimerCounterReg(UINTPTR base, u8 counter) {
+	return 0;
+}
+
+bool TLM_SendFrame(u8 type, const u8 *payload, u8 len) {
+	return true;
+}
+
+void SetRGBled(u8 R, u8 G, u8 B) {
+	s32 number = ((s32) R << 16) | (G << 8) | B;
+
+	if (number <= last_number && reordered++ < 10)
+		printf("  command %d carried out after %d\n", number, last_number);
+	last_number = number;
+	executed++;
+}
+
+/*
+ * Queue commands first .. first + n - 1 on the stand-in UART
+ */
+static void make_stream(u32 first, u32 n) {
+	u8 payload[4];
+	u32 i, number;
+
+	stream_len = stream_pos = burst_end = 0;
+	for (i = 0; i < n; i++) {
+		number = first + i;
+		payload[0] = number;				// seq
+		payload[1] = number >> 16;
+		payload[2] = number >> 8;
+		payload[3] = number;
+		stream_len += FRAME_Encode(FRAME_TYPE_SET_RGB, payload, 4,
+				&stream[stream_len]);
+	}
+}
+
+static void burst(u32 bytes) {
+	burst_end = stream_pos + bytes;
+	if (burst_end > stream_len)
+		burst_end = stream_len;
+	CMD_RxIsr(NULL);
+}
+
+// Main loop passes with nothing arriving
+static void drain(ColorControl *ctl) {
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		CMD_RxIsr(NULL);
+		CMD_Poll(ctl);
+	}
+}
+
+static void start_run(void) {
+	executed = 0;
+	last_number = -1;
+	reordered = 0;
+}
+
+static int finish_run(const char *name, u32 commands, u32 overflows_before,
+		int must_drop) {
+	CommandStats st;
+	u32 overflows;
+	int fail;
+
+	CMD_GetStats(&st);
+	overflows = st.overflows - overflows_before;
+	fail = reordered != 0 || (must_drop ? overflows == 0 || executed == 0
+			: overflows != 0 || executed != commands);
+	printf("  %-8s %7u commands %7u carried out %8u bytes dropped %3u out of order  %s\n",
+			name, commands, executed, overflows, reordered, fail ? "FAIL" : "ok");
+	return fail;
+}
+
+int main(int argc, char **argv) {
+	ColorControl ctl;
+	CommandStats st;
+	u32 n = 50000;
+	u32 first = 0;
+	int failures = 0;
+
+	if (argc == 3 && !strcmp(argv[1], "-n"))
+		n = strtoul(argv[2], NULL, 0);
+	if (n > MAX_COMMANDS)
+		n = MAX_COMMANDS;
+
+	memset(&ctl, 0, sizeof(ctl));
+	CMD_Init();
+	printf("command receive, %u byte buffers\n", CMD_RX_BUFFER_SIZE);
+
+	// A poll after every burst
+	start_run();
+	make_stream(first, n);
+	CMD_GetStats(&st);
+	while (stream_pos < stream_len) {
+		burst(1 + rng() % 64);
+		CMD_Poll(&ctl);
+	}
+	drain(&ctl);
+	failures += finish_run("steady", n, st.overflows, 0);
+	first += n;
+
+	// A poll after one burst in 8, both buffers fill and bytes are dropped
+	start_run();
+	make_stream(first, n);
+	CMD_GetStats(&st);
+	while (stream_pos < stream_len) {
+		burst(1 + rng() % 200);
+		if (rng() % 8 == 0)
+			CMD_Poll(&ctl);
+	}
+	drain(&ctl);
+	failures += finish_run("slow", n, st.overflows, 1);
+	first += n;
+	// Line up the decoder and the duplicate check again
+	make_stream(first, 4);
+	burst(stream_len);
+	drain(&ctl);
+	first += 4;
+
+	// A full buffer and a partly filled one before main comes around
+	start_run();
+	n = (CMD_RX_BUFFER_SIZE * 3 / 2) / CMD_FRAME_SIZE;
+	make_stream(first, n);
+	CMD_GetStats(&st);
+	burst(CMD_RX_BUFFER_SIZE);
+	burst(stream_len);
+	drain(&ctl);
+	failures += finish_run("tail", n, st.overflows, 0);
+
+	printf("%s\n", failures ? "FAIL" : "pass");
+	return failures != 0;
+}
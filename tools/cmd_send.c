@@ -0,0 +1,580 @@
+/*
+ * cmd_send.c
+ *
+ *  Host side of the UART command interface (see software/src/uart_command.h).
+ *  Sets HSV, RGB or the detection mode, or streams a CSV file of timed
+ *  colors into the board's playback queue.
+ *
+ *  Every command waits for its ACK and is sent again with the same sequence
+ *  number if none comes back, so a lost ACK does not queue a batch twice.
+ *  Streaming keeps the queue topped up from the free count in the ACKs and
+ *  polls with PLAY when the queue has no room.
+ *
+ *  --loopback runs the same code against a stand-in for the board that
+ *  uses the real frame codec, takes UART time into account at the chosen
+ *  baud rate and corrupts some of the frames in both directions.
+ *
+ *  Build (Linux):
+ *      cc -O2 -Wall -I../software/src -o cmd_send cmd_send.c ../software/src/frame_codec.c
+ *
+ *  Usage:
+ *      cmd_send [-d /dev/ttyUSB1] [-b 115200] hsv <hue> <sat> <val>
+ *      cmd_send [-d /dev/ttyUSB1] [-b 115200] rgb <R> <G> <B>
+ *      cmd_send [-d /dev/ttyUSB1] [-b 115200] mode [hw] [ab]
+ *      cmd_send [-d /dev/ttyUSB1] [-b 115200] play <colors.csv> [--loop]
+ *      cmd_send [-d /dev/ttyUSB1] [-b 115200] stop
+ *      cmd_send --loopback [-b 115200] [-n frames]
+ *
+ *  colors.csv has one "hue,sat,val,hold_ms" line per color.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/select.h>
+#include <sys/time.h>
+#include "frame_codec.h"
+
+#define ACK_TIMEOUT_MS		100
+#define MAX_RETRIES			5
+#define BOARD_QUEUE_SIZE	256		// CMD_QUEUE_SIZE in uart_command.h
+#define MAX_COLORS			65536
+
+/*
+ * Stand-in for the board: the command handling of uart_command.c on a
+ * simulated clock.  Every 53rd frame to the board and every 41st ACK has a
+ * bit flipped.
+ */
+typedef struct {
+	FrameDecoder	dec;
+	ColorFrame		queue[BOARD_QUEUE_SIZE];
+	uint16_t		head, tail;
+	int				playing, looping;
+	int				dry;				// a color was due with the queue empty
+	int				have_seq;
+	uint8_t			last_seq;
+	uint64_t		next_frame;			// us
+	uint8_t			out[4 * FRAME_MAX_SIZE];	// ACKs on their way to the host
+	int				out_len;
+	uint64_t		out_time;			// when out has been sent
+
+	uint32_t		frames_in, frames_out;
+	uint32_t		played, ran_dry, duplicates;
+	uint32_t		gap_max;			// longest wait for a late color, us
+} Board;
+
+typedef struct {
+	int				fd;
+	Board			*board;				// loopback when not NULL
+	int				baud;
+	uint64_t		now;				// simulated time, us
+	FrameDecoder	dec;
+	uint8_t			seq;
+
+	uint32_t		commands, retries, failed;
+	uint32_t		ack_time_max;		// us
+	uint64_t		ack_time_sum;
+} Link;
+
+static uint16_t queue_count(const Board *b) {
+	return (uint16_t) (b->head - b->tail) & (BOARD_QUEUE_SIZE - 1);
+}
+
+static uint16_t queue_free(const Board *b) {
+	return BOARD_QUEUE_SIZE - 1 - queue_count(b);
+}
+
+static uint64_t wire_time(const Link *l, int bytes) {
+	return (uint64_t) bytes * 10 * 1000000 / l->baud;
+}
+
+/*
+ * Play the queued colors that are due by time now.  The queue only changes
+ * when a command arrives, so each color is played at its due time unless
+ * the queue was empty then.
+ */
+static void board_run(Board *b, uint64_t now) {
+	ColorFrame *f;
+
+	while (b->playing && b->next_frame <= now) {
+		if (b->head == b->tail) {
+			if (!b->dry)
+				b->ran_dry++;
+			b->dry = 1;
+			return;
+		}
+		f = &b->queue[b->tail];
+		b->next_frame += f->hold_ms * 1000ULL;
+		if (b->looping) {
+			b->queue[b->head] = *f;
+			b->head = (b->head + 1) & (BOARD_QUEUE_SIZE - 1);
+		}
+		b->tail = (b->tail + 1) & (BOARD_QUEUE_SIZE - 1);
+		b->played++;
+	}
+}
+
+static void board_ack(Link *l, Board *b, uint8_t seq, uint8_t type,
+		uint8_t status) {
+	uint8_t payload[CMD_ACK_SIZE];
+	CommandAck ack;
+	uint16_t len;
+
+	ack.seq = seq;
+	ack.type = type;
+	ack.status = status;
+	ack.queued = queue_count(b);
+	ack.free = queue_free(b);
+	FRAME_PackAck(&ack, payload);
+	len = FRAME_Encode(FRAME_TYPE_ACK, payload, CMD_ACK_SIZE,
+			&b->out[b->out_len]);
+	if (++b->frames_out % 41 == 0)
+		b->out[b->out_len + 4 + rand() % CMD_ACK_SIZE] ^= 1 << (rand() % 8);
+	b->out_len += len;
+	b->out_time = l->now + wire_time(l, b->out_len);
+}
+
+static void board_execute(Link *l, Board *b) {
+	ColorFrame frames[CMD_MAX_BATCH];
+	const uint8_t *p = b->dec.payload;
+	uint8_t status = CMD_STATUS_OK;
+	int count, i;
+
+	if (b->dec.len == 0) {
+		board_ack(l, b, 0, b->dec.type, CMD_STATUS_BAD_LENGTH);
+		return;
+	}
+	if (b->have_seq && p[0] == b->last_seq) {
+		b->duplicates++;
+		board_ack(l, b, p[0], b->dec.type, CMD_STATUS_OK);
+		return;
+	}
+	switch (b->dec.type) {
+	case FRAME_TYPE_SET_HSV:
+	case FRAME_TYPE_SET_RGB:
+	case FRAME_TYPE_SET_MODE:
+		break;
+	case FRAME_TYPE_QUEUE:
+		count = FRAME_UnpackColorFrames(p, b->dec.len, frames);
+		if (count < 0)
+			status = CMD_STATUS_BAD_LENGTH;
+		else if (count > queue_free(b))
+			status = CMD_STATUS_QUEUE_FULL;
+		else
+			for (i = 0; i < count; i++) {
+				b->queue[b->head] = frames[i];
+				b->head = (b->head + 1) & (BOARD_QUEUE_SIZE - 1);
+			}
+		break;
+	case FRAME_TYPE_PLAY:
+		b->looping = p[1] != 0;
+		if (!b->playing) {
+			b->playing = 1;
+			b->next_frame = l->now;
+		}
+		break;
+	case FRAME_TYPE_STOP:
+		b->playing = 0;
+		b->tail = b->head;
+		break;
+	default:
+		status = CMD_STATUS_UNKNOWN;
+		break;
+	}
+	if (status == CMD_STATUS_OK) {
+		b->have_seq = 1;
+		b->last_seq = p[0];
+	}
+	board_ack(l, b, p[0], b->dec.type, status);
+}
+
+static void board_receive(Link *l, Board *b, uint8_t *frame, int len) {
+	int i;
+
+	if (++b->frames_in % 53 == 0)
+		frame[4 + rand() % (len - FRAME_OVERHEAD)] ^= 1 << (rand() % 8);
+	l->now += wire_time(l, len);
+	board_run(b, l->now);
+	for (i = 0; i < len; i++)
+		if (FRAME_DecodeByte(&b->dec, frame[i]))
+			board_execute(l, b);
+
+	// Like the firmware, carry on from when the late colors arrived
+	if (b->dry && b->head != b->tail) {
+		if (l->now - b->next_frame > b->gap_max)
+			b->gap_max = l->now - b->next_frame;
+		b->next_frame = l->now;
+		b->dry = 0;
+	}
+}
+
+static void link_send(Link *l, uint8_t type, const uint8_t *payload,
+		uint8_t len) {
+	uint8_t frame[FRAME_MAX_SIZE];
+	uint16_t size;
+
+	size = FRAME_Encode(type, payload, len, frame);
+	if (l->board)
+		board_receive(l, l->board, frame, size);
+	else if (write(l->fd, frame, size) != size)
+		perror("write");
+}
+
+/*
+ * Wait up to timeout_ms for the ACK to seq.  Telemetry and text in between
+ * are skipped.
+ *
+ * @return	1 with the ACK in ack, 0 on a timeout
+ */
+static int link_wait_ack(Link *l, uint8_t seq, int timeout_ms,
+		CommandAck *ack) {
+	struct timeval tv;
+	fd_set fds;
+	uint8_t buf[256];
+	uint64_t deadline;
+	ssize_t n;
+	int i, found = 0;
+
+	if (l->board) {
+		Board *b = l->board;
+
+		deadline = l->now + timeout_ms * 1000ULL;
+		if (b->out_len == 0 || b->out_time > deadline) {
+			l->now = deadline;
+			board_run(b, l->now);
+			return 0;
+		}
+		if (b->out_time > l->now)
+			l->now = b->out_time;
+		board_run(b, l->now);
+		for (i = 0; i < b->out_len && !found; i++)
+			if (FRAME_DecodeByte(&l->dec, b->out[i])
+					&& l->dec.type == FRAME_TYPE_ACK
+					&& FRAME_UnpackAck(l->dec.payload, l->dec.len, ack) == 0
+					&& ack->seq == seq)
+				found = 1;
+		b->out_len = 0;
+		if (!found) {
+			l->now = deadline;
+			board_run(b, l->now);
+		}
+		return found;
+	}
+
+	for (;;) {
+		FD_ZERO(&fds);
+		FD_SET(l->fd, &fds);
+		tv.tv_sec = timeout_ms / 1000;
+		tv.tv_usec = (timeout_ms % 1000) * 1000;
+		if (select(l->fd + 1, &fds, NULL, NULL, &tv) <= 0)
+			return 0;
+		n = read(l->fd, buf, sizeof(buf));
+		if (n <= 0)
+			return 0;
+		for (i = 0; i < n; i++)
+			if (FRAME_DecodeByte(&l->dec, buf[i])
+					&& l->dec.type == FRAME_TYPE_ACK
+					&& FRAME_UnpackAck(l->dec.payload, l->dec.len, ack) == 0
+					&& ack->seq == seq)
+				return 1;
+	}
+}
+
+static uint64_t link_time(const Link *l) {
+	struct timeval tv;
+
+	if (l->board)
+		return l->now;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1000000ULL + tv.tv_usec;
+}
+
+static void link_sleep(Link *l, uint32_t ms) {
+	if (l->board) {
+		l->now += ms * 1000ULL;
+		board_run(l->board, l->now);
+	} else {
+		usleep(ms * 1000);
+	}
+}
+
+/*
+ * Send a command until it is ACKed.  payload[0] is filled in with the
+ * sequence number.
+ *
+ * @return	1 with the ACK in ack, 0 if the board never answered
+ */
+static int command(Link *l, uint8_t type, uint8_t *payload, uint8_t len,
+		CommandAck *ack) {
+	uint64_t start = link_time(l);
+	uint32_t took;
+	int attempt;
+
+	payload[0] = ++l->seq;
+	l->commands++;
+	for (attempt = 0; attempt <= MAX_RETRIES; attempt++) {
+		if (attempt)
+			l->retries++;
+		link_send(l, type, payload, len);
+		if (link_wait_ack(l, payload[0], ACK_TIMEOUT_MS, ack)) {
+			took = (uint32_t) (link_time(l) - start);
+			l->ack_time_sum += took;
+			if (took > l->ack_time_max)
+				l->ack_time_max = took;
+			if (ack->status != CMD_STATUS_OK)
+				fprintf(stderr, "command 0x%02x rejected, status %u\n", type,
+						ack->status);
+			return 1;
+		}
+	}
+	l->failed++;
+	fprintf(stderr, "no ACK for command 0x%02x\n", type);
+	return 0;
+}
+
+/*
+ * Stream colors into the playback queue and start playing once the first
+ * fill is in.  With loop the board keeps playing the queue, so everything
+ * has to fit in it.
+ *
+ * @return	0 on success
+ */
+static int stream(Link *l, const ColorFrame *colors, uint32_t ncolors,
+		int loop) {
+	uint8_t payload[FRAME_MAX_PAYLOAD];
+	uint8_t play[2];
+	CommandAck ack;
+	uint32_t sent = 0, polls = 0;
+	uint16_t free = BOARD_QUEUE_SIZE - 1;
+	uint8_t n, len;
+	int playing = 0;
+
+	if (loop && ncolors > BOARD_QUEUE_SIZE - 1) {
+		fprintf(stderr, "--loop needs at most %d colors\n",
+				BOARD_QUEUE_SIZE - 1);
+		return 1;
+	}
+
+	while (sent < ncolors) {
+		n = ncolors - sent > CMD_MAX_BATCH ? CMD_MAX_BATCH : ncolors - sent;
+		if (n > free) {
+			if (!playing) {
+				n = free;			// the first fill may end on a short batch
+			} else {
+				// Wait until about a batch has been played, then ask for the
+				// queue state
+				link_sleep(l, (n - free) * colors[sent].hold_ms + 1);
+				play[1] = loop;
+				if (!command(l, FRAME_TYPE_PLAY, play, sizeof(play), &ack))
+					return 1;
+				free = ack.free;
+				polls++;
+				continue;
+			}
+		}
+		if (n > 0) {
+			len = FRAME_PackColorFrames(0, &colors[sent], n, payload);
+			if (!command(l, FRAME_TYPE_QUEUE, payload, len, &ack))
+				return 1;
+			free = ack.free;
+			if (ack.status == CMD_STATUS_QUEUE_FULL)
+				continue;
+			if (ack.status != CMD_STATUS_OK)
+				return 1;
+			sent += n;
+		}
+		if (!playing && (free < CMD_MAX_BATCH || sent == ncolors)) {
+			play[1] = loop;
+			if (!command(l, FRAME_TYPE_PLAY, play, sizeof(play), &ack))
+				return 1;
+			playing = 1;
+		}
+	}
+	printf("%u colors streamed, %u status polls\n", sent, polls);
+	return 0;
+}
+
+static uint32_t read_csv(const char *name, ColorFrame *colors) {
+	FILE *f = fopen(name, "r");
+	unsigned hue, sat, val, hold;
+	char line[128];
+	uint32_t n = 0;
+
+	if (!f) {
+		perror(name);
+		return 0;
+	}
+	while (n < MAX_COLORS && fgets(line, sizeof(line), f))
+		if (sscanf(line, "%u,%u,%u,%u", &hue, &sat, &val, &hold) == 4
+				&& hue <= 360 && sat <= 100 && val <= 100 && hold <= 0xFFFF) {
+			colors[n].hue = hue;
+			colors[n].sat = sat;
+			colors[n].val = val;
+			colors[n].hold_ms = hold;
+			n++;
+		}
+	fclose(f);
+	return n;
+}
+
+/*
+ * Stream a hue sweep of ncolors 20 ms colors through the board stand-in
+ * and wait for it to finish playing
+ */
+static int loopback(Link *l, uint32_t ncolors) {
+	static ColorFrame colors[MAX_COLORS];
+	Board *b = l->board;
+	uint8_t payload[2];
+	CommandAck ack;
+	uint64_t start;
+	uint32_t i, ran_dry;
+
+	for (i = 0; i < ncolors; i++) {
+		colors[i].hue = (i * 7) % 361;
+		colors[i].sat = 100;
+		colors[i].val = 20 + i % 80;
+		colors[i].hold_ms = 20;
+	}
+	srand(544);
+	start = l->now;
+	if (stream(l, colors, ncolors, 0))
+		return 1;
+	while (b->played < ncolors)
+		link_sleep(l, 1);
+	ran_dry = b->ran_dry;
+	command(l, FRAME_TYPE_STOP, payload, 1, &ack);
+
+	printf("loopback at %d baud: %u colors played in %.2f s "
+			"(%.2f s of holds)\n", l->baud, b->played,
+			(l->now - start) / 1e6, ncolors * 0.020);
+	printf("queue ran dry %u times, longest gap %u us\n", ran_dry,
+			b->gap_max);
+	printf("board: %u frames in, %u repeats only ACKed, %u crc errors\n",
+			b->frames_in, b->duplicates, b->dec.crc_errors);
+	return ran_dry != 0;
+}
+
+static int open_serial(const char *dev, int baud) {
+	struct termios tio;
+	speed_t speed;
+	int fd;
+
+	fd = open(dev, O_RDWR | O_NOCTTY);
+	if (fd < 0) {
+		perror(dev);
+		return -1;
+	}
+	if (!isatty(fd))
+		return fd;
+
+	switch (baud) {
+	case 9600:		speed = B9600;		break;
+	case 57600:		speed = B57600;		break;
+	case 230400:	speed = B230400;	break;
+	case 115200:
+	default:		speed = B115200;	break;
+	}
+	tcgetattr(fd, &tio);
+	cfmakeraw(&tio);
+	cfsetispeed(&tio, speed);
+	cfsetospeed(&tio, speed);
+	tio.c_cc[VMIN] = 1;
+	tio.c_cc[VTIME] = 0;
+	tcsetattr(fd, TCSANOW, &tio);
+	return fd;
+}
+
+static void usage(const char *prog) {
+	fprintf(stderr,
+			"usage: %s [-d device] [-b baud] hsv <hue> <sat> <val>\n"
+			"       %s [-d device] [-b baud] rgb <R> <G> <B>\n"
+			"       %s [-d device] [-b baud] mode [hw] [ab]\n"
+			"       %s [-d device] [-b baud] play <colors.csv> [--loop]\n"
+			"       %s [-d device] [-b baud] stop\n"
+			"       %s --loopback [-b baud] [-n colors]\n",
+			prog, prog, prog, prog, prog, prog);
+	exit(2);
+}
+
+int main(int argc, char **argv) {
+	static ColorFrame colors[MAX_COLORS];
+	const char *dev = "/dev/ttyUSB1";
+	uint32_t ncolors = 2000;
+	int use_loopback = 0;
+	uint8_t payload[FRAME_MAX_PAYLOAD];
+	CommandAck ack;
+	Board board;
+	Link l;
+	int i, j, ok = 1;
+
+	memset(&l, 0, sizeof(l));
+	l.baud = 115200;
+	FRAME_DecoderInit(&l.dec);
+
+	for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+		if (!strcmp(argv[i], "--loopback"))
+			use_loopback = 1;
+		else if (i + 1 >= argc)
+			usage(argv[0]);
+		else if (!strcmp(argv[i], "-d"))
+			dev = argv[++i];
+		else if (!strcmp(argv[i], "-b"))
+			l.baud = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-n"))
+			ncolors = strtoul(argv[++i], NULL, 0);
+		else
+			usage(argv[0]);
+	}
+
+	if (use_loopback) {
+		memset(&board, 0, sizeof(board));
+		FRAME_DecoderInit(&board.dec);
+		l.board = &board;
+		if (ncolors == 0 || ncolors > MAX_COLORS)
+			usage(argv[0]);
+		ok = !loopback(&l, ncolors);
+	} else {
+		if (i >= argc)
+			usage(argv[0]);
+		l.fd = open_serial(dev, l.baud);
+		if (l.fd < 0)
+			return 1;
+
+		if (!strcmp(argv[i], "hsv") && i + 3 < argc) {
+			FRAME_PutU16(&payload[1], atoi(argv[i + 1]));
+			payload[3] = atoi(argv[i + 2]);
+			payload[4] = atoi(argv[i + 3]);
+			ok = command(&l, FRAME_TYPE_SET_HSV, payload, 5, &ack);
+		} else if (!strcmp(argv[i], "rgb") && i + 3 < argc) {
+			for (j = 0; j < 3; j++)
+				payload[1 + j] = atoi(argv[i + 1 + j]);
+			ok = command(&l, FRAME_TYPE_SET_RGB, payload, 4, &ack);
+		} else if (!strcmp(argv[i], "mode")) {
+			payload[1] = 0;
+			for (j = i + 1; j < argc; j++)
+				payload[1] |= !strcmp(argv[j], "hw") ? CMD_MODE_HW_DETECT
+						: !strcmp(argv[j], "ab") ? CMD_MODE_AB : 0;
+			ok = command(&l, FRAME_TYPE_SET_MODE, payload, 2, &ack);
+		} else if (!strcmp(argv[i], "play") && i + 1 < argc) {
+			ncolors = read_csv(argv[i + 1], colors);
+			ok = ncolors != 0 && !stream(&l, colors, ncolors,
+					i + 2 < argc && !strcmp(argv[i + 2], "--loop"));
+		} else if (!strcmp(argv[i], "stop")) {
+			ok = command(&l, FRAME_TYPE_STOP, payload, 1, &ack);
+		} else {
+			usage(argv[0]);
+		}
+		close(l.fd);
+	}
+
+	if (l.commands)
+		printf("%u commands, %u retries, %u failed, ACK avg %.1f ms, "
+				"max %.1f ms\n", l.commands, l.retries, l.failed,
+				l.ack_time_sum / 1e3 / (l.commands - l.failed ? l.commands
+						- l.failed : 1), l.ack_time_max / 1e3);
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,153 @@
+/*
+ * duty_stress.c
+ *
+ *  Host stress test for the sequence locked duty cycle publication (see
+ *  software/src/duty_publish.h).  A writer publishes sets whose channels
+ *  all follow from one counter, so a reader can tell a torn snapshot from
+ *  a coherent one, while a reader takes snapshots as fast as it can.
+ *
+ *  Two writers are run in turn:
+ *      interrupt   a 20 us interval timer signal publishes on the reader's
+ *                  own thread, the way FIT_Handler preempts the main loop
+ *      thread      a second thread publishes flat out
+ *
+ *  Each is run against DUTY_Read() and against a plain copy of the same
+ *  fields.  DUTY_Read() must never return a torn set; the plain copy shows
+ *  the race is really being hit.  Exits non-zero on a torn DUTY_Read().
+ *
+ *  Build (Linux):
+ *      cc -O2 -Wall -pthread -Ihost -I../software/src -o duty_stress duty_stress.c ../software/src/duty_publish.c
+ *
+ *  Usage:
+ *      duty_stress [-t seconds_per_run]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include "duty_publish.h"
+
+#define TIMER_US			20
+
+static DutyPublisher pub;
+static volatile u32 counter;
+static volatile int stop;
+
+/*
+ * Every field follows from k, a torn read mixes two values of k
+ */
+static void publish_next(void) {
+	u32 k = ++counter % 100;
+	u8 duty[NUM_DUTY_CHANNELS];
+
+	duty[0] = k;
+	duty[1] = (k + 33) % 100;
+	duty[2] = (k + 66) % 100;
+	DUTY_Publish(&pub, duty, k & 7);
+}
+
+static int coherent(const u8 *duty, u8 saturated) {
+	return duty[1] == (duty[0] + 33) % 100 && duty[2] == (duty[0] + 66) % 100
+			&& saturated == (duty[0] & 7);
+}
+
+static void on_timer(int sig) {
+	publish_next();
+}
+
+static void *writer_thread(void *arg) {
+	while (!stop)
+		publish_next();
+	return NULL;
+}
+
+typedef struct {
+	u32		reads;
+	u32		torn;
+	u32		retries;
+	u32		seq_errors;			// odd or going backwards
+} Result;
+
+static void read_for(double seconds, int plain, Result *r) {
+	struct timeval start, now;
+	DutySnapshot snap;
+	u32 last_seq = 0;
+	u32 i;
+	u8 ch;
+
+	memset(r, 0, sizeof(*r));
+	gettimeofday(&start, NULL);
+	do {
+		// check the clock every 4096 reads only
+		for (i = 0; i < 4096; i++) {
+			if (plain) {
+				for (ch = 0; ch < NUM_DUTY_CHANNELS; ch++)
+					snap.duty[ch] = pub.duty[ch];
+				snap.saturated = pub.saturated;
+			} else {
+				r->retries += DUTY_Read(&pub, &snap);
+				if ((snap.seq & 1) || snap.seq < last_seq)
+					r->seq_errors++;
+				last_seq = snap.seq;
+			}
+			if (!coherent(snap.duty, snap.saturated))
+				r->torn++;
+		}
+		r->reads += 4096;
+		gettimeofday(&now, NULL);
+	} while ((now.tv_sec - start.tv_sec) + (now.tv_usec - start.tv_usec) * 1e-6
+			< seconds);
+}
+
+static void report(const char *name, const Result *r, u32 publishes) {
+	printf("  %-20s %10u reads %9u publishes %8u torn %8u retries %u seq errors\n",
+			name, r->reads, publishes, r->torn, r->retries, r->seq_errors);
+}
+
+int main(int argc, char **argv) {
+	struct itimerval timer = { { 0, TIMER_US }, { 0, TIMER_US } };
+	struct itimerval off = { { 0, 0 }, { 0, 0 } };
+	double seconds = 1.0;
+	pthread_t writer;
+	Result r;
+	u32 failures = 0;
+	u32 published;
+	int plain;
+
+	if (argc == 3 && !strcmp(argv[1], "-t"))
+		seconds = atof(argv[2]);
+
+	publish_next();
+	printf("duty publication stress, %.1f s per run\n", seconds);
+
+	signal(SIGALRM, on_timer);
+	for (plain = 1; plain >= 0; plain--) {
+		published = counter;
+		setitimer(ITIMER_REAL, &timer, NULL);
+		read_for(seconds, plain, &r);
+		setitimer(ITIMER_REAL, &off, NULL);
+		report(plain ? "interrupt, plain" : "interrupt, DUTY_Read", &r,
+				counter - published);
+		if (!plain)
+			failures += r.torn + r.seq_errors;
+	}
+
+	for (plain = 1; plain >= 0; plain--) {
+		published = counter;
+		stop = 0;
+		pthread_create(&writer, NULL, writer_thread, NULL);
+		read_for(seconds, plain, &r);
+		stop = 1;
+		pthread_join(writer, NULL);
+		report(plain ? "thread, plain" : "thread, DUTY_Read", &r,
+				counter - published);
+		if (!plain)
+			failures += r.torn + r.seq_errors;
+	}
+
+	printf("%s\n", failures ? "FAIL: DUTY_Read returned a torn snapshot" : "pass");
+	return failures != 0;
+}
@@ -0,0 +1,204 @@
+/*
+ * fmt_bench.c
+ *
+ *  Host check and microbenchmark for the display number formatting (see
+ *  software/src/num_format.h).  Compares every FMT_ routine against a copy
+ *  of PMDIO_itoa() and printf over the edge cases, all values up to 2^20
+ *  and a few million random ones, then times the conversions against the
+ *  divide loop in PMDIO_itoa().
+ *
+ *  The host has a fast divider, the MicroBlaze does not, so the speedup
+ *  here is a lower bound; RunFormatBenchmark() (-DFMT_BENCHMARK) gives the
+ *  target figures.  Exits non-zero on any mismatch.
+ *
+ *  Build (Linux):
+ *      cc -O2 -Wall -I../software/src -o fmt_bench fmt_bench.c ../software/src/num_format.c
+ *
+ *  Usage:
+ *      fmt_bench [-n random_values]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "num_format.h"
+
+#define BENCH_VALUES		1024
+#define BENCH_ROUNDS		2000
+
+static uint32_t rng_state = 0x12345678;
+static uint32_t mismatches;
+
+static uint32_t rng(void) {
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+	return rng_state;
+}
+
+/*
+ * PMDIO_itoa() as it is in the Nexys4IO driver: one divide and one
+ * modulo per digit.
+ */
+static void ref_itoa(int32_t value, char *string, int32_t radix) {
+	char tmp[33];
+	char *tp = tmp;
+	int32_t i;
+	uint32_t v;
+	int32_t sign;
+	char *sp;
+
+	sign = ((10 == radix) && (value < 0));
+	if (sign)
+		v = -(uint32_t) value;
+	else
+		v = (uint32_t) value;
+	while (v || tp == tmp) {
+		i = v % radix;
+		v = v / radix;
+		if (i < 10)
+			*tp++ = i + '0';
+		else
+			*tp++ = i + 'a' - 10;
+	}
+	sp = string;
+	if (sign)
+		*sp++ = '-';
+	while (tp > tmp)
+		*sp++ = *--tp;
+	*sp = 0;
+}
+
+static void check(const char *what, int32_t value, const char *got,
+		uint8_t len, const char *want) {
+	if (strcmp(got, want) == 0 && len == strlen(want))
+		return;
+	if (mismatches++ < 10)
+		printf("MISMATCH %s(%d): \"%s\" (%u) expected \"%s\"\n", what, value,
+				got, len, want);
+}
+
+static void check_value(int32_t value) {
+	char got[33], want[33];
+	uint8_t len;
+	uint8_t width;
+
+	ref_itoa(value, want, 10);
+	len = FMT_i32toa(value, got);
+	check("FMT_i32toa", value, got, len, want);
+	len = FMT_itoa(value, got, 10);
+	check("FMT_itoa 10", value, got, len, want);
+
+	if (value >= 0) {
+		len = FMT_u32toa((uint32_t) value, got);
+		check("FMT_u32toa", value, got, len, want);
+	}
+
+	ref_itoa(value, want, 16);
+	len = FMT_u32tohex((uint32_t) value, got, 0);
+	check("FMT_u32tohex", value, got, len, want);
+	len = FMT_itoa(value, got, 16);
+	check("FMT_itoa 16", value, got, len, want);
+
+	width = value & 7;
+	snprintf(want, sizeof(want), "%0*x", width, (uint32_t) value);
+	len = FMT_u32tohex((uint32_t) value, got, width);
+	check("FMT_u32tohex width", value, got, len, want);
+
+	snprintf(want, sizeof(want), "%*d", width, value);
+	len = FMT_i32toa_fixed(value, got, width, ' ');
+	check("FMT_i32toa_fixed ' '", value, got, len, want);
+	snprintf(want, sizeof(want), "%0*d", width, value);
+	len = FMT_i32toa_fixed(value, got, width, '0');
+	check("FMT_i32toa_fixed '0'", value, got, len, want);
+}
+
+static double seconds(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * Nanoseconds per conversion.  sink keeps the compiler from dropping the
+ * loops.
+ */
+static volatile char sink;
+
+static double time_ref(const int32_t *values, int32_t radix) {
+	char buf[33];
+	double start = seconds();
+	int r, n;
+
+	for (r = 0; r < BENCH_ROUNDS; r++)
+		for (n = 0; n < BENCH_VALUES; n++) {
+			ref_itoa(values[n], buf, radix);
+			sink = buf[0];
+		}
+	return (seconds() - start) * 1e9 / (BENCH_ROUNDS * BENCH_VALUES);
+}
+
+static double time_fmt(const int32_t *values, int32_t radix) {
+	char buf[33];
+	double start = seconds();
+	int r, n;
+
+	for (r = 0; r < BENCH_ROUNDS; r++)
+		for (n = 0; n < BENCH_VALUES; n++) {
+			if (radix == 10)
+				FMT_i32toa(values[n], buf);
+			else
+				FMT_u32tohex((uint32_t) values[n], buf, 0);
+			sink = buf[0];
+		}
+	return (seconds() - start) * 1e9 / (BENCH_ROUNDS * BENCH_VALUES);
+}
+
+int main(int argc, char **argv) {
+	static const int32_t edges[] = { 0, 1, 9, 10, 99, 100, 999, 1000,
+			65535, 65536, 99999999, 100000000, 999999999, 1000000000,
+			2147483647, -2147483647 - 1, -1, -9, -10, -99, -100 };
+	static int32_t display[BENCH_VALUES], wide[BENCH_VALUES];
+	uint32_t nrandom = 4000000;
+	uint32_t i;
+	double ref, fmt;
+
+	if (argc == 3 && !strcmp(argv[1], "-n"))
+		nrandom = strtoul(argv[2], NULL, 0);
+
+	for (i = 0; i < sizeof(edges) / sizeof(edges[0]); i++)
+		check_value(edges[i]);
+	for (i = 0; i < 1000000000; i = i < 10 ? i + 1 : i * 10) {
+		check_value(i - 1);
+		check_value(i + 1);
+		check_value(-(int32_t) i);
+	}
+	for (i = 0; i < (1UL << 20); i++) {
+		check_value(i);
+		check_value(-(int32_t) i);
+	}
+	for (i = 0; i < nrandom; i++)
+		check_value((int32_t) rng());
+	printf("format check: %u mismatches\n", mismatches);
+
+	// What the display paths print: 0 - 359 and 0 - 99, and full range counts
+	for (i = 0; i < BENCH_VALUES; i++) {
+		display[i] = rng() % 360;
+		wide[i] = (int32_t) rng();
+	}
+	printf("ns per conversion   PMDIO_itoa    FMT\n");
+	ref = time_ref(display, 10);
+	fmt = time_fmt(display, 10);
+	printf("  dec 0 - 359       %8.1f   %8.1f  (%.1fx)\n", ref, fmt, ref / fmt);
+	ref = time_ref(wide, 10);
+	fmt = time_fmt(wide, 10);
+	printf("  dec 32-bit        %8.1f   %8.1f  (%.1fx)\n", ref, fmt, ref / fmt);
+	ref = time_ref(wide, 16);
+	fmt = time_fmt(wide, 16);
+	printf("  hex 32-bit        %8.1f   %8.1f  (%.1fx)\n", ref, fmt, ref / fmt);
+
+	return mismatches != 0;
+}
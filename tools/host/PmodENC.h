@@ -0,0 +1,20 @@
+/*
+ * PmodENC.h
+ *
+ *  Host stand-in for the BSP header of the same name.  Declarations only.
+ */
+
+#ifndef PMODENC_H
+#define PMODENC_H
+
+#include "xil_types.h"
+
+typedef struct {
+	u32		GPIO_addr;
+} PmodENC;
+
+void ENC_begin(PmodENC *InstancePtr, u32 GPIO_Address);
+u32 ENC_getState(PmodENC *InstancePtr);
+bool ENC_buttonPressed(u32 state);
+
+#endif /* PMODENC_H */
@@ -0,0 +1,26 @@
+/*
+ * PmodOLEDrgb.h
+ *
+ *  Host stand-in for the BSP header of the same name.  Declarations only.
+ */
+
+#ifndef PMODOLEDRGB_H
+#define PMODOLEDRGB_H
+
+#include "xil_types.h"
+
+typedef struct {
+	u32		GPIO_addr;
+} PmodOLEDrgb;
+
+void OLEDrgb_begin(PmodOLEDrgb *InstancePtr, u32 GPIO_Address, u32 SPI_Address);
+void OLEDrgb_Clear(PmodOLEDrgb *InstancePtr);
+void OLEDrgb_SetCursor(PmodOLEDrgb *InstancePtr, u8 xch, u8 ych);
+void OLEDrgb_PutString(PmodOLEDrgb *InstancePtr, char *sz);
+void OLEDrgb_SetFontColor(PmodOLEDrgb *InstancePtr, u16 fontColor);
+void OLEDrgb_DrawRectangle(PmodOLEDrgb *InstancePtr, u8 c1, u8 r1, u8 c2,
+		u8 r2, u16 lineColor, bool bFill, u16 fillColor);
+u16 OLEDrgb_BuildRGB(u8 R, u8 G, u8 B);
+u16 OLEDrgb_BuildHSV(u8 hue, u8 sat, u8 val);
+
+#endif /* PMODOLEDRGB_H */
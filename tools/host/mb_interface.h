@@ -0,0 +1,17 @@
+/*
+ * mb_interface.h
+ *
+ *  Host stand-in for the BSP header of the same name.  The host programs
+ *  call the "interrupt handlers" themselves, there is nothing to mask.
+ */
+
+#ifndef MB_INTERFACE_H
+#define MB_INTERFACE_H
+
+static inline void microblaze_disable_interrupts(void) {
+}
+
+static inline void microblaze_enable_interrupts(void) {
+}
+
+#endif /* MB_INTERFACE_H */
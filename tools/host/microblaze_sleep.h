@@ -0,0 +1,13 @@
+/*
+ * microblaze_sleep.h
+ *
+ *  Host stand-in for the BSP header of the same name.  Never called by the modules built on the host.
+ */
+
+#ifndef MICROBLAZE_SLEEP_H
+#define MICROBLAZE_SLEEP_H
+
+void usleep(unsigned long useconds);
+void sleep(unsigned int seconds);
+
+#endif /* MICROBLAZE_SLEEP_H */
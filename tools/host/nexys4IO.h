@@ -0,0 +1,36 @@
+/*
+ * nexys4IO.h
+ *
+ *  Host stand-in for the BSP header of the same name.  The declarations
+ *  hw_interface.h needs, and xil_printf() as printf().
+ */
+
+#ifndef NEXYS4IO_H
+#define NEXYS4IO_H
+
+#include <stdio.h>
+#include "xil_types.h"
+#include "xstatus.h"
+
+#define xil_printf				printf
+
+enum { RGB1, RGB2 };
+
+#define BTNC					0x10
+#define BTNU					0x08
+#define BTND					0x04
+#define BTNL					0x02
+#define BTNR					0x01
+
+int NX4IO_initialize(u32 BaseAddr);
+u16 NX4IO_getSwitches(void);
+u32 NX4IO_getBtns(void);
+void NX4IO_setLEDs(u32 data);
+u32 NX4IO_getLEDS_DATA(void);
+void NX4IO_RGBLED_setChnlEn(u8 RGBSelect, bool RedEnable, bool GreenEnable,
+		bool BlueEnable);
+void NX4IO_RGBLED_setDutyCycle(u8 RGBSelect, u8 RedDC, u8 GreenDC, u8 BlueDC);
+void NX410_SSEG_setAllDigits(u32 SSEGSelect, u8 Dig3, u8 Dig2, u8 Dig1,
+		u8 Dig0, u8 DPMask);
+
+#endif /* NEXYS4IO_H */
@@ -0,0 +1,21 @@
+/*
+ * xgpio.h
+ *
+ *  Host stand-in for the BSP header of the same name.  Declarations only.
+ */
+
+#ifndef XGPIO_H
+#define XGPIO_H
+
+#include "xil_types.h"
+
+typedef struct {
+	UINTPTR	BaseAddress;
+} XGpio;
+
+int XGpio_Initialize(XGpio *InstancePtr, u16 DeviceId);
+void XGpio_SetDataDirection(XGpio *InstancePtr, unsigned Channel, u32 DirectionMask);
+u32 XGpio_DiscreteRead(XGpio *InstancePtr, unsigned Channel);
+void XGpio_DiscreteWrite(XGpio *InstancePtr, unsigned Channel, u32 Data);
+
+#endif /* XGPIO_H */
@@ -0,0 +1,20 @@
+/*
+ * xil_io.h
+ *
+ *  Host stand-in for the BSP header of the same name.  There are no
+ *  devices on the host, register accesses go nowhere.
+ */
+
+#ifndef XIL_IO_H
+#define XIL_IO_H
+
+#include "xil_types.h"
+
+static inline void Xil_Out32(UINTPTR Addr, u32 Value) {
+}
+
+static inline u32 Xil_In32(UINTPTR Addr) {
+	return 0;
+}
+
+#endif /* XIL_IO_H */
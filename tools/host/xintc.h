@@ -0,0 +1,16 @@
+/*
+ * xintc.h
+ *
+ *  Host stand-in for the BSP header of the same name.  Declarations only.
+ */
+
+#ifndef XINTC_H
+#define XINTC_H
+
+#include "xil_types.h"
+
+typedef struct {
+	UINTPTR	BaseAddress;
+} XIntc;
+
+#endif /* XINTC_H */
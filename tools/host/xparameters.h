@@ -0,0 +1,37 @@
+/*
+ * xparameters.h
+ *
+ *  Host stand-in for the BSP header of the same name.  The addresses and clocks
+ *  of the Nexys4 DDR design that the firmware headers use.
+ */
+
+#ifndef XPARAMETERS_H
+#define XPARAMETERS_H
+
+#include "xil_types.h"
+
+#define XPAR_CPU_CORE_CLOCK_FREQ_HZ						100000000
+#define XPAR_CPU_M_AXI_DP_FREQ_HZ						100000000
+#define XPAR_AXI_TIMER_0_DEVICE_ID						0
+#define XPAR_AXI_TIMER_0_BASEADDR						0x41C00000
+#define XPAR_AXI_TIMER_0_HIGHADDR						0x41C0FFFF
+#define XPAR_NEXYS4IO_0_DEVICE_ID						0
+#define XPAR_NEXYS4IO_0_S00_AXI_BASEADDR				0x44A00000
+#define XPAR_NEXYS4IO_0_S00_AXI_HIGHADDR				0x44A0FFFF
+#define XPAR_PMODOLEDRGB_0_DEVICE_ID					0
+#define XPAR_PMODOLEDRGB_0_AXI_LITE_GPIO_BASEADDR		0x44A10000
+#define XPAR_PMODOLEDRGB_0_AXI_LITE_GPIO_HIGHADD		0x44A1FFFF
+#define XPAR_PMODOLEDRGB_0_AXI_LITE_SPI_BASEADDR		0x44A20000
+#define XPAR_PMODOLEDRGB_0_AXI_LITE_SPI_HIGHADDR		0x44A2FFFF
+#define XPAR_PMODENC_0_DEVICE_ID						0
+#define XPAR_PMODENC_0_AXI_LITE_GPIO_BASEADDR			0x44A30000
+#define XPAR_PMODENC_0_AXI_LITE_GPIO_HIGHADDR			0x44A3FFFF
+#define XPAR_AXI_GPIO_0_DEVICE_ID						0
+#define XPAR_INTC_0_DEVICE_ID							0
+#define XPAR_INTC_0_BASEADDR							0x41200000
+#define XPAR_MICROBLAZE_0_AXI_INTC_FIT_TIMER_0_INTERRUPT_INTR	0
+#define XPAR_UARTLITE_0_DEVICE_ID						0
+#define XPAR_UARTLITE_0_BASEADDR						0x40600000
+#define STDOUT_BASEADDRESS								0x40600000
+
+#endif /* XPARAMETERS_H */
@@ -0,0 +1,15 @@
+/*
+ * xstatus.h
+ *
+ *  Host stand-in for the BSP header of the same name.  Status codes only.
+ */
+
+#ifndef XSTATUS_H
+#define XSTATUS_H
+
+#define XST_SUCCESS				0L
+#define XST_FAILURE				1L
+#define XST_DEVICE_NOT_FOUND	2L
+#define XST_INVALID_PARAM		15L
+
+#endif /* XSTATUS_H */
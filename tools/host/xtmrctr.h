@@ -0,0 +1,20 @@
+/*
+ * xtmrctr.h
+ *
+ *  Host stand-in for the BSP header of the same name.  The host program
+ *  supplies XTmrCtr_GetTimerCounterReg(), which is what TS_now() reads, so
+ *  it can run the firmware on a simulated clock.
+ */
+
+#ifndef XTMRCTR_H
+#define XTMRCTR_H
+
+#include "xil_types.h"
+
+typedef struct {
+	UINTPTR	BaseAddress;
+} XTmrCtr;
+
+u32 XTmrCtr_GetTimerCounterReg(UINTPTR BaseAddress, u8 TimerNumber);
+
+#endif /* XTMRCTR_H */
@@ -0,0 +1,22 @@
+/*
+ * xuartlite_l.h
+ *
+ *  Host stand-in for the BSP header of the same name.  The host program
+ *  supplies the register reads, so it can feed the receive FIFO itself.
+ */
+
+#ifndef XUARTLITE_L_H
+#define XUARTLITE_L_H
+
+#include "xil_types.h"
+
+#define XUL_RX_FIFO_OFFSET			0
+#define XUL_SR_RX_FIFO_VALID_DATA	0x01
+#define XUL_SR_OVERRUN_ERROR		0x20
+
+u32 XUartLite_ReadReg(UINTPTR BaseAddress, u32 RegOffset);
+u32 XUartLite_GetStatusReg(UINTPTR BaseAddress);
+
+#define XUartLite_EnableIntr(BaseAddress)
+
+#endif /* XUARTLITE_L_H */
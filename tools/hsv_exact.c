@@ -0,0 +1,117 @@
+/*
+ * hsv_exact.c
+ *
+ *  Host check that hardware/hsv2rgb.v converts bit for bit the same as
+ *  HSVtoRGB() in the firmware (software/src/functional_interface.c), so
+ *  hsv_pwm_axi and the software path show the same color.  rtl_hsv2rgb()
+ *  below follows the pipeline stage by stage and keeps every intermediate
+ *  to the width of the register or expression it comes from in the RTL.
+ *
+ *  Every hue 0 - 511 (360 - 511 wrap once) is checked with every sat and
+ *  val 0 - 100 against HSVtoRGB(), and sat or val 101 - 127, which the RTL
+ *  clamps, against the result for 100.  Exits non-zero on any difference.
+ *
+ *  Only HSVtoRGB() is linked out of functional_interface.c, the linker
+ *  drops the rest with its BSP calls (see the Makefile).
+ *
+ *  Build (Linux):
+ *      cc -O2 -Wall -fcommon -ffunction-sections -fdata-sections -Wl,--gc-sections \
+ *          -Ihost -I../software/src -o hsv_exact hsv_exact.c ../software/src/functional_interface.c
+ *
+ *  Usage:
+ *      hsv_exact
+ */
+
+#include <stdio.h>
+#include "functional_interface.h"
+
+#define BITS(x, n)			((x) & ((1UL << (n)) - 1))
+
+// mul_div255() in hsv2rgb.v
+static u32 mul_div255(u32 a, u32 b) {
+	u32 x = BITS(a * b, 16);
+	u32 y = BITS(x + 1 + (x >> 8), 17);
+
+	return BITS(y >> 8, 8);
+}
+
+/*
+ * hsv2rgb.v, one conversion through the six stages
+ */
+static void rtl_hsv2rgb(u32 hue, u32 sat, u32 val, u8 *R, u8 *G, u8 *B) {
+	u32 hue1, sat1, val1, s2, v2, region2, rem3, p3, srem4, srem_n4, q5, t5;
+
+	hue = BITS(hue, 9);
+	sat = BITS(sat, 7);
+	val = BITS(val, 7);
+
+	// 1: clamp
+	hue1 = hue >= 360 ? BITS(hue - 360, 9) : hue;
+	sat1 = sat > 100 ? 100 : sat;
+	val1 = val > 100 ? 100 : val;
+
+	// 2: 0 - 100 to 0 - 255, hue / 60
+	s2 = BITS(BITS(sat1 * 653, 16) >> 8, 8);
+	v2 = BITS(BITS(val1 * 653, 16) >> 8, 8);
+	region2 = BITS(BITS(hue1 * 1093, 19) >> 16, 3);
+
+	// 3
+	rem3 = BITS(BITS(BITS(hue1 - region2 * 60, 16) * 1105, 16) >> 8, 8);
+	p3 = mul_div255(v2, BITS(255 - s2, 8));
+
+	// 4
+	srem4 = mul_div255(s2, rem3);
+	srem_n4 = mul_div255(s2, BITS(255 - rem3, 8));
+
+	// 5
+	q5 = mul_div255(v2, BITS(255 - srem4, 8));
+	t5 = mul_div255(v2, BITS(255 - srem_n4, 8));
+
+	// 6: pick by sextant
+	switch (region2) {
+	case 0:
+		*R = v2; *G = t5; *B = p3;
+		break;
+	case 1:
+		*R = q5; *G = v2; *B = p3;
+		break;
+	case 2:
+		*R = p3; *G = v2; *B = t5;
+		break;
+	case 3:
+		*R = p3; *G = q5; *B = v2;
+		break;
+	case 4:
+		*R = t5; *G = p3; *B = v2;
+		break;
+	default:
+		*R = v2; *G = p3; *B = q5;
+		break;
+	}
+}
+
+int main(int argc, char **argv) {
+	u32 hue, sat, val, checked = 0, errors = 0;
+	u8 r, g, b, R, G, B;
+
+	for (hue = 0; hue < 512; hue++) {
+		for (sat = 0; sat < 128; sat++) {
+			for (val = 0; val < 128; val++) {
+				rtl_hsv2rgb(hue, sat, val, &r, &g, &b);
+				HSVtoRGB(hue, sat > 100 ? 100 : sat, val > 100 ? 100 : val,
+						&R, &G, &B);
+				checked++;
+				if (r != R || g != G || b != B) {
+					if (errors++ < 10)
+						printf("  hsv %u %u %u: hsv2rgb %u %u %u, HSVtoRGB %u %u %u\n",
+								hue, sat, val, r, g, b, R, G, B);
+				}
+			}
+		}
+	}
+
+	printf("hsv2rgb against HSVtoRGB: %u colors, %u different\n", checked,
+			errors);
+	printf("%s\n", errors ? "FAIL" : "pass");
+	return errors != 0;
+}
@@ -0,0 +1,427 @@
+/*
+ * tlm_decode.c
+ *
+ *  Host side decoder for the binary telemetry stream (see
+ *  software/src/telemetry.h).  Reads frames from the board's USB-UART, a
+ *  capture file or stdin, prints detector error, settling latency and loop
+ *  timing statistics and optionally writes every sample to a CSV file.
+ *  The latency benchmark and A/B results, sent as frames while the UART
+ *  carries telemetry or commands, are printed as they arrive.
+ *
+ *  --loopback generates a synthetic stream, complete with interleaved text
+ *  and corrupted frames, and runs it through the same decoder so the tool
+ *  can be checked without a board.
+ *
+ *  Build (Linux):
+ *      cc -O2 -Wall -I../software/src -o tlm_decode tlm_decode.c ../software/src/frame_codec.c
+ *
+ *  Usage:
+ *      tlm_decode [-d /dev/ttyUSB1] [-b 115200] [-o samples.csv] [-c clock_hz]
+ *                 [-t tolerance] [-n max_samples]
+ *      tlm_decode --loopback [-n samples] [-o samples.csv]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include "frame_codec.h"
+
+#define NUM_CHANNELS		3
+#define NUM_DETECTORS		2		// 0 - software, 1 - hardware
+
+static const char *detector_name[NUM_DETECTORS] = { "SW", "HW" };
+static const char *channel_name[NUM_CHANNELS] = { "R", "G", "B" };
+
+typedef struct {
+	uint32_t	n;
+	uint64_t	sum;
+	uint32_t	min;
+	uint32_t	max;
+} Stat;
+
+typedef struct {
+	double		clock_hz;
+	int			tolerance;
+	FILE		*csv;
+
+	int			have_prev;
+	uint32_t	prev_seq;
+	uint32_t	prev_ts;
+	uint64_t	time;				// unwrapped timestamp, clock ticks
+	uint64_t	first_time;
+	uint8_t		prev_cmd[NUM_CHANNELS];
+
+	uint32_t	samples;
+	uint32_t	missing;			// gaps in the sequence numbers
+	Stat		error[NUM_DETECTORS][NUM_CHANNELS];
+	Stat		latency[NUM_DETECTORS];		// microseconds
+	uint32_t	unsettled[NUM_DETECTORS];
+	int			pending[NUM_DETECTORS];	// waiting for the detector to settle
+	int			timed;						// the change is not the first sample
+	uint64_t	change_time;
+	uint64_t	loops;
+	uint32_t	loop_max;
+} Analyzer;
+
+static void stat_add(Stat *s, uint32_t v) {
+	if (s->n == 0 || v < s->min)
+		s->min = v;
+	if (v > s->max)
+		s->max = v;
+	s->sum += v;
+	s->n++;
+}
+
+static double stat_avg(const Stat *s) {
+	return s->n ? (double) s->sum / s->n : 0.0;
+}
+
+/*
+ * Duty cycle (%) the detectors should report for a commanded 0 - 255 value.
+ * The firmware caps duty at 99 for the two digit display.
+ */
+static int expected_duty(uint8_t cmd) {
+	int duty = (cmd * 100 + 127) / 255;
+	return duty > 99 ? 99 : duty;
+}
+
+static int settled(const Analyzer *a, const uint8_t *cmd, const uint8_t *duty) {
+	int ch;
+
+	for (ch = 0; ch < NUM_CHANNELS; ch++)
+		if (abs((int) duty[ch] - expected_duty(cmd[ch])) > a->tolerance)
+			return 0;
+	return 1;
+}
+
+static void analyze(Analyzer *a, const TelemetryRecord *rec) {
+	const uint8_t *duty[NUM_DETECTORS] = { rec->sw_duty, rec->hw_duty };
+	double us_per_tick = 1e6 / a->clock_hz;
+	int det, ch;
+
+	if (a->have_prev) {
+		a->missing += rec->seq - a->prev_seq - 1;
+		a->time += (uint32_t) (rec->timestamp - a->prev_ts);
+	} else {
+		a->first_time = a->time;
+	}
+
+	// A new command restarts the settling measurement for both detectors
+	if (!a->have_prev || memcmp(rec->cmd, a->prev_cmd, NUM_CHANNELS) != 0) {
+		for (det = 0; det < NUM_DETECTORS; det++) {
+			if (a->timed && a->pending[det])
+				a->unsettled[det]++;
+			a->pending[det] = 1;
+		}
+		a->timed = a->have_prev;
+		a->change_time = a->time;
+		memcpy(a->prev_cmd, rec->cmd, NUM_CHANNELS);
+	}
+
+	for (det = 0; det < NUM_DETECTORS; det++) {
+		if (a->pending[det] && settled(a, rec->cmd, duty[det])) {
+			if (a->timed)
+				stat_add(&a->latency[det],
+						(uint32_t) ((a->time - a->change_time) * us_per_tick));
+			a->pending[det] = 0;
+		}
+		// Error only counts once the detector has caught up with the command
+		if (!a->pending[det])
+			for (ch = 0; ch < NUM_CHANNELS; ch++)
+				stat_add(&a->error[det][ch],
+						abs((int) duty[det][ch] - expected_duty(rec->cmd[ch])));
+	}
+
+	if (a->have_prev)
+		a->loops += rec->loops;
+	if (rec->loop_max > a->loop_max)
+		a->loop_max = rec->loop_max;
+
+	if (a->csv)
+		fprintf(a->csv, "%u,%.1f,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%.1f\n",
+				rec->seq, (a->time - a->first_time) * us_per_tick,
+				rec->cmd[0], rec->cmd[1], rec->cmd[2],
+				rec->sw_duty[0], rec->sw_duty[1], rec->sw_duty[2],
+				rec->hw_duty[0], rec->hw_duty[1], rec->hw_duty[2],
+				rec->flags, rec->loops, rec->loop_max * us_per_tick);
+
+	a->prev_seq = rec->seq;
+	a->prev_ts = rec->timestamp;
+	a->have_prev = 1;
+	a->samples++;
+}
+
+static void report(const Analyzer *a, const FrameDecoder *dec) {
+	double secs = (a->time - a->first_time) / a->clock_hz;
+	int det, ch;
+
+	printf("frames %u, crc errors %u, bytes skipped %u, samples missing %u\n",
+			dec->frames, dec->crc_errors, dec->skipped, a->missing);
+	printf("duration %.2f s\n", secs);
+	printf("\nabsolute error vs commanded duty (%%), after settling\n");
+	for (det = 0; det < NUM_DETECTORS; det++) {
+		printf("  %s:", detector_name[det]);
+		for (ch = 0; ch < NUM_CHANNELS; ch++)
+			printf("  %s avg %.2f max %u", channel_name[ch],
+					stat_avg(&a->error[det][ch]), a->error[det][ch].max);
+		printf("\n");
+	}
+	printf("\nsettling latency after a color change (within +/-%d%%)\n",
+			a->tolerance);
+	for (det = 0; det < NUM_DETECTORS; det++)
+		printf("  %s: %u changes, min %u us, avg %.0f us, max %u us, "
+				"never settled %u\n", detector_name[det], a->latency[det].n,
+				a->latency[det].min, stat_avg(&a->latency[det]),
+				a->latency[det].max, a->unsettled[det]);
+	printf("\nmain loop: %.0f passes/s, longest pass %.1f us\n",
+			secs > 0 ? a->loops / secs : 0.0, a->loop_max * 1e6 / a->clock_hz);
+}
+
+static void print_latency(const LatencyRecord *lat) {
+	const char *det = lat->detector < NUM_DETECTORS ?
+			detector_name[lat->detector] : "?";
+
+	// The firmware sends each detector's steps to full off/on right after
+	// its summary
+	if (lat->source == LATENCY_SOURCE_BENCH_SAT)
+		printf("  to full off/on: %u settled, min %u us, avg %u us, max %u us\n",
+				lat->count, lat->min_us, lat->avg_us, lat->max_us);
+	else
+		printf("%s %s: %u settled, %u unchanged, %u timed out, "
+				"min %u us, avg %u us, max %u us\n",
+				lat->source == LATENCY_SOURCE_AB ? "A/B" : "benchmark", det,
+				lat->count, lat->unchanged, lat->timeouts, lat->min_us,
+				lat->avg_us, lat->max_us);
+}
+
+static void print_ab(const AbRecord *ab) {
+	printf("A/B: %u comparisons, %u disagree by more than %u%% (R %u G %u B %u), "
+			"CPU SW %.1f%% HW %.1f%%\n", ab->comparisons, ab->disagreements,
+			ab->tolerance, ab->channel[0], ab->channel[1], ab->channel[2],
+			ab->cpu_permille[0] / 10.0, ab->cpu_permille[1] / 10.0);
+}
+
+static void feed(Analyzer *a, FrameDecoder *dec, const uint8_t *buf,
+		size_t len) {
+	TelemetryRecord rec;
+	LatencyRecord lat;
+	AbRecord ab;
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		if (!FRAME_DecodeByte(dec, buf[i]))
+			continue;
+		if (dec->type == FRAME_TYPE_TELEMETRY
+				&& FRAME_UnpackTelemetry(dec->payload, dec->len, &rec) == 0)
+			analyze(a, &rec);
+		else if (dec->type == FRAME_TYPE_LATENCY
+				&& FRAME_UnpackLatency(dec->payload, dec->len, &lat) == 0)
+			print_latency(&lat);
+		else if (dec->type == FRAME_TYPE_AB
+				&& FRAME_UnpackAb(dec->payload, dec->len, &ab) == 0)
+			print_ab(&ab);
+	}
+}
+
+/*
+ * Stand-in for the board: a command that steps every 50 samples, a software
+ * detector that lags 3 samples and a hardware detector that lags 1, text
+ * between some frames and a flipped bit in every 97th frame.  Ends with
+ * the benchmark and A/B results a run would send.
+ */
+static void loopback(Analyzer *a, FrameDecoder *dec, uint32_t nsamples) {
+	const char text[] = "LED's R=12,G=200,B=7\n";
+	uint8_t history[4][NUM_CHANNELS];
+	uint8_t payload[TLM_PAYLOAD_SIZE];
+	uint8_t lat_payload[LATENCY_PAYLOAD_SIZE];
+	uint8_t ab_payload[AB_PAYLOAD_SIZE];
+	uint8_t frame[FRAME_MAX_SIZE];
+	TelemetryRecord rec;
+	LatencyRecord lat;
+	AbRecord ab;
+	uint32_t corrupted = 0;
+	uint16_t len;
+	uint32_t i;
+	int ch, duty;
+
+	memset(&rec, 0, sizeof(rec));
+	memset(history, 0, sizeof(history));
+	srand(544);
+	for (i = 0; i < nsamples; i++) {
+		if (i % 50 == 0)
+			for (ch = 0; ch < NUM_CHANNELS; ch++)
+				rec.cmd[ch] = rand() & 0xFF;
+		memmove(history[1], history[0], sizeof(history) - sizeof(history[0]));
+		memcpy(history[0], rec.cmd, NUM_CHANNELS);
+		for (ch = 0; ch < NUM_CHANNELS; ch++) {
+			duty = expected_duty(history[3][ch]) + (rand() % 3) - 1;
+			rec.sw_duty[ch] = duty < 0 ? 0 : duty;
+			rec.hw_duty[ch] = expected_duty(history[1][ch]);
+		}
+		rec.seq = i;
+		rec.timestamp += (uint32_t) (a->clock_hz / 20);	// 20 Hz
+		rec.loops = 2000 + rand() % 100;
+		rec.loop_max = 20000 + rand() % 5000;
+
+		FRAME_PackTelemetry(&rec, payload);
+		len = FRAME_Encode(FRAME_TYPE_TELEMETRY, payload, TLM_PAYLOAD_SIZE,
+				frame);
+		if (i % 97 == 96) {
+			frame[4 + rand() % TLM_PAYLOAD_SIZE] ^= 1 << (rand() % 8);
+			corrupted++;
+		}
+		feed(a, dec, frame, len);
+		if (i % 10 == 5)
+			feed(a, dec, (const uint8_t *) text, sizeof(text) - 1);
+	}
+	printf("loopback: %u samples generated, %u corrupted\n\n", nsamples,
+			corrupted);
+
+	for (i = 0; i < 2 * NUM_DETECTORS; i++) {
+		lat.source = i % 2 ? LATENCY_SOURCE_BENCH_SAT : LATENCY_SOURCE_BENCH;
+		lat.detector = i / 2;
+		lat.count = i % 2 ? 8 : 36;
+		lat.unchanged = i % 2 ? 0 : 4;
+		lat.timeouts = 0;
+		lat.min_us = lat.detector ? 1800 : 5200;
+		lat.avg_us = lat.min_us * 2;
+		lat.max_us = lat.min_us * 3;
+		FRAME_PackLatency(&lat, lat_payload);
+		len = FRAME_Encode(FRAME_TYPE_LATENCY, lat_payload,
+				LATENCY_PAYLOAD_SIZE, frame);
+		feed(a, dec, frame, len);
+	}
+
+	ab.comparisons = nsamples;
+	ab.disagreements = nsamples / 25;
+	ab.channel[0] = ab.channel[1] = ab.channel[2] = nsamples / 40;
+	ab.tolerance = 2;
+	ab.cpu_permille[0] = 312;
+	ab.cpu_permille[1] = 4;
+	FRAME_PackAb(&ab, ab_payload);
+	len = FRAME_Encode(FRAME_TYPE_AB, ab_payload, AB_PAYLOAD_SIZE, frame);
+	feed(a, dec, frame, len);
+	for (i = 0; i < NUM_DETECTORS; i++) {
+		lat.source = LATENCY_SOURCE_AB;
+		lat.detector = i;
+		lat.count = nsamples / 50 - 1;
+		lat.unchanged = 1;
+		lat.timeouts = 0;
+		lat.min_us = i ? 1800 : 5200;
+		lat.avg_us = lat.min_us * 2;
+		lat.max_us = lat.min_us * 3;
+		FRAME_PackLatency(&lat, lat_payload);
+		len = FRAME_Encode(FRAME_TYPE_LATENCY, lat_payload,
+				LATENCY_PAYLOAD_SIZE, frame);
+		feed(a, dec, frame, len);
+	}
+	printf("\n");
+}
+
+static int open_serial(const char *dev, int baud) {
+	struct termios tio;
+	speed_t speed;
+	int fd;
+
+	fd = open(dev, O_RDONLY | O_NOCTTY);
+	if (fd < 0) {
+		perror(dev);
+		return -1;
+	}
+	if (!isatty(fd))
+		return fd;
+
+	switch (baud) {
+	case 9600:		speed = B9600;		break;
+	case 57600:		speed = B57600;		break;
+	case 230400:	speed = B230400;	break;
+	case 115200:
+	default:		speed = B115200;	break;
+	}
+	tcgetattr(fd, &tio);
+	cfmakeraw(&tio);
+	cfsetispeed(&tio, speed);
+	cfsetospeed(&tio, speed);
+	tio.c_cc[VMIN] = 1;
+	tio.c_cc[VTIME] = 0;
+	tcsetattr(fd, TCSANOW, &tio);
+	return fd;
+}
+
+static void usage(const char *prog) {
+	fprintf(stderr,
+			"usage: %s [-d device|file|-] [-b baud] [-o csv] [-c clock_hz]\n"
+			"          [-t tolerance] [-n samples] [--loopback]\n", prog);
+	exit(2);
+}
+
+int main(int argc, char **argv) {
+	const char *dev = "/dev/ttyUSB1";
+	const char *csv = NULL;
+	int baud = 115200;
+	int use_loopback = 0;
+	uint32_t max_samples = 0;
+	Analyzer a;
+	FrameDecoder dec;
+	uint8_t buf[256];
+	ssize_t n;
+	int fd, i;
+
+	memset(&a, 0, sizeof(a));
+	a.clock_hz = 100e6;
+	a.tolerance = 2;
+
+	for (i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--loopback"))
+			use_loopback = 1;
+		else if (i + 1 >= argc)
+			usage(argv[0]);
+		else if (!strcmp(argv[i], "-d"))
+			dev = argv[++i];
+		else if (!strcmp(argv[i], "-b"))
+			baud = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-o"))
+			csv = argv[++i];
+		else if (!strcmp(argv[i], "-c"))
+			a.clock_hz = atof(argv[++i]);
+		else if (!strcmp(argv[i], "-t"))
+			a.tolerance = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-n"))
+			max_samples = strtoul(argv[++i], NULL, 0);
+		else
+			usage(argv[0]);
+	}
+
+	if (csv) {
+		a.csv = fopen(csv, "w");
+		if (!a.csv) {
+			perror(csv);
+			return 1;
+		}
+		fprintf(a.csv, "seq,time_us,cmd_r,cmd_g,cmd_b,sw_r,sw_g,sw_b,"
+				"hw_r,hw_g,hw_b,flags,loops,loop_max_us\n");
+	}
+	FRAME_DecoderInit(&dec);
+
+	if (use_loopback) {
+		loopback(&a, &dec, max_samples ? max_samples : 2000);
+	} else {
+		fd = strcmp(dev, "-") ? open_serial(dev, baud) : STDIN_FILENO;
+		if (fd < 0)
+			return 1;
+		while ((n = read(fd, buf, sizeof(buf))) > 0) {
+			feed(&a, &dec, buf, n);
+			if (max_samples && a.samples >= max_samples)
+				break;
+		}
+	}
+
+	report(&a, &dec);
+	if (a.csv)
+		fclose(a.csv);
+	return 0;
+}